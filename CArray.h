@@ -1,82 +1,324 @@
 #pragma once
-#pragma once
 
 #include <memory>
 #include <type_traits>
 #include <utility>
 #include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <iterator>
 
+#include "CArrayParallel.h"
+#include "CArrayNuma.h"
+#include "CArrayReclaimer.h"
+#include "CArrayStatistics.h"
+#include "CArrayCapacityAdvisor.h"
+#include "CArrayView.h"
+#include "CArraySort.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CArrayDefaultPolicy - политика хранения данных массива по умолчанию
+struct CArrayDefaultPolicy
+{
+  // Копии массива разделяют общий буфер до первого изменения (copy-on-write)
+  static constexpr bool copyOnWrite = false;
+
+  // Вести счетчики выделений памяти и перемещений элементов (CArrayStatistics.h)
+  static constexpr bool collectStatistics = false;
+
+  // Увеличивать буфер без единовременного переноса элементов: старый буфер
+  // сохраняется, а элементы переносятся порциями при последующих добавлениях
+  static constexpr bool incrementalGrowth = false;
+
+  // Количество элементов, переносимых при каждом добавлении (не меньше 2,
+  // чтобы перенос завершался до следующего увеличения буфера)
+  static constexpr unsigned int incrementalGrowthStep = 4;
+
+  // Массив, созданный с местом CArrayCapacitySite, сразу выделяет емкость
+  // по истории размеров массивов этого места (CArrayCapacityAdvisor.h)
+  static constexpr bool capacityAdvisor = false;
+
+  // Размещение больших буферов по узлам NUMA с параллельным первым
+  // обращением и переносом элементов (CArrayNuma.h)
+  static constexpr CArrayNumaPlacement numaPlacement = CArrayNumaPlacement::none;
+
+  // Узел для CArrayNumaPlacement::local
+  static constexpr unsigned int numaNode = 0;
+
+  // clear() и erase() не разрушают элементы, а оставляют их за концом
+  // массива; push_back присваивает значение такому элементу, сохраняя
+  // выделенную им память. Разрушение - в shrink_to_fit() и деструкторе.
+  static constexpr bool recycleElements = false;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CArrayCopyOnWritePolicy - копии массива разделяют буфер со счетчиком
+// ссылок, отделение копии выполняется при первом изменяющем вызове
+struct CArrayCopyOnWritePolicy : CArrayDefaultPolicy
+{
+  static constexpr bool copyOnWrite = true;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CArrayStatisticsPolicy - массив ведет счетчики работы с памятью,
+// доступные через statistics() и реестр потока CArrayStatisticsRegistry
+struct CArrayStatisticsPolicy : CArrayDefaultPolicy
+{
+  static constexpr bool collectStatistics = true;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CArrayIncrementalGrowthPolicy - добавление элемента выполняется за
+// ограниченное время: при увеличении буфера элементы не переносятся сразу,
+// обращение по индексу направляется в буфер, где элемент находится сейчас
+struct CArrayIncrementalGrowthPolicy : CArrayDefaultPolicy
+{
+  static constexpr bool incrementalGrowth = true;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CArrayCapacityAdvisorPolicy - начальная емкость массива берется
+// из прогноза места создания, итоговый размер учитывается при разрушении
+struct CArrayCapacityAdvisorPolicy : CArrayDefaultPolicy
+{
+  static constexpr bool capacityAdvisor = true;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CArrayRecyclingPolicy - удаленные элементы сохраняются для
+// повторного использования (например, строки с их памятью)
+struct CArrayRecyclingPolicy : CArrayDefaultPolicy
+{
+  static constexpr bool recycleElements = true;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CArrayNumaInterleavedPolicy - страницы больших буферов распределяются
+// поочередно по всем узлам NUMA
+struct CArrayNumaInterleavedPolicy : CArrayDefaultPolicy
+{
+  static constexpr CArrayNumaPlacement numaPlacement = CArrayNumaPlacement::interleaved;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CArrayNumaLocalPolicy - страницы больших буферов размещаются на узле
+// NUMA с номером node
+template <unsigned int node>
+struct CArrayNumaLocalPolicy : CArrayDefaultPolicy
+{
+  static constexpr CArrayNumaPlacement numaPlacement = CArrayNumaPlacement::local;
+  static constexpr unsigned int        numaNode      = node;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CArrayNumaPartitionedPolicy - большие буферы делятся на части по
+// числу узлов NUMA, соответствующие частям параллельных алгоритмов
+struct CArrayNumaPartitionedPolicy : CArrayDefaultPolicy
+{
+  static constexpr CArrayNumaPlacement numaPlacement = CArrayNumaPlacement::partitioned;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CArrayGrowthState - старый буфер, элементы которого еще не перенесены
+// (только для политик с incrementalGrowth)
+template <typename TItemType, bool enabled>
+struct CArrayGrowthState
+{
+};
+
+//----------------------------------------------------------------------------//
+template <typename TItemType>
+struct CArrayGrowthState<TItemType, true>
+{
+  TItemType *  m_oldBuf      = nullptr;  //< Старый буфер
+  unsigned int m_oldCapacity = 0;        //< Емкость старого буфера
+  unsigned int m_migrateFrom = 0;        //< Первый непереносенный элемент
+  unsigned int m_migrateTo   = 0;        //< Граница непереносенных элементов
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CArrayRecycleState - количество сохраненных для повторного
+// использования элементов за концом массива (только для политик
+// с recycleElements и типов с нетривиальным деструктором)
+template <bool enabled>
+struct CArrayRecycleState
+{
+};
+
+//----------------------------------------------------------------------------//
+template <>
+struct CArrayRecycleState<true>
+{
+  unsigned int m_recycled = 0;  //< Созданные объекты [size, size + m_recycled)
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CArrayShareState - счетчик владельцев разделяемого буфера
+// (только для политик с copyOnWrite)
+template <bool enabled>
+struct CArrayShareState
+{
+};
+
+//----------------------------------------------------------------------------//
+template <>
+struct CArrayShareState<true>
+{
+  std::atomic<unsigned int> * m_refCounter = nullptr;  //< Счетчик владельцев буфера
+};
+
 ///////////////////////////////////////////////////////////////////////////////
-template <typename TData, typename TAllocator = std::allocator<TData>>
-class CArray
+template <typename TData,
+          typename TAllocator = std::allocator<TData>,
+          typename TPolicy    = CArrayDefaultPolicy>
+class CArray : private CArrayCapacitySiteLink<TPolicy::capacityAdvisor>
 {
 public: // Interface
 
-  //   
+  // Конструктор по умолчанию
   CArray();
 
-  //  
+  // Конструктор с местом создания: емкость выделяется по прогнозу места,
+  // итоговый размер учитывается в его истории (только для политик
+  // с capacityAdvisor)
+  explicit CArray(
+      CArrayCapacitySite & _site
+    );
+
+  // Копирующий конструктор
   CArray(
       const CArray & _array
     );
 
-  //  
+  // Перемещающий конструктор
   CArray(
       CArray && _array
     );
 
-  // 
+  // Деструктор
   ~CArray();
 
-  //     
+  // Копирующее присваивание
+  CArray & operator=(
+      const CArray & _array
+    );
+
+  // Перемещающее присваивание
+  CArray & operator=(
+      CArray && _array
+    );
+
+  // Добавить элемент в конец массива
   void push_back(
       const TData & _value
     );
 
-  //     
+  // Сконструировать элемент в конец массива
   template <typename T>
   void emplace_back(
       T&& _value
     );
 
-  //     
+  // Сконструировать элемент в конец массива
   template <class... Args>
   void emplace_back(
       Args&&... args
     );
 
-  //       
+  // Добавить элемент в массив по заданному индексу
   void insert(
       unsigned int  _index,
       const TData & _value
     );
 
-  //      
+  // Вставить набор элементов за один проход. Позиции задаются
+  // относительно исходного массива (0..size()), значения не должны ссылаться
+  // на элементы этого массива. TPositions и TValues - контейнеры одного
+  // размера с доступом по индексу.
+  template <typename TPositions, typename TValues>
+  void insert_many(
+      const TPositions & _positions,
+      const TValues &    _values
+    );
+
+  // Удалить элемент массива по заданному индексу
   void erase(
       unsigned int _index
     );
 
-  //  
+  // Очистить массив
   void clear();
 
-  //   
+  // Получить размер массива
   unsigned int size() const;
 
-  //    
+  // Зарезервировать память под заданное количество элементов
+  void reserve(
+      unsigned int _capacity
+    );
+
+  // Получить количество элементов, под которые выделена память
+  unsigned int capacity() const;
+
+  // Получить счетчики работы массива с памятью (только для политик
+  // с collectStatistics)
+  const CArrayStatistics & statistics() const;
+
+  // Определить что массив пустой
   bool empty() const;
 
-  //      
+  // Получить элемент массива по заданному индексу
   TData & operator[](
       unsigned int _index
     );
 
-  //      
+  // Получить элемент массива по заданному индексу
   const TData & operator[](
       unsigned int _index
     ) const;
 
-  // 
+  // Получить представление элементов [_indexFrom, _indexTo) без копирования.
+  // Представление действительно, пока массив существует и не перевыделяет
+  // буфер (при _DEBUG нарушение проверяется при обращении). При перемещении
+  // массива представления переходят к массиву, получившему буфер.
+  // При incrementalGrowth недоступно: незавершенный перенос элементов
+  // доводит до конца только изменяемый subview(), результат которого
+  // приводится к CArrayView.
+  CArrayView<TData> subview(
+      unsigned int _indexFrom,
+      unsigned int _indexTo
+    ) const;
+
+  // Получить изменяемое представление элементов [_indexFrom, _indexTo)
+  CArraySlice<TData> subview(
+      unsigned int _indexFrom,
+      unsigned int _indexTo
+    );
+
+  // Получить представление всего массива
+  operator CArrayView<TData>() const;
+
+  // Освободить неиспользуемую память: емкость уменьшается до размера,
+  // сохраненные для повторного использования элементы разрушаются
+  void shrink_to_fit();
+
+  // Освободить массив в фоновом потоке CArrayReclaimer::instance():
+  // вызывающий поток только забирает буфер. При заполненной очереди
+  // массив освобождается сразу. CArrayReclaimer::instance().drain()
+  // дожидается освобождения всех переданных массивов.
+  static void destroy_async(
+      CArray && _array
+    );
+
+  // Упорядочить элементы по возрастанию. Целые и вещественные числа
+  // сортируются поразрядно (CArraySort.h) с временным буфером из
+  // распределителя массива, std::string - по кэшированным префиксам,
+  // остальные типы - сравнением через operator<.
+  void sort();
+
+  // Итераторы
   template <typename ContainerType, typename DataType>
   class iterator_base
   {
@@ -89,7 +331,9 @@ public: // Interface
     using value_type        = DataType;
     using pointer           = DataType *;
     using reference         = DataType &;
-    using iterator_category = std::bidirectional_iterator_tag;
+    using iterator_category = std::random_access_iterator_tag;
+
+    iterator_base() = default;
 
     explicit iterator_base(
         ContainerType* _arrayContainer,
@@ -100,17 +344,35 @@ public: // Interface
         const iterator_base & _it
       );
 
+    iterator_base& operator=(
+        const iterator_base & _it
+      ) = default;
+
     iterator_base& operator++();
-    iterator_base  operator++(int) const;
-    iterator_base& operator+(
+    iterator_base  operator++(int);
+    iterator_base& operator+=(
         int _offset
       );
+    iterator_base  operator+(
+        int _offset
+      ) const;
+
+    friend iterator_base operator+(
+        int                   _offset,
+        const iterator_base & _it
+      )
+    {
+      return _it + _offset;
+    }
 
     iterator_base& operator--();
-    iterator_base  operator--(int) const;
-    iterator_base& operator-(
+    iterator_base  operator--(int);
+    iterator_base& operator-=(
         int _offset
       );
+    iterator_base  operator-(
+        int _offset
+      ) const;
 
     int operator-(
         const iterator_base & _it
@@ -128,9 +390,25 @@ public: // Interface
         const iterator_base& _it
       ) const;
 
+    bool operator>(
+        const iterator_base& _it
+      ) const;
+
+    bool operator<=(
+        const iterator_base& _it
+      ) const;
+
+    bool operator>=(
+        const iterator_base& _it
+      ) const;
+
+    DataType& operator[](
+        int _offset
+      ) const;
+
     DataType& operator*() const;
 
-    DataType& operator->() const;
+    DataType* operator->() const;
 
     DataType* getPtr() const;
 
@@ -144,8 +422,8 @@ public: // Interface
     unsigned int    m_index = 0;
   };
 
-  using iterator       = typename iterator_base<CArray, TData>;
-  using const_iterator = typename iterator_base<const CArray, const TData>;
+  using iterator       = iterator_base<CArray, TData>;
+  using const_iterator = iterator_base<const CArray, const TData>;
 
   iterator        begin();
   const_iterator  begin()   const;
@@ -155,28 +433,75 @@ public: // Interface
   const_iterator  end()     const;
   const_iterator  cend()    const;
 
-  //       
+  // Добавить элемент в массив по заданному индексу
   void insert(
       iterator _pos,
       const TData & _value
     );
 
-  //   
+  // Удалить диапазон элементов
   void erase(
       const iterator & _itFrom,
       const iterator & _itTo
     );
 
-protected:  // 
+  // Удалить элементы, удовлетворяющие условию, за один проход.
+  // Возвращает количество удаленных элементов.
+  template <typename TPredicate>
+  unsigned int erase_if(
+      TPredicate _pred
+    );
+
+  // Удалить элементы, удовлетворяющие условию, с разбиением больших
+  // массивов между потоками. Условие вызывается из разных потоков.
+  // Исключение условия передается вызывающему после завершения всех
+  // потоков (первое по порядку частей); элементы, для которых условие
+  // не вызывалось или выбросило исключение, сохраняются.
+  template <typename TPredicate>
+  unsigned int erase_if_parallel(
+      TPredicate _pred
+    );
+
+  // Удалить элементы по упорядоченному по возрастанию набору индексов
+  template <typename TIndexRange>
+  unsigned int erase_indices(
+      const TIndexRange & _sortedIndexes
+    );
+
+  // Удалить каждый _step-й элемент, начиная с индекса _offset
+  unsigned int erase_every_nth(
+      unsigned int _step,
+      unsigned int _offset = 0
+    );
+
+protected:  // Методы
 
   template <typename TItemType, typename TAllocatorType>
-  class MemoryBuf
+  class MemoryBuf : public CArrayStatisticsCollector<TItemType, TPolicy::collectStatistics>,
+                    protected CArrayGrowthState<TItemType, TPolicy::incrementalGrowth>,
+                    protected CArrayRecycleState<TPolicy::recycleElements
+                                                 && !std::is_trivially_destructible<TItemType>::value>,
+                    protected CArrayShareState<TPolicy::copyOnWrite>
   {
+    static_assert(!(TPolicy::copyOnWrite && TPolicy::incrementalGrowth),
+                  "Incremental growth can not be combined with copy-on-write");
+    static_assert(!(TPolicy::recycleElements && (TPolicy::copyOnWrite || TPolicy::incrementalGrowth)),
+                  "Element recycling can not be combined with copy-on-write or incremental growth");
+
+    // Удаленные объекты сохраняются за концом массива
+    static constexpr bool recycles = TPolicy::recycleElements
+                                     && !std::is_trivially_destructible<TItemType>::value;
+    static_assert(!TPolicy::incrementalGrowth || TPolicy::incrementalGrowthStep >= 2,
+                  "Incremental growth step must be at least 2");
+
+    using TRefCounter          = std::atomic<unsigned int>;
+    using TRefCounterAllocator = typename std::allocator_traits<TAllocator>::template rebind_alloc<TRefCounter>;
+
     TAllocator    m_allocator;
     unsigned int  m_allocatedObjectsCount = 0;
 
-    TItemType *   m_buf    = nullptr;    //<     
-    unsigned int  m_size   = 0;          //<   
+    TItemType *   m_buf    = nullptr;    //< Область памяти для хранения данных
+    unsigned int  m_size   = 0;          //< Количество созданных элементов
 
   public:
 
@@ -190,50 +515,122 @@ protected:  // 
         MemoryBuf& _other
       );
 
-    //  
+    // Получить размер
     unsigned int size() const;
 
-     //    
+    // Получить количество элементов, под которые выделена память
+    unsigned int capacity() const;
+
+    // Получить распределитель памяти буфера
+    TAllocator & allocator();
+
+    // Определить, разделяется ли буфер несколькими массивами
+    bool isShared() const;
+
+    // Стать совладельцем буфера другого массива (только для copy-on-write)
+    void shareFrom(
+        const MemoryBuf & _other
+      );
+
+    // Получить собственную копию разделяемого буфера перед изменением
+    void detach();
+
+    // Отказаться от владения буфером: разделяемый буфер только отпускается,
+    // единственный владелец разрушает объекты
+    void release();
+
+     // Определить наличие свободного места
     bool hasFreeSpace() const;
 
-    //      
+    // Подготовить контейнер для создания нового элемента
     void prepareToAddNewItem();
 
+    // Перенести очередную порцию элементов из старого буфера
+    // (только для политик с incrementalGrowth)
+    void growthStep();
+
+    // Перенести все элементы из старого буфера и освободить его
+    void completeGrowth();
+
+    // Определить, находится ли объект в памяти буфера (включая старый буфер)
+    bool contains(
+        const TItemType * _pitem
+      ) const;
+
 #ifdef _DEBUG
-    //    
+    // Проверить валидность адреса памяти
     bool isValidAddr(TData * _addr, size_t _bufSize);
 #endif
 
-    //      
+    // Получить указатель на элемент по инлексу
     TItemType * getPData(
         unsigned int _index
       );
 
-    //      
+    // Получить указатель на элемент по инлексу
     const TItemType * getPData(
         unsigned int _index
       ) const;
 
-    //       
+    // Получить правую ссылку на элемент по инлексу
     TItemType&& getPDataRValue(
         unsigned int _index
       );
 
-    //  
+    // Деструкция объектов
     void destroyObjects();
 
-    //  
+    // Добавить объект в конец: присвоить сохраненному объекту или создать
+    template <typename T>
+    void appendObj(
+        T&& _srcObj
+      );
+
+    // Уменьшить размер до _size, сохранив объекты хвоста для повторного
+    // использования (или разрушив их без recycleElements)
+    void recycleObjects(
+        unsigned int _size
+      );
+
+    // Разрушить сохраненные для повторного использования объекты
+    void destroyRecycled();
+
+    // Перенести сохраненные объекты другого буфера за конец массива
+    // (сколько поместится), остальные сохраненные объекты источника разрушить
+    void moveRecycledFrom(
+        MemoryBuf<TItemType, TAllocator> & _dataSrc
+      );
+
+    // Перенести сохраненные объекты, начинающиеся с позиции _indexFrom,
+    // на позицию _indexTo; не поместившиеся в буфер объекты разрушаются
+    void relocateRecycled(
+        unsigned int _indexTo,
+        unsigned int _indexFrom
+      );
+
+    // Деструкция объектов
     void destroyObjects(
         unsigned int _indexFrom,
         unsigned int _indexTo
       );
 
-    //  
+    // Разместить только что выделенный буфер по узлам NUMA
+    void placeBuffer(
+        TItemType *  _buf,
+        unsigned int _capacity
+      );
+
+    // Перемещение объектов
     void moveObjectsFrom(
         MemoryBuf<TItemType, TAllocator> & _dataSrc
       );
 
-    //    
+    // Копирование объектов
+    void copyObjectsFrom(
+        const MemoryBuf<TItemType, TAllocator> & _dataSrc
+      );
+
+    // Копирование в новый объект
     void constructFrom(
         unsigned int _indexTo,
         MemoryBuf<TItemType, TAllocator>& _other,
@@ -245,187 +642,427 @@ protected:  // 
         TData * _destRawBuf,
         T&& _srcObj
       );
+
+    // Перенести объекты в область левее источника, не изменяя размер.
+    // Область назначения до переноса не инициализирована, источник - после.
+    void relocateObjects(
+        unsigned int _indexTo,
+        unsigned int _indexFrom,
+        unsigned int _count
+      );
+
+    // Вставить _count объектов за один проход: i-й объект (в порядке
+    // неубывания позиций) копируется из valueAt(i) перед исходным
+    // объектом с индексом positionAt(i)
+    template <typename TPositionAt, typename TValueAt>
+    void insertObjects(
+        unsigned int  _count,
+        TPositionAt & _positionAt,
+        TValueAt &    _valueAt
+      );
+
+    // Перенести объекты в область правее источника, не изменяя размер
+    void relocateObjectsRight(
+        unsigned int _indexTo,
+        unsigned int _indexFrom,
+        unsigned int _count
+      );
+
+    // Переставить объекты: на место i переносится объект _order[i]
+    // (перестановка индексов 0..size()-1). Объекты перемещаются в новый
+    // буфер той же емкости за один последовательный проход.
+    void permuteObjects(
+        const unsigned int * _order
+      );
+
+    // Удалить диапазон объектов со сдвигом хвоста
+    void eraseObjects(
+        unsigned int _indexFrom,
+        unsigned int _indexTo
+      );
+
+    // Удалить объекты, для которых _removeCheck(index, item) истинно, за один
+    // проход. При _chunkCount > 1 части буфера уплотняются параллельно.
+    // Возвращает количество удаленных объектов.
+    template <typename TRemoveCheck>
+    unsigned int eraseObjectsIf(
+        TRemoveCheck & _removeCheck,
+        unsigned int   _chunkCount
+      );
+
+  private:
+
+    // Уплотнить диапазон к его началу, не изменяя размер.
+    // Возвращает количество сохранившихся объектов.
+    template <typename TRemoveCheck>
+    unsigned int compactRange(
+        unsigned int   _indexFrom,
+        unsigned int   _indexTo,
+        TRemoveCheck & _removeCheck,
+        unsigned int & _removedCount,
+        unsigned int & _movedCount
+      );
   };
 
-  //   
-  void insertCopyData(
-      unsigned int  _index,
-      const TData & _value
+  // Удалить элемент массива по заданному индексу
+  void eraseImpl(
+      unsigned int _indexFrom,
+      unsigned int _indexTo
     );
 
-  //      
-  void eraseImpl(
+#ifdef _DEBUG
+  // Проверить, что представление [_indexFrom, _indexTo) с первым элементом
+  // по адресу _data соответствует текущему буферу массива _source
+  static bool isViewValid(
+      const void * _source,
+      const void * _data,
       unsigned int _indexFrom,
       unsigned int _indexTo
     );
 
+  // Обменяться связью с представлениями вместе с буфером: представления
+  // следуют за буфером, к которому относятся
+  void swapViewGuard(
+      CArray & _array
+    );
+#endif
+
 protected: // Attributes
 
   MemoryBuf<TData, TAllocator> m_data;
+
+#ifdef _DEBUG
+  // Связь с представлениями массива, переживающая массив
+  std::shared_ptr<CArrayViewGuard> m_viewGuard =
+    std::make_shared<CArrayViewGuard>(CArrayViewGuard{this, &CArray::isViewValid});
+#endif
 };
 
 namespace std
 {
-  template <typename TData, typename TAllocator>
-  auto begin(CArray<TData, TAllocator>& _array)
+  template <typename TData, typename TAllocator, typename TPolicy>
+  auto begin(CArray<TData, TAllocator, TPolicy>& _array)
   {
     return _array.begin();
   }
 
-  template <typename TData, typename TAllocator>
-  auto end(CArray<TData, TAllocator>& _array)
+  template <typename TData, typename TAllocator, typename TPolicy>
+  auto end(CArray<TData, TAllocator, TPolicy>& _array)
   {
     return _array.end();
   }
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
-CArray<TData, TAllocator>::CArray()
+template <typename TData, typename TAllocator, typename TPolicy>
+CArray<TData, TAllocator, TPolicy>::CArray()
   : m_data(0)
 {
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
-CArray<TData, TAllocator>::CArray(
-    const CArray & _array
+template <typename TData, typename TAllocator, typename TPolicy>
+CArray<TData, TAllocator, TPolicy>::CArray(
+    CArrayCapacitySite & _site
   )
-  : m_data(_array.m_data.capacity)
+  : m_data(_site.predictCapacity())
 {
-  copyObjects(_array.m_data, m_data);
+  static_assert(TPolicy::capacityAdvisor, "Capacity prediction requires a policy with capacityAdvisor");
+
+  this->m_site = &_site;
+  if (m_data.capacity())
+  {
+    m_data.noteGrowth(0, m_data.capacity(), 0);
+  }
+}
 
-  m_data.size = _array.size;
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+CArray<TData, TAllocator, TPolicy>::CArray(
+    const CArray & _array
+  )
+  : m_data(TPolicy::copyOnWrite ? 0 : _array.m_data.size())
+{
+  if constexpr (TPolicy::copyOnWrite)
+  {
+    // Копия разделяет буфер с исходным массивом до первого изменения
+    m_data.shareFrom(_array.m_data);
+  }
+  else
+  {
+    m_data.copyObjectsFrom(_array.m_data);
+    if (m_data.capacity())
+    {
+      m_data.noteCopy(m_data.capacity(), m_data.size());
+    }
+  }
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
-CArray<TData, TAllocator>::CArray(CArray && _array)
+template <typename TData, typename TAllocator, typename TPolicy>
+CArray<TData, TAllocator, TPolicy>::CArray(CArray && _array)
+  : m_data(0)
 {
   m_data.swap(_array.m_data);
+  m_data.swapStatistics(_array.m_data);
+
+#ifdef _DEBUG
+  swapViewGuard(_array);
+#endif
+
+  if constexpr (TPolicy::capacityAdvisor)
+  {
+    // Размер учитывается массивом, которому перешли данные
+    std::swap(this->m_site, _array.m_site);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+CArray<TData, TAllocator, TPolicy>::~CArray()
+{
+  if constexpr (TPolicy::capacityAdvisor)
+  {
+    if (this->m_site)
+    {
+      this->m_site->record(m_data.size());
+    }
+  }
+
+  m_data.release();
+
+#ifdef _DEBUG
+  m_viewGuard->m_source = nullptr;
+#endif
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+CArray<TData, TAllocator, TPolicy>&
+CArray<TData, TAllocator, TPolicy>::operator=(
+    const CArray & _array
+  )
+{
+  if (this != &_array)
+  {
+    CArray tmp(_array);
+    m_data.swap(tmp.m_data);
+    m_data.swapStatistics(tmp.m_data);
+
+#ifdef _DEBUG
+    // Представления прежнего содержимого становятся недействительными
+    // вместе с tmp
+    swapViewGuard(tmp);
+#endif
+  }
+
+  return *this;
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
-CArray<TData, TAllocator>::~CArray()
+template <typename TData, typename TAllocator, typename TPolicy>
+CArray<TData, TAllocator, TPolicy>&
+CArray<TData, TAllocator, TPolicy>::operator=(
+    CArray && _array
+  )
 {
-  m_data.destroyObjects();
+  if (this != &_array)
+  {
+    CArray tmp(std::move(_array));
+    m_data.swap(tmp.m_data);
+    m_data.swapStatistics(tmp.m_data);
+
+#ifdef _DEBUG
+    // Представления прежнего содержимого становятся недействительными
+    // вместе с tmp
+    swapViewGuard(tmp);
+#endif
+
+    if constexpr (TPolicy::capacityAdvisor)
+    {
+      // Прежнее содержимое учитывается в истории своего места
+      std::swap(this->m_site, tmp.m_site);
+    }
+  }
+
+  return *this;
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 void
-CArray<TData, TAllocator>::push_back(
+CArray<TData, TAllocator, TPolicy>::push_back(
     const TData & _value
   )
 {
+  m_data.detach();
   m_data.prepareToAddNewItem();
 
-  m_data.constructFromObj(m_data.getPData(m_data.size()), _value);
+  m_data.appendObj(_value);
+  m_data.growthStep();
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename T>
 void
-CArray<TData, TAllocator>::emplace_back(
+CArray<TData, TAllocator, TPolicy>::emplace_back(
     T&& _value
   )
 {
+  m_data.detach();
   m_data.prepareToAddNewItem();
 
-  m_data.constructFromObj(m_data.getPData(m_data.size()), std::forward<T>(_value));
+  m_data.appendObj(std::forward<T>(_value));
+  m_data.growthStep();
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <class ...Args>
 void
-CArray<TData, TAllocator>::emplace_back(
+CArray<TData, TAllocator, TPolicy>::emplace_back(
     Args && ...args
   )
 {
+  m_data.detach();
   m_data.prepareToAddNewItem();
 
-  m_data.constructFromObj(m_data.getPData(m_data.size), std::forward<Args>(args)...);
+  m_data.appendObj(TData(std::forward<Args>(args)...));
+  m_data.growthStep();
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 void
-CArray<TData, TAllocator>::insert(
-    unsigned int _index, 
+CArray<TData, TAllocator, TPolicy>::insert(
+    unsigned int  _index,
     const TData & _value
   )
 {
-  if (!m_data.hasFreeSpace())
+  assert(_index <= m_data.size());
+
+  if (m_data.contains(&_value))
   {
-    MemoryBuf<TData, TAllocator> newData(std::max<unsigned long>(m_data.size() * 2, 1));
+    // Вставляемое значение - элемент этого же массива, при сдвиге оно
+    // переместится, поэтому вставляем копию
+    TData valueCopy(_value);
+    insert(_index, valueCopy);
+    return;
+  }
 
-    unsigned int fromIdx = 0;
-    unsigned int toIdx = 0;
-
-    for ( ; fromIdx < _index; ++fromIdx, ++toIdx)
-    {
-      newData.constructFrom(toIdx, m_data, fromIdx);
-    }
+  m_data.detach();
+  m_data.completeGrowth();
 
-    newData.constructFromObj(newData.getPData(toIdx++), _value);
+  auto positionAt = [_index](unsigned int) { return _index; };
+  auto valueAt    = [&_value](unsigned int) -> const TData & { return _value; };
 
-    for (auto dataSize = m_data.size(); fromIdx < dataSize; ++fromIdx, ++toIdx)
-    {
-      newData.constructFrom(toIdx, m_data, fromIdx);
-    }
+  m_data.insertObjects(1, positionAt, valueAt);
+}
 
-    m_data.swap(newData);
-    newData.destroyObjects();
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TPositions, typename TValues>
+void
+CArray<TData, TAllocator, TPolicy>::insert_many(
+    const TPositions & _positions,
+    const TValues &    _values
+  )
+{
+  const unsigned int count = static_cast<unsigned int>(_values.size());
+  assert(_positions.size() == _values.size());
+  if (count == 0)
+  {
+    return;
   }
-  else
+
+  // Порядок вставки - по возрастанию исходной позиции, при равных
+  // позициях сохраняется порядок перечисления
+  CArray<unsigned int> order;
+  order.reserve(count);
+  for (unsigned int index = 0; index < count; ++index)
   {
-    insertCopyData(_index, _value);
+    assert(static_cast<unsigned int>(_positions[index]) <= m_data.size());
+    order.push_back(index);
   }
+
+  std::stable_sort(&order[0], &order[0] + count,
+                   [&_positions](unsigned int _left, unsigned int _right)
+                   {
+                     return _positions[_left] < _positions[_right];
+                   });
+
+  m_data.detach();
+  m_data.completeGrowth();
+
+  auto positionAt = [&_positions, &order](unsigned int _index)
+                    {
+                      return static_cast<unsigned int>(_positions[order[_index]]);
+                    };
+  auto valueAt    = [&_values, &order](unsigned int _index) -> const TData &
+                    {
+                      return _values[order[_index]];
+                    };
+
+  m_data.insertObjects(count, positionAt, valueAt);
 }
 
 //----------------------------------------------------------------------------//
-//       
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 void
-CArray<TData, TAllocator>::insertCopyData(
-    unsigned int  _index,
-    const TData & _value
+CArray<TData, TAllocator, TPolicy>::reserve(
+    unsigned int _capacity
   )
 {
-  unsigned int toIdx = m_data.size();
-  unsigned int fromIdx = toIdx - 1;
+  m_data.detach();
+  m_data.completeGrowth();
 
-  for ( ; _index <= fromIdx; --fromIdx, --toIdx)
+  if (_capacity > m_data.capacity())
   {
-    *(m_data.getPData(toIdx)) = *(m_data.getPData(fromIdx));
+    MemoryBuf<TData, TAllocator> newData(_capacity);
 
-    if (fromIdx == 0)
-    {
-      break;
-    }
+    newData.moveObjectsFrom(m_data);
+    newData.moveRecycledFrom(m_data);
+    newData.swap(m_data);
+
+    m_data.noteGrowth(newData.capacity(), m_data.capacity(), m_data.size());
+    newData.destroyObjects();
   }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+unsigned int
+CArray<TData, TAllocator, TPolicy>::capacity() const
+{
+  return m_data.capacity();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+const CArrayStatistics &
+CArray<TData, TAllocator, TPolicy>::statistics() const
+{
+  static_assert(TPolicy::collectStatistics, "Statistics require a policy with collectStatistics");
 
-  m_data.constructFromObj(m_data.getPData(_index), _value);
+  return m_data.statistics();
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 void
-CArray<TData, TAllocator>::insert(
+CArray<TData, TAllocator, TPolicy>::insert(
     iterator _pos,
     const TData & _value
   )
 {
-  insert(_pos.getPtr() - m_data.m_buf, _value);
+  insert(_pos.GetIndex(), _value);
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 void
-CArray<TData, TAllocator>::erase(
+CArray<TData, TAllocator, TPolicy>::erase(
     unsigned int _index
   )
 {
@@ -433,9 +1070,9 @@ CArray<TData, TAllocator>::erase(
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 void
-CArray<TData, TAllocator>::erase(
+CArray<TData, TAllocator, TPolicy>::erase(
     const iterator & _itFrom,
     const iterator & _itTo
   )
@@ -444,9 +1081,9 @@ CArray<TData, TAllocator>::erase(
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 void
-CArray<TData, TAllocator>::eraseImpl(
+CArray<TData, TAllocator, TPolicy>::eraseImpl(
     unsigned int _indexFrom,
     unsigned int _indexTo
   )
@@ -454,84 +1091,167 @@ CArray<TData, TAllocator>::eraseImpl(
   assert(_indexFrom <= _indexTo);
   if (_indexFrom == _indexTo)
   {
-    //        -  
+    // Начальная и конечная границы удаляемого диапазона совпадают - просто выходим
     return;
   }
 
-  const auto dataSize = m_data.size();
+  m_data.detach();
+  m_data.completeGrowth();
+  m_data.eraseObjects(_indexFrom, _indexTo);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TPredicate>
+unsigned int
+CArray<TData, TAllocator, TPolicy>::erase_if(
+    TPredicate _pred
+  )
+{
+  m_data.detach();
+  m_data.completeGrowth();
+
+  auto removeCheck = [&_pred](unsigned int, TData & _item) -> bool
+                     {
+                       return _pred(_item);
+                     };
+
+  return m_data.eraseObjectsIf(removeCheck, 1);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TPredicate>
+unsigned int
+CArray<TData, TAllocator, TPolicy>::erase_if_parallel(
+    TPredicate _pred
+  )
+{
+  m_data.detach();
+  m_data.completeGrowth();
+
+  auto removeCheck = [&_pred](unsigned int, TData & _item) -> bool
+                     {
+                       return _pred(_item);
+                     };
+
+  return m_data.eraseObjectsIf(removeCheck, parallelChunkCount(m_data.size()));
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TIndexRange>
+unsigned int
+CArray<TData, TAllocator, TPolicy>::erase_indices(
+    const TIndexRange & _sortedIndexes
+  )
+{
+  using std::begin;
+  using std::end;
 
-  // /
-  if ((_indexTo + 1) < dataSize)
+  auto itIndex    = begin(_sortedIndexes);
+  auto itIndexEnd = end(_sortedIndexes);
+  if (itIndex == itIndexEnd)
   {
-    unsigned int fromIdx   = _indexTo;
-    unsigned int fromIdxTo = std::min<unsigned int>(dataSize, fromIdx + _indexTo - _indexFrom);
-    unsigned int toIdx     = fromIdx + _indexFrom - _indexTo;
+    return 0;
+  }
 
-    for ( ; fromIdx < fromIdxTo; ++fromIdx, ++toIdx)
-    {
-      if constexpr (!std::is_trivially_copy_assignable<TData>::value)
-      {
-        if constexpr (std::is_move_assignable<TData>::value)
-        {
-          *m_data.getPData(toIdx) = std::move(*m_data.getPData(fromIdx));
-        }
-        else
-        {
-          *m_data.getPData(toIdx) = *m_data.getPData(fromIdx);
-        }
-      }
-      else
-      {
-        memcpy(m_data.getPData(toIdx), m_data.getPData(fromIdx), sizeof(TData));
-      }
+  m_data.detach();
+  m_data.completeGrowth();
 
-      ++_indexFrom;
-    }
+  auto removeCheck = [&itIndex, &itIndexEnd](unsigned int _index, TData &) -> bool
+                     {
+                       // Повторяющиеся индексы пропускаем
+                       while (itIndex != itIndexEnd && *itIndex < _index)
+                       {
+                         ++itIndex;
+                       }
+
+                       return itIndex != itIndexEnd && *itIndex == _index;
+                     };
+
+  return m_data.eraseObjectsIf(removeCheck, 1);
+}
 
-    _indexTo   = fromIdxTo;
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+unsigned int
+CArray<TData, TAllocator, TPolicy>::erase_every_nth(
+    unsigned int _step,
+    unsigned int _offset
+  )
+{
+  assert(_step > 0);
+  if (_offset >= m_data.size())
+  {
+    return 0;
   }
 
-  m_data.destroyObjects(_indexFrom, _indexTo);
+  m_data.detach();
+  m_data.completeGrowth();
+
+  unsigned long long nextIndex = _offset;
+  auto removeCheck = [&nextIndex, _step](unsigned int _index, TData &) -> bool
+                     {
+                       if (_index != nextIndex)
+                       {
+                         return false;
+                       }
+
+                       nextIndex += _step;
+                       return true;
+                     };
+
+  return m_data.eraseObjectsIf(removeCheck, 1);
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 void
-CArray<TData, TAllocator>::clear()
+CArray<TData, TAllocator, TPolicy>::clear()
 {
-  m_data.destroyObjects();
+  if constexpr (TPolicy::recycleElements)
+  {
+    m_data.recycleObjects(0);
+    return;
+  }
+
+  // Разделяемый буфер только отпускается, без копирования
+  m_data.release();
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 unsigned int
-CArray<TData, TAllocator>::size() const
+CArray<TData, TAllocator, TPolicy>::size() const
 {
   return m_data.size();
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 bool
-CArray<TData, TAllocator>::empty() const
+CArray<TData, TAllocator, TPolicy>::empty() const
 {
-  return m_data.size == 0;
+  return m_data.size() == 0;
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 TData&
-CArray<TData, TAllocator>::operator[](
+CArray<TData, TAllocator, TPolicy>::operator[](
     unsigned int _index
   )
 {
+  m_data.detach();
+
   return *m_data.getPData(_index);
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 const TData&
-CArray<TData, TAllocator>::operator[](
+CArray<TData, TAllocator, TPolicy>::operator[](
     unsigned int _index
   ) const
 {
@@ -539,57 +1259,233 @@ CArray<TData, TAllocator>::operator[](
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
-typename CArray<TData, TAllocator>::iterator
-CArray<TData, TAllocator>::begin()
+template <typename TData, typename TAllocator, typename TPolicy>
+CArrayView<TData>
+CArray<TData, TAllocator, TPolicy>::subview(
+    unsigned int _indexFrom,
+    unsigned int _indexTo
+  ) const
+{
+  // Представлению нужен непрерывный буфер, а перенос элементов изменяет
+  // массив и не может выполняться одновременно читающими потоками
+  static_assert(!TPolicy::incrementalGrowth,
+                "A view of an incrementally growing array requires the non-const subview()");
+
+  assert(_indexFrom <= _indexTo && _indexTo <= m_data.size());
+
+#ifdef _DEBUG
+  return CArrayView<TData>(m_data.getPData(_indexFrom), _indexTo - _indexFrom, m_viewGuard, _indexFrom);
+#else
+  return CArrayView<TData>(m_data.getPData(_indexFrom), _indexTo - _indexFrom);
+#endif
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+CArraySlice<TData>
+CArray<TData, TAllocator, TPolicy>::subview(
+    unsigned int _indexFrom,
+    unsigned int _indexTo
+  )
+{
+  assert(_indexFrom <= _indexTo && _indexTo <= m_data.size());
+
+  m_data.detach();
+  m_data.completeGrowth();
+
+#ifdef _DEBUG
+  return CArraySlice<TData>(m_data.getPData(_indexFrom), _indexTo - _indexFrom, m_viewGuard, _indexFrom);
+#else
+  return CArraySlice<TData>(m_data.getPData(_indexFrom), _indexTo - _indexFrom);
+#endif
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+CArray<TData, TAllocator, TPolicy>::operator CArrayView<TData>() const
+{
+  return subview(0, m_data.size());
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+void
+CArray<TData, TAllocator, TPolicy>::shrink_to_fit()
+{
+  m_data.detach();
+  m_data.completeGrowth();
+  m_data.destroyRecycled();
+
+  if (m_data.capacity() > m_data.size())
+  {
+    MemoryBuf<TData, TAllocator> newData(m_data.size());
+
+    newData.moveObjectsFrom(m_data);
+    newData.swap(m_data);
+
+    m_data.noteGrowth(newData.capacity(), m_data.capacity(), m_data.size());
+    newData.destroyObjects();
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+void
+CArray<TData, TAllocator, TPolicy>::destroy_async(
+    CArray && _array
+  )
+{
+  if (_array.capacity() == 0)
+  {
+    return;
+  }
+
+  CArray * pArray = new CArray(std::move(_array));
+
+  if constexpr (TPolicy::capacityAdvisor)
+  {
+    // Размер учитывается в вызывающем потоке
+    if (pArray->m_site)
+    {
+      pArray->m_site->record(pArray->size());
+      pArray->m_site = nullptr;
+    }
+  }
+
+  if (!CArrayReclaimer::instance().submit(pArray, [](void * _pObject) { delete static_cast<CArray *>(_pObject); }))
+  {
+    delete pArray;
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+void
+CArray<TData, TAllocator, TPolicy>::sort()
+{
+  const unsigned int count = m_data.size();
+  if (count < 2)
+  {
+    return;
+  }
+
+  m_data.detach();
+  m_data.completeGrowth();
+
+  TData * pData = m_data.getPData(0);
+
+  if constexpr (CArrayRadixKey<TData>::supported)
+  {
+    if (count >= CArrayRadixMinCount)
+    {
+      // Вспомогательный буфер освобождается и при исключении
+      TAllocator & allocator = m_data.allocator();
+      auto         release   = [&allocator, count](TData * _pScratch) { allocator.deallocate(_pScratch, count); };
+
+      std::unique_ptr<TData, decltype(release)> scratch(allocator.allocate(count), release);
+
+      CArrayRadixSorter<TData>::sort(pData, scratch.get(), count);
+      return;
+    }
+  }
+  else if constexpr (std::is_same<TData, std::string>::value)
+  {
+    if (count >= CArrayRadixMinCount)
+    {
+      std::vector<unsigned int> order(count);
+      CArrayStringSorter<TData>::sortedOrder(pData, count, order.data());
+
+      m_data.permuteObjects(order.data());
+      return;
+    }
+  }
+
+  std::sort(pData, pData + count);
+}
+
+#ifdef _DEBUG
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+bool
+CArray<TData, TAllocator, TPolicy>::isViewValid(
+    const void * _source,
+    const void * _data,
+    unsigned int _indexFrom,
+    unsigned int _indexTo
+  )
+{
+  const CArray & array = *static_cast<const CArray *>(_source);
+
+  return _indexTo <= array.m_data.size() && array.m_data.getPData(_indexFrom) == _data;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+void
+CArray<TData, TAllocator, TPolicy>::swapViewGuard(
+    CArray & _array
+  )
+{
+  std::swap(m_viewGuard, _array.m_viewGuard);
+  m_viewGuard->m_source        = this;
+  _array.m_viewGuard->m_source = &_array;
+}
+#endif
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+typename CArray<TData, TAllocator, TPolicy>::iterator
+CArray<TData, TAllocator, TPolicy>::begin()
 {
+  m_data.detach();
+
   return iterator(this, 0);
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
-typename CArray<TData, TAllocator>::const_iterator
-CArray<TData, TAllocator>::begin() const
+template <typename TData, typename TAllocator, typename TPolicy>
+typename CArray<TData, TAllocator, TPolicy>::const_iterator
+CArray<TData, TAllocator, TPolicy>::begin() const
 {
   return cbegin();
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
-typename CArray<TData, TAllocator>::iterator
-CArray<TData, TAllocator>::end()
+template <typename TData, typename TAllocator, typename TPolicy>
+typename CArray<TData, TAllocator, TPolicy>::iterator
+CArray<TData, TAllocator, TPolicy>::end()
 {
   return iterator(this, m_data.size());
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
-typename CArray<TData, TAllocator>::const_iterator
-CArray<TData, TAllocator>::end() const
+template <typename TData, typename TAllocator, typename TPolicy>
+typename CArray<TData, TAllocator, TPolicy>::const_iterator
+CArray<TData, TAllocator, TPolicy>::end() const
 {
   return cend();
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
-typename CArray<TData, TAllocator>::const_iterator
-CArray<TData, TAllocator>::cbegin() const
+template <typename TData, typename TAllocator, typename TPolicy>
+typename CArray<TData, TAllocator, TPolicy>::const_iterator
+CArray<TData, TAllocator, TPolicy>::cbegin() const
 {
   return const_iterator(this, 0);
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
-typename CArray<TData, TAllocator>::const_iterator
-CArray<TData, TAllocator>::cend() const
+template <typename TData, typename TAllocator, typename TPolicy>
+typename CArray<TData, TAllocator, TPolicy>::const_iterator
+CArray<TData, TAllocator, TPolicy>::cend() const
 {
   return const_iterator(this, m_data.size());
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::iterator_base(
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::iterator_base(
     ContainerType* _arrayContainer,
     unsigned int   _index
   )
@@ -599,9 +1495,9 @@ CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::iterator_base
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::iterator_base(
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::iterator_base(
   const iterator_base & _it
   )
   : m_arrayContainer(_it.m_arrayContainer),
@@ -610,108 +1506,123 @@ CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::iterator_base
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
-typename CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>&
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator++()
+typename CArray<TData, TAllocator, TPolicy>::template iterator_base<ContainerType, DataType>&
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator++()
 {
-  operator+(1);
+  ++m_index;
 
   return *this;
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
-typename CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator++(
+typename CArray<TData, TAllocator, TPolicy>::template iterator_base<ContainerType, DataType>
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator++(
     int
-  ) const
+  )
 {
-  iterator_base<ContainerType, DataType> tmp(it);
+  iterator_base<ContainerType, DataType> tmp(*this);
   operator++();
   return tmp;
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
-typename CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>&
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator+(
+typename CArray<TData, TAllocator, TPolicy>::template iterator_base<ContainerType, DataType>&
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator+=(
     int _offset
   )
 {
-  auto newIndex = m_index + _offset;
-  if (0 <= newIndex && newIndex <= m_arrayContainer->size())
-  {
-    m_index = newIndex;
-  }
+  // Выход за границы массива не проверяется, как и для указателей:
+  // алгоритмы стандартной библиотеки могут временно формировать такие итераторы
+  m_index += _offset;
 
   return *this;
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename ContainerType, typename DataType>
+typename CArray<TData, TAllocator, TPolicy>::template iterator_base<ContainerType, DataType>
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator+(
+    int _offset
+  ) const
+{
+  iterator_base<ContainerType, DataType> tmp(*this);
+  tmp += _offset;
+  return tmp;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
-typename CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>&
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator--()
+typename CArray<TData, TAllocator, TPolicy>::template iterator_base<ContainerType, DataType>&
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator--()
 {
-  operator-(1);
+  --m_index;
 
   return *this;
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
-typename CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator--(
+typename CArray<TData, TAllocator, TPolicy>::template iterator_base<ContainerType, DataType>
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator--(
     int
-  ) const
+  )
 {
-  iterator_base<ContainerType, DataType> tmp(it);
+  iterator_base<ContainerType, DataType> tmp(*this);
   operator--();
   return tmp;
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
-typename CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>&
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator-(
+typename CArray<TData, TAllocator, TPolicy>::template iterator_base<ContainerType, DataType>&
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator-=(
     int _offset
   )
 {
-  auto newIndex = m_index - _offset;
-  if (0 <= newIndex && newIndex < m_arrayContainer->size())
-  {
-    m_index = newIndex;
-  }
-  else
-  {
-    m_arrayContainer = nullptr;
-    m_index = 0;
-  }
+  m_index -= _offset;
 
   return *this;
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename ContainerType, typename DataType>
+typename CArray<TData, TAllocator, TPolicy>::template iterator_base<ContainerType, DataType>
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator-(
+    int _offset
+  ) const
+{
+  iterator_base<ContainerType, DataType> tmp(*this);
+  tmp -= _offset;
+  return tmp;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
 int
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator-(
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator-(
     const iterator_base & _it
   ) const
 {
-  return m_index - _it.m_index;
+  return static_cast<int>(m_index - _it.m_index);
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
 bool
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator==(
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator==(
     const iterator_base<ContainerType, DataType>& _it
   ) const
 {
@@ -719,10 +1630,10 @@ CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator==(
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
 bool
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator!=(
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator!=(
   const iterator_base& _it
   ) const
 {
@@ -730,10 +1641,10 @@ CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator!=(
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
 bool
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator<(
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator<(
     const iterator_base& _it
   ) const
 {
@@ -741,45 +1652,89 @@ CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator<(
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename ContainerType, typename DataType>
+bool
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator>(
+    const iterator_base& _it
+  ) const
+{
+  return _it < *this;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename ContainerType, typename DataType>
+bool
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator<=(
+    const iterator_base& _it
+  ) const
+{
+  return !(_it < *this);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename ContainerType, typename DataType>
+bool
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator>=(
+    const iterator_base& _it
+  ) const
+{
+  return !(*this < _it);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
 DataType&
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator*() const
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator[](
+    int _offset
+  ) const
 {
-  return (*m_arrayContainer)[m_index];
+  return (*m_arrayContainer)[m_index + _offset];
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
 DataType&
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator->() const
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator*() const
 {
   return (*m_arrayContainer)[m_index];
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename ContainerType, typename DataType>
+DataType*
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::operator->() const
+{
+  return &(*m_arrayContainer)[m_index];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
 DataType *
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::getPtr() const
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::getPtr() const
 {
   return &(*m_arrayContainer)[m_index];
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename ContainerType, typename DataType>
 unsigned int
-CArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::GetIndex() const
+CArray<TData, TAllocator, TPolicy>::iterator_base<ContainerType, DataType>::GetIndex() const
 {
   return m_index;
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename TItemType, typename TAllocatorType>
-CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::MemoryBuf(
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::MemoryBuf(
     unsigned int _destCapacity
   )
 {
@@ -787,15 +1742,28 @@ CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::MemoryBuf(
   if (m_allocatedObjectsCount)
   {
     m_buf = m_allocator.allocate(m_allocatedObjectsCount);
+    placeBuffer(m_buf, m_allocatedObjectsCount);
+
+    if constexpr (TPolicy::copyOnWrite)
+    {
+      TRefCounterAllocator counterAllocator(m_allocator);
+      this->m_refCounter = new (counterAllocator.allocate(1)) TRefCounter(1);
+    }
   }
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename TItemType, typename TAllocatorType>
-CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::~MemoryBuf()
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::~MemoryBuf()
 {
   assert(size() == 0);
+  assert(!isShared());
+
+  if constexpr (TPolicy::incrementalGrowth)
+  {
+    assert(this->m_oldBuf == nullptr);
+  }
 
   if (m_allocatedObjectsCount)
   {
@@ -803,13 +1771,24 @@ CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::~MemoryBuf()
     m_buf = nullptr;
     m_allocatedObjectsCount = 0;
   }
+
+  if constexpr (TPolicy::copyOnWrite)
+  {
+    if (this->m_refCounter)
+    {
+      TRefCounterAllocator counterAllocator(m_allocator);
+      this->m_refCounter->~TRefCounter();
+      counterAllocator.deallocate(this->m_refCounter, 1);
+      this->m_refCounter = nullptr;
+    }
+  }
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename TItemType, typename TAllocatorType>
 void
-CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::swap(
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::swap(
     MemoryBuf & _other
   )
 {
@@ -817,50 +1796,282 @@ CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::swap(
   std::swap(m_allocatedObjectsCount, _other.m_allocatedObjectsCount);
   std::swap(m_buf,                   _other.m_buf);
   std::swap(m_size,                  _other.m_size);
-}
-
-//----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
-template <typename TItemType, typename TAllocatorType>
-unsigned int
-CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::size() const
-{
-  return m_size;
-}
+
+  if constexpr (TPolicy::copyOnWrite)
+  {
+    std::swap(this->m_refCounter, _other.m_refCounter);
+  }
+
+  if constexpr (TPolicy::incrementalGrowth)
+  {
+    using TGrowthState = CArrayGrowthState<TItemType, true>;
+    std::swap(static_cast<TGrowthState &>(*this), static_cast<TGrowthState &>(_other));
+  }
+
+  if constexpr (recycles)
+  {
+    std::swap(this->m_recycled, _other.m_recycled);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+unsigned int
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::size() const
+{
+  return m_size;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+unsigned int
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::capacity() const
+{
+  return m_allocatedObjectsCount;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+TAllocator &
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::allocator()
+{
+  return m_allocator;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+bool
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::isShared() const
+{
+  if constexpr (TPolicy::copyOnWrite)
+  {
+    return this->m_refCounter && this->m_refCounter->load(std::memory_order_acquire) > 1;
+  }
+  else
+  {
+    return false;
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::shareFrom(
+    const MemoryBuf & _other
+  )
+{
+  static_assert(TPolicy::copyOnWrite, "Buffer sharing requires copy-on-write policy");
+  assert(m_buf == nullptr && m_size == 0);
+
+  if (_other.m_refCounter)
+  {
+    _other.m_refCounter->fetch_add(1, std::memory_order_relaxed);
+
+    m_allocator             = _other.m_allocator;
+    m_allocatedObjectsCount = _other.m_allocatedObjectsCount;
+    m_buf                   = _other.m_buf;
+    m_size                  = _other.m_size;
+    this->m_refCounter      = _other.m_refCounter;
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::detach()
+{
+  if constexpr (TPolicy::copyOnWrite)
+  {
+    if (isShared())
+    {
+      MemoryBuf newData(m_allocatedObjectsCount);
+      newData.copyObjectsFrom(*this);
+
+      swap(newData);
+      this->noteCopy(m_allocatedObjectsCount, m_size);
+
+      newData.release();
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::release()
+{
+  if constexpr (TPolicy::copyOnWrite)
+  {
+    // Решение принимается по результату уменьшения счетчика, чтобы
+    // одновременное освобождение из разных потоков не оставило буфер без владельца
+    if (this->m_refCounter && this->m_refCounter->fetch_sub(1, std::memory_order_acq_rel) != 1)
+    {
+      m_allocatedObjectsCount = 0;
+      m_buf                   = nullptr;
+      m_size                  = 0;
+      this->m_refCounter      = nullptr;
+      return;
+    }
+
+    if (this->m_refCounter)
+    {
+      // Остались единственным владельцем
+      this->m_refCounter->store(1, std::memory_order_relaxed);
+    }
+  }
+
+  completeGrowth();
+
+  // Сохраненные объекты находятся за концом массива - разрушаются до
+  // обнуления размера
+  destroyRecycled();
+  destroyObjects();
+}
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename TItemType, typename TAllocatorType>
 bool
-CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::hasFreeSpace() const
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::hasFreeSpace() const
 {
   return m_size < m_allocatedObjectsCount;
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename TItemType, typename TAllocatorType>
 void
-CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::prepareToAddNewItem()
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::prepareToAddNewItem()
 {
   if (!hasFreeSpace())
   {
+    if constexpr (TPolicy::incrementalGrowth)
+    {
+      // Перенос завершается раньше, чем заполняется новый буфер, но
+      // на случай изменения шага доводим его до конца
+      completeGrowth();
+
+      if (m_size)
+      {
+        // Новый буфер выделяется без переноса элементов, старый сохраняется
+        // до завершения переноса порциями в growthStep()
+        const unsigned int newCapacity = m_size * 2;
+
+        this->m_oldBuf      = m_buf;
+        this->m_oldCapacity = m_allocatedObjectsCount;
+        this->m_migrateFrom = 0;
+        this->m_migrateTo   = m_size;
+
+        m_buf                   = m_allocator.allocate(newCapacity);
+        m_allocatedObjectsCount = newCapacity;
+        placeBuffer(m_buf, newCapacity);
+
+        this->noteGrowth(this->m_oldCapacity, newCapacity, m_size);
+        return;
+      }
+    }
+
     MemoryBuf<TData, TAllocatorType> newData(std::max<unsigned long>(size() * 2, 1));
 
     newData.moveObjectsFrom(*this);
 
     newData.swap(*this);
 
+    this->noteGrowth(newData.capacity(), m_allocatedObjectsCount, m_size);
     newData.destroyObjects();
   }
 }
 
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::growthStep()
+{
+  if constexpr (TPolicy::incrementalGrowth)
+  {
+    if (!this->m_oldBuf)
+    {
+      return;
+    }
+
+    const unsigned int migrateTo = std::min(this->m_migrateTo, this->m_migrateFrom + TPolicy::incrementalGrowthStep);
+    for ( ; this->m_migrateFrom < migrateTo; ++this->m_migrateFrom)
+    {
+      TItemType * pitem = this->m_oldBuf + this->m_migrateFrom;
+      new (m_buf + this->m_migrateFrom) TItemType(std::move(*pitem));
+      pitem->~TItemType();
+    }
+
+    if (this->m_migrateFrom == this->m_migrateTo)
+    {
+      m_allocator.deallocate(this->m_oldBuf, this->m_oldCapacity);
+
+      this->m_oldBuf      = nullptr;
+      this->m_oldCapacity = 0;
+      this->m_migrateFrom = 0;
+      this->m_migrateTo   = 0;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::completeGrowth()
+{
+  if constexpr (TPolicy::incrementalGrowth)
+  {
+    if (this->m_oldBuf)
+    {
+      if constexpr (std::is_trivially_copyable<TItemType>::value)
+      {
+        memcpy(m_buf + this->m_migrateFrom, this->m_oldBuf + this->m_migrateFrom,
+               (this->m_migrateTo - this->m_migrateFrom) * sizeof(TItemType));
+        this->m_migrateFrom = this->m_migrateTo;
+      }
+
+      while (this->m_oldBuf)
+      {
+        growthStep();
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+bool
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::contains(
+    const TItemType * _pitem
+  ) const
+{
+  if constexpr (TPolicy::incrementalGrowth)
+  {
+    if (this->m_oldBuf && this->m_oldBuf <= _pitem && _pitem < this->m_oldBuf + this->m_oldCapacity)
+    {
+      return true;
+    }
+  }
+
+  return m_buf && m_buf <= _pitem && _pitem < m_buf + m_allocatedObjectsCount;
+}
+
 #ifdef _DEBUG
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename TItemType, typename TAllocatorType>
 bool
-CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::isValidAddr(
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::isValidAddr(
     TData * _addr,
     size_t _bufSize
   )
@@ -873,52 +2084,69 @@ CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::isValidAddr(
 
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename TItemType, typename TAllocatorType>
-typename TItemType*
-CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::getPData(
+TItemType*
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::getPData(
     unsigned int _index
   )
 {
+  if constexpr (TPolicy::incrementalGrowth)
+  {
+    // Непереносенные элементы лежат в старом буфере по тем же индексам
+    if (_index - this->m_migrateFrom < this->m_migrateTo - this->m_migrateFrom)
+    {
+      return this->m_oldBuf + _index;
+    }
+  }
+
   return m_buf + _index;
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename TItemType, typename TAllocatorType>
-const typename TItemType*
-CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::getPData(
+const TItemType*
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::getPData(
     unsigned int _index
   ) const
 {
+  if constexpr (TPolicy::incrementalGrowth)
+  {
+    if (_index - this->m_migrateFrom < this->m_migrateTo - this->m_migrateFrom)
+    {
+      return this->m_oldBuf + _index;
+    }
+  }
+
   return m_buf + _index;
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename TItemType, typename TAllocatorType>
 TItemType&&
-CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::getPDataRValue(
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::getPDataRValue(
     unsigned int _index
   )
 {
-  return std::move(*(m_buf + _index));
+  return std::move(*getPData(_index));
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename TItemType, typename TAllocatorType>
 void
-CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::destroyObjects()
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::destroyObjects()
 {
   destroyObjects(0, m_size);
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename TItemType, typename TAllocatorType>
 void
-CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::destroyObjects(
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::destroyObjects(
     unsigned int _indexFrom,
     unsigned int _indexTo
   )
@@ -926,7 +2154,7 @@ CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::destroyObjects(
   assert(_indexFrom <= _indexTo);
   if (_indexFrom == _indexTo)
   {
-    //        -  
+    // Начальная и конечная границы удаляемого диапазона совпадают - просто выходим
     return;
   }
 
@@ -937,7 +2165,7 @@ CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::destroyObjects(
       for (auto index = _indexFrom; index < _indexTo; ++index)
       {
         TItemType* pitem = m_buf + index;
-        pitem->~TData();
+        pitem->~TItemType();
       }
     }
 
@@ -946,13 +2174,158 @@ CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::destroyObjects(
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+template <typename T>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::appendObj(
+    T&& _srcObj
+  )
+{
+  if constexpr (recycles)
+  {
+    if (this->m_recycled)
+    {
+      *getPData(m_size) = std::forward<T>(_srcObj);
+      ++m_size;
+      --this->m_recycled;
+      return;
+    }
+  }
+
+  constructFromObj(getPData(m_size), std::forward<T>(_srcObj));
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::recycleObjects(
+    unsigned int _size
+  )
+{
+  assert(_size <= m_size);
+
+  if constexpr (recycles)
+  {
+    this->m_recycled += m_size - _size;
+    m_size            = _size;
+  }
+  else
+  {
+    destroyObjects(_size, m_size);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::destroyRecycled()
+{
+  if constexpr (recycles)
+  {
+    for (unsigned int index = m_size; index < m_size + this->m_recycled; ++index)
+    {
+      m_buf[index].~TItemType();
+    }
+    this->m_recycled = 0;
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::moveRecycledFrom(
+    MemoryBuf<TItemType, TAllocator> & _dataSrc
+  )
+{
+  if constexpr (recycles)
+  {
+    assert(this->m_recycled == 0);
+
+    // Перемещенный объект сохраняет память источника (например, буфер строки)
+    const unsigned int count = std::min(_dataSrc.m_recycled, m_allocatedObjectsCount - m_size);
+    for (unsigned int index = 0; index < count; ++index)
+    {
+      new (m_buf + m_size + index) TItemType(std::move_if_noexcept(_dataSrc.m_buf[_dataSrc.m_size + index]));
+      ++this->m_recycled;
+    }
+
+    _dataSrc.destroyRecycled();
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::relocateRecycled(
+    unsigned int _indexTo,
+    unsigned int _indexFrom
+  )
+{
+  if constexpr (recycles)
+  {
+    assert(_indexTo <= m_allocatedObjectsCount);
+
+    const unsigned int count = std::min(this->m_recycled, m_allocatedObjectsCount - _indexTo);
+    for (unsigned int index = _indexFrom + count; index < _indexFrom + this->m_recycled; ++index)
+    {
+      m_buf[index].~TItemType();
+    }
+    this->m_recycled = count;
+
+    if (_indexTo > _indexFrom)
+    {
+      relocateObjectsRight(_indexTo, _indexFrom, count);
+    }
+    else
+    {
+      relocateObjects(_indexTo, _indexFrom, count);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::placeBuffer(
+    TItemType *  _buf,
+    unsigned int _capacity
+  )
+{
+  if constexpr (TPolicy::numaPlacement != CArrayNumaPlacement::none)
+  {
+    const size_t bytes = size_t(_capacity) * sizeof(TItemType);
+
+    numaPlaceBuffer(_buf, bytes, TPolicy::numaPlacement, TPolicy::numaNode);
+    numaFirstTouch(_buf, bytes, numaPartCount(TPolicy::numaPlacement));
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename TItemType, typename TAllocatorType>
 void
-CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::moveObjectsFrom(
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::moveObjectsFrom(
     MemoryBuf<TItemType, TAllocator> & _dataSrc
   )
 {
+  if constexpr (TPolicy::numaPlacement != CArrayNumaPlacement::none
+                && !TPolicy::incrementalGrowth
+                && std::is_trivially_copyable<TItemType>::value)
+  {
+    // Перенос частями в нескольких потоках
+    assert(m_size == 0 && _dataSrc.size() <= m_allocatedObjectsCount);
+
+    numaParallelCopy(m_buf, _dataSrc.m_buf, size_t(_dataSrc.size()) * sizeof(TItemType));
+    m_size = _dataSrc.size();
+    return;
+  }
+
   if (_dataSrc.size() > 0)
   {
     unsigned int index = 0;
@@ -968,10 +2341,26 @@ CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::moveObjectsFrom
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename TItemType, typename TAllocatorType>
 void
-CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::constructFrom(
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::copyObjectsFrom(
+    const MemoryBuf<TItemType, TAllocator> & _dataSrc
+  )
+{
+  assert(m_size == 0 && _dataSrc.size() <= m_allocatedObjectsCount);
+
+  for (unsigned int index = 0; index < _dataSrc.size(); ++index)
+  {
+    constructFromObj(getPData(index), *_dataSrc.getPData(index));
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::constructFrom(
     unsigned int _indexTo,
     MemoryBuf<TItemType, TAllocator> & _other,
     unsigned int _indexFrom
@@ -981,16 +2370,18 @@ CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::constructFrom(
 }
 
 //----------------------------------------------------------------------------//
-template <typename TData, typename TAllocator>
+template <typename TData, typename TAllocator, typename TPolicy>
 template <typename TItemType, typename TAllocatorType>
 template <typename T>
 void
-CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::constructFromObj(
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::constructFromObj(
     TData * _destRawBuf,
     T&& _srcObj
   )
 {
+#ifdef _DEBUG
   assert(isValidAddr(_destRawBuf, sizeof(TData)));
+#endif
 
   if constexpr (!std::is_trivially_constructible<TItemType>::value)
   {
@@ -1013,3 +2404,367 @@ CArray<TData, TAllocator>::MemoryBuf<TItemType, TAllocatorType>::constructFromOb
 }
 
 //----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::relocateObjects(
+    unsigned int _indexTo,
+    unsigned int _indexFrom,
+    unsigned int _count
+  )
+{
+  assert(_indexTo <= _indexFrom);
+  if (_indexTo == _indexFrom || _count == 0)
+  {
+    return;
+  }
+
+  if constexpr (std::is_trivially_copyable<TItemType>::value)
+  {
+    if (_count * sizeof(TItemType) < 64)
+    {
+      // Короткие серии дешевле перенести поэлементно, чем вызывать memmove.
+      // Перенос идет влево, поэтому прямой порядок не портит источник.
+      for (unsigned int index = 0; index < _count; ++index)
+      {
+        memcpy(m_buf + _indexTo + index, m_buf + _indexFrom + index, sizeof(TItemType));
+      }
+    }
+    else
+    {
+      memmove(m_buf + _indexTo, m_buf + _indexFrom, _count * sizeof(TItemType));
+    }
+  }
+  else
+  {
+    for (unsigned int index = 0; index < _count; ++index)
+    {
+      TItemType * pitem = m_buf + _indexFrom + index;
+      new (m_buf + _indexTo + index) TItemType(std::move(*pitem));
+      pitem->~TItemType();
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::relocateObjectsRight(
+    unsigned int _indexTo,
+    unsigned int _indexFrom,
+    unsigned int _count
+  )
+{
+  assert(_indexFrom <= _indexTo);
+  if (_indexTo == _indexFrom || _count == 0)
+  {
+    return;
+  }
+
+  if constexpr (std::is_trivially_copyable<TItemType>::value)
+  {
+    memmove(m_buf + _indexTo, m_buf + _indexFrom, _count * sizeof(TItemType));
+  }
+  else
+  {
+    // Перенос вправо - обходим с конца, чтобы не затереть источник
+    for (unsigned int index = _count; index-- > 0; )
+    {
+      TItemType * pitem = m_buf + _indexFrom + index;
+      new (m_buf + _indexTo + index) TItemType(std::move(*pitem));
+      pitem->~TItemType();
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+template <typename TPositionAt, typename TValueAt>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::insertObjects(
+    unsigned int  _count,
+    TPositionAt & _positionAt,
+    TValueAt &    _valueAt
+  )
+{
+  const unsigned int dataSize = m_size;
+  const unsigned int newSize  = dataSize + _count;
+
+  if (newSize > m_allocatedObjectsCount)
+  {
+    // Памяти не хватает - собираем результат в новом буфере по порядку
+    MemoryBuf<TItemType, TAllocator> newData(std::max(newSize, dataSize * 2));
+
+    unsigned int fromIdx = 0;
+    for (unsigned int index = 0; index < _count; ++index)
+    {
+      for (const unsigned int position = _positionAt(index); fromIdx < position; ++fromIdx)
+      {
+        newData.constructFrom(newData.size(), *this, fromIdx);
+      }
+
+      newData.constructFromObj(newData.getPData(newData.size()), _valueAt(index));
+    }
+
+    for ( ; fromIdx < dataSize; ++fromIdx)
+    {
+      newData.constructFrom(newData.size(), *this, fromIdx);
+    }
+    newData.moveRecycledFrom(*this);
+
+    swap(newData);
+
+    this->noteGrowth(newData.capacity(), m_allocatedObjectsCount, dataSize);
+    newData.destroyObjects();
+    return;
+  }
+
+  // Раздвигаем элементы с конца: [0, readEnd) - исходные объекты,
+  // [readEnd, writeEnd) - свободные места, [writeEnd, newSize) - результат
+  unsigned int readEnd  = dataSize;
+  unsigned int writeEnd = newSize;
+
+  // Вставка создает объекты в памяти за концом массива - сохраненные
+  // объекты сдвигаются за новый конец
+  relocateRecycled(newSize, dataSize);
+
+  try
+  {
+    for (unsigned int index = _count; index-- > 0; )
+    {
+      const unsigned int position = _positionAt(index);
+      const unsigned int runSize  = readEnd - position;
+
+      relocateObjectsRight(writeEnd - runSize, position, runSize);
+      readEnd   = position;
+      writeEnd -= runSize;
+
+      new (m_buf + writeEnd - 1) TItemType(_valueAt(index));
+      --writeEnd;
+    }
+  }
+  catch (...)
+  {
+    // Смыкаем уже размещенную часть с исходным началом массива
+    relocateObjects(readEnd, writeEnd, newSize - writeEnd);
+    m_size = readEnd + (newSize - writeEnd);
+    relocateRecycled(m_size, newSize);
+    throw;
+  }
+
+  m_size = newSize;
+  this->noteInsertShift(dataSize - readEnd);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::permuteObjects(
+    const unsigned int * _order
+  )
+{
+  assert(!isShared());
+
+  if constexpr (TPolicy::incrementalGrowth)
+  {
+    assert(this->m_oldBuf == nullptr);
+  }
+
+  MemoryBuf newData(m_allocatedObjectsCount);
+  for (unsigned int index = 0; index < m_size; ++index)
+  {
+    newData.constructFrom(index, *this, _order[index]);
+  }
+  newData.m_size = m_size;
+  newData.moveRecycledFrom(*this);
+
+  swap(newData);
+  newData.destroyObjects();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+void
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::eraseObjects(
+    unsigned int _indexFrom,
+    unsigned int _indexTo
+  )
+{
+  assert(_indexFrom <= _indexTo && _indexTo <= m_size);
+
+  const unsigned int tailSize = m_size - _indexTo;
+
+  if constexpr (recycles)
+  {
+    // Удаляемые объекты обменами переносятся за конец массива вместе
+    // со своей памятью
+    std::rotate(m_buf + _indexFrom, m_buf + _indexTo, m_buf + m_size);
+    recycleObjects(m_size - (_indexTo - _indexFrom));
+
+    if (_indexFrom < _indexTo)
+    {
+      this->noteEraseShift(tailSize);
+    }
+    return;
+  }
+
+  destroyObjects(_indexFrom, _indexTo);
+  relocateObjects(_indexFrom, _indexTo, tailSize);
+
+  if (_indexFrom < _indexTo)
+  {
+    this->noteEraseShift(tailSize);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+template <typename TRemoveCheck>
+unsigned int
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::eraseObjectsIf(
+    TRemoveCheck & _removeCheck,
+    unsigned int   _chunkCount
+  )
+{
+  // Уплотнение оставляет неинициализированную память перед сохраненными
+  // объектами, они переносятся к новому концу массива
+  const unsigned int count = m_size;
+
+  if (_chunkCount <= 1)
+  {
+    unsigned int removedCount = 0;
+    unsigned int movedCount   = 0;
+    try
+    {
+      compactRange(0, count, _removeCheck, removedCount, movedCount);
+    }
+    catch (...)
+    {
+      // Уже удаленные объекты не восстанавливаются, остальные сдвинуты
+      m_size -= removedCount;
+      relocateRecycled(m_size, count);
+      this->noteEraseShift(movedCount);
+      throw;
+    }
+
+    m_size -= removedCount;
+    relocateRecycled(m_size, count);
+    this->noteEraseShift(movedCount);
+    return removedCount;
+  }
+
+  // Каждая часть уплотняется к своему началу в отдельном потоке,
+  // затем сохранившиеся серии переносятся на итоговые места
+  std::unique_ptr<unsigned int[]> survivors(new unsigned int[_chunkCount]);
+  std::unique_ptr<unsigned int[]> moved(new unsigned int[_chunkCount]);
+
+  // Исключение условия перехватывается в своей части: часть все равно
+  // уплотняется, а исключение передается вызывающему после сборки
+  std::unique_ptr<std::exception_ptr[]> errors(new std::exception_ptr[_chunkCount]);
+
+  parallelForChunks(count, _chunkCount,
+                    [this, &_removeCheck, &survivors, &moved, &errors](unsigned int _chunkIndex,
+                                                                       unsigned int _indexFrom,
+                                                                       unsigned int _indexTo)
+                    {
+                      unsigned int removedCount = 0;
+                      moved[_chunkIndex]     = 0;
+                      try
+                      {
+                        survivors[_chunkIndex] = compactRange(_indexFrom, _indexTo, _removeCheck,
+                                                              removedCount, moved[_chunkIndex]);
+                      }
+                      catch (...)
+                      {
+                        // compactRange сомкнула оставшиеся объекты части
+                        survivors[_chunkIndex] = _indexTo - _indexFrom - removedCount;
+                        moved[_chunkIndex]     = survivors[_chunkIndex];
+                        errors[_chunkIndex]    = std::current_exception();
+                      }
+                    });
+
+  unsigned int toIdx      = survivors[0];
+  unsigned int movedCount = moved[0];
+  for (unsigned int chunkIndex = 1; chunkIndex < _chunkCount; ++chunkIndex)
+  {
+    const unsigned int chunkFrom = parallelChunkBound(count, _chunkCount, chunkIndex);
+
+    relocateObjects(toIdx, chunkFrom, survivors[chunkIndex]);
+    movedCount += moved[chunkIndex] + (toIdx != chunkFrom ? survivors[chunkIndex] : 0);
+    toIdx      += survivors[chunkIndex];
+  }
+
+  m_size = toIdx;
+  relocateRecycled(m_size, count);
+  this->noteEraseShift(movedCount);
+
+  for (unsigned int chunkIndex = 0; chunkIndex < _chunkCount; ++chunkIndex)
+  {
+    if (errors[chunkIndex])
+    {
+      std::rethrow_exception(errors[chunkIndex]);
+    }
+  }
+
+  return count - toIdx;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator, typename TPolicy>
+template <typename TItemType, typename TAllocatorType>
+template <typename TRemoveCheck>
+unsigned int
+CArray<TData, TAllocator, TPolicy>::MemoryBuf<TItemType, TAllocatorType>::compactRange(
+    unsigned int   _indexFrom,
+    unsigned int   _indexTo,
+    TRemoveCheck & _removeCheck,
+    unsigned int & _removedCount,
+    unsigned int & _movedCount
+  )
+{
+  unsigned int toIdx   = _indexFrom;   //< Куда переносится очередная серия
+  unsigned int runFrom = _indexFrom;   //< Начало серии сохраняемых объектов
+
+  try
+  {
+    for (unsigned int index = _indexFrom; index < _indexTo; ++index)
+    {
+      TItemType * pitem = m_buf + index;
+      if (_removeCheck(index, *pitem))
+      {
+        if (toIdx != runFrom)
+        {
+          _movedCount += index - runFrom;
+        }
+        relocateObjects(toIdx, runFrom, index - runFrom);
+        toIdx  += index - runFrom;
+        runFrom = index + 1;
+
+        pitem->~TItemType();
+        ++_removedCount;
+      }
+    }
+  }
+  catch (...)
+  {
+    relocateObjects(toIdx, runFrom, _indexTo - runFrom);
+    throw;
+  }
+
+  // Сдвинуты все объекты, сохранившиеся после первого удаленного
+  if (toIdx != runFrom)
+  {
+    _movedCount += _indexTo - runFrom;
+  }
+  relocateObjects(toIdx, runFrom, _indexTo - runFrom);
+  toIdx += _indexTo - runFrom;
+
+  return toIdx - _indexFrom;
+}
+
+//----------------------------------------------------------------------------//
@@ -0,0 +1,745 @@
+// CArrayBenchmark.cpp : Сравнение производительности CArray и std::vector.
+//
+// Результат выводится в stdout в формате JSON. Параметры командной строки:
+//   --max-size N     максимальный размер массива (по умолчанию 1000000)
+//   --max-bytes N    предел памяти под элементы одного массива (по умолчанию 2 ГБ)
+//   --repeat N       количество повторов замера, берется лучший (по умолчанию 3)
+//   --type NAME      выполнить только для типа int, string или pod
+//   --op NAME        выполнить только одну операцию
+//   --max-ratio R    код возврата 2, если CArray медленнее std::vector более чем в R раз
+//
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <functional>
+
+#ifdef __linux__
+#  include <unistd.h>
+#  include <sys/ioctl.h>
+#  include <sys/syscall.h>
+#  include <linux/perf_event.h>
+#endif
+
+#include "CArray.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Учет выделений памяти контейнерами
+////////////////////////////////////////////////////////////////////////////////
+// Перевыделением считается выделение, после которого освобождается меньший
+// блок того же типа: так растут и CArray, и std::vector (новый буфер,
+// перенос элементов, освобождение старого).
+struct AllocationStats
+{
+  unsigned long long bytes         = 0;
+  unsigned long long allocations   = 0;
+  unsigned long long reallocations = 0;
+
+  const void *       lastType      = nullptr;  //< Тип последнего выделения
+  std::size_t        lastCount     = 0;        //< Размер последнего выделения
+};
+
+static AllocationStats g_allocationStats;
+
+template <typename T>
+class CountingAllocator
+{
+public:
+
+  using value_type = T;
+
+  CountingAllocator() = default;
+
+  template <typename U>
+  CountingAllocator(
+      const CountingAllocator<U> &
+    )
+  {
+  }
+
+  T * allocate(
+      std::size_t _count
+    )
+  {
+    g_allocationStats.bytes += _count * sizeof(T);
+    ++g_allocationStats.allocations;
+    g_allocationStats.lastType  = typeTag();
+    g_allocationStats.lastCount = _count;
+
+    return std::allocator<T>().allocate(_count);
+  }
+
+  void deallocate(
+      T *         _ptr,
+      std::size_t _count
+    )
+  {
+    if (g_allocationStats.lastType == typeTag() && _count < g_allocationStats.lastCount)
+    {
+      ++g_allocationStats.reallocations;
+    }
+    g_allocationStats.lastType = nullptr;
+
+    std::allocator<T>().deallocate(_ptr, _count);
+  }
+
+  template <typename U>
+  bool operator==(
+      const CountingAllocator<U> &
+    ) const
+  {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(
+      const CountingAllocator<U> &
+    ) const
+  {
+    return false;
+  }
+
+private:
+
+  // Признак типа элементов
+  static const void * typeTag()
+  {
+    static const char tag = 0;
+    return &tag;
+  }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Аппаратные счетчики через perf_event_open (только Linux)
+////////////////////////////////////////////////////////////////////////////////
+class PerfCounters
+{
+public:
+
+  static constexpr unsigned int CountersCount = 4;
+
+  PerfCounters()
+  {
+#ifdef __linux__
+    const uint64_t configs[CountersCount] =
+    {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    for (unsigned int index = 0; index < CountersCount; ++index)
+    {
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size           = sizeof(attr);
+      attr.type           = PERF_TYPE_HARDWARE;
+      attr.config         = configs[index];
+      attr.disabled       = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv     = 1;
+
+      m_fd[index] = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+  }
+
+  ~PerfCounters()
+  {
+#ifdef __linux__
+    for (int fd : m_fd)
+    {
+      if (fd >= 0)
+      {
+        close(fd);
+      }
+    }
+#endif
+  }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters& operator=(const PerfCounters &) = delete;
+
+  static const char * name(
+      unsigned int _index
+    )
+  {
+    static const char * names[CountersCount] = { "cycles", "instructions", "cache_misses", "branch_misses" };
+    return names[_index];
+  }
+
+  bool available(
+      unsigned int _index
+    ) const
+  {
+    return m_fd[_index] >= 0;
+  }
+
+  void start()
+  {
+#ifdef __linux__
+    for (int fd : m_fd)
+    {
+      if (fd >= 0)
+      {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+#endif
+  }
+
+  void stop(
+      unsigned long long (&_values)[CountersCount]
+    )
+  {
+    for (unsigned int index = 0; index < CountersCount; ++index)
+    {
+      _values[index] = 0;
+#ifdef __linux__
+      if (m_fd[index] >= 0)
+      {
+        ioctl(m_fd[index], PERF_EVENT_IOC_DISABLE, 0);
+        if (read(m_fd[index], &_values[index], sizeof(_values[index])) != sizeof(_values[index]))
+        {
+          _values[index] = 0;
+        }
+      }
+#endif
+    }
+  }
+
+private:
+
+  int m_fd[CountersCount] = { -1, -1, -1, -1 };
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Типы элементов
+////////////////////////////////////////////////////////////////////////////////
+struct LargePod
+{
+  uint64_t key;
+  char     payload[248];
+
+  bool operator<(
+      const LargePod & _other
+    ) const
+  {
+    return key < _other.key;
+  }
+};
+
+//----------------------------------------------------------------------------//
+inline void makeValue(
+    uint64_t _seed,
+    int &    _value
+  )
+{
+  _value = static_cast<int>(_seed);
+}
+
+//----------------------------------------------------------------------------//
+inline void makeValue(
+    uint64_t      _seed,
+    std::string & _value
+  )
+{
+  // Длина от 8 до 40 символов: часть строк помещается в SSO, часть - нет
+  _value = "value_" + std::to_string(_seed);
+  _value.resize(8 + _seed % 33, 'x');
+}
+
+//----------------------------------------------------------------------------//
+inline void makeValue(
+    uint64_t   _seed,
+    LargePod & _value
+  )
+{
+  _value.key = _seed;
+  memset(_value.payload, static_cast<int>(_seed & 0xFF), sizeof(_value.payload));
+}
+
+//----------------------------------------------------------------------------//
+inline uint64_t keyOf(
+    int _value
+  )
+{
+  return static_cast<unsigned int>(_value);
+}
+
+//----------------------------------------------------------------------------//
+inline uint64_t keyOf(
+    const std::string & _value
+  )
+{
+  return _value.size() + static_cast<unsigned char>(_value[6]);
+}
+
+//----------------------------------------------------------------------------//
+inline uint64_t keyOf(
+    const LargePod & _value
+  )
+{
+  return _value.key;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Единый интерфейс операций над сравниваемыми контейнерами
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+using BenchCArray = CArray<T, CountingAllocator<T>>;
+
+template <typename T>
+using BenchVector = std::vector<T, CountingAllocator<T>>;
+
+//----------------------------------------------------------------------------//
+template <typename T>
+void insertAt(
+    BenchCArray<T> & _array,
+    unsigned int     _index,
+    const T &        _value
+  )
+{
+  _array.insert(_index, _value);
+}
+
+//----------------------------------------------------------------------------//
+template <typename T>
+void insertAt(
+    BenchVector<T> & _array,
+    unsigned int     _index,
+    const T &        _value
+  )
+{
+  _array.insert(_array.begin() + _index, _value);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TContainer>
+void eraseRange(
+    TContainer & _array,
+    unsigned int _indexFrom,
+    unsigned int _indexTo
+  )
+{
+  _array.erase(_array.begin() + _indexFrom, _array.begin() + _indexTo);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Замер
+////////////////////////////////////////////////////////////////////////////////
+struct BenchResult
+{
+  std::string        container;
+  std::string        type;
+  std::string        operation;
+  unsigned int       size          = 0;
+  unsigned long long ops           = 0;
+  double             nsPerOp       = 0;
+  unsigned long long bytes         = 0;
+  unsigned long long allocations   = 0;
+  unsigned long long reallocations = 0;
+  unsigned long long counters[PerfCounters::CountersCount] = {};
+};
+
+struct BenchOptions
+{
+  unsigned int       maxSize  = 1000000;
+  unsigned long long maxBytes = 2ull << 30;
+  unsigned int       repeat   = 3;
+  std::string        type;
+  std::string        operation;
+  double             maxRatio = 0;
+};
+
+static PerfCounters *            g_perfCounters = nullptr;
+static std::vector<BenchResult>  g_results;
+
+// Объем работы одного замера, для малых массивов операция повторяется
+// над несколькими копиями
+constexpr unsigned long long BenchTargetOps = 200000;
+
+// Объем данных, перемещаемых при вставках и удалениях за один замер
+constexpr unsigned long long BenchShiftBytes = 1ull << 28;
+
+//----------------------------------------------------------------------------//
+// Выполнить замер: _prepare(batch) готовит входные данные вне замера,
+// _run() выполняет операцию и возвращает количество элементарных операций
+template <typename TPrepare, typename TRun>
+void measure(
+    const BenchOptions & _options,
+    BenchResult          _result,
+    TPrepare &&          _prepare,
+    TRun &&              _run
+  )
+{
+  double bestNs = -1;
+
+  for (unsigned int attempt = 0; attempt < _options.repeat; ++attempt)
+  {
+    _prepare();
+
+    g_allocationStats = AllocationStats();
+
+    unsigned long long counters[PerfCounters::CountersCount];
+    g_perfCounters->start();
+    const auto timeStart = std::chrono::steady_clock::now();
+
+    const unsigned long long ops = _run();
+
+    const auto timeStop = std::chrono::steady_clock::now();
+    g_perfCounters->stop(counters);
+
+    const double ns = std::chrono::duration<double, std::nano>(timeStop - timeStart).count();
+    if (bestNs < 0 || ns < bestNs)
+    {
+      bestNs                = ns;
+      _result.ops           = ops;
+      _result.bytes         = g_allocationStats.bytes;
+      _result.allocations   = g_allocationStats.allocations;
+      _result.reallocations = g_allocationStats.reallocations;
+      std::copy(counters, counters + PerfCounters::CountersCount, _result.counters);
+    }
+  }
+
+  _result.nsPerOp = _result.ops ? bestNs / _result.ops : 0;
+  g_results.push_back(_result);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TContainer, typename T>
+void benchContainer(
+    const BenchOptions &   _options,
+    const char *           _containerName,
+    const char *           _typeName,
+    const std::vector<T> & _source
+  )
+{
+  const unsigned int size  = static_cast<unsigned int>(_source.size());
+  const unsigned int batch = static_cast<unsigned int>(std::max<unsigned long long>(1, BenchTargetOps / size));
+
+  // Количество вставок и удалений со сдвигом хвоста ограничено объемом
+  // перемещаемых данных, иначе большие массивы и типы замеряются часами
+  const unsigned long long shiftOps = std::max<unsigned long long>(1, BenchShiftBytes / sizeof(T) / (static_cast<unsigned long long>(size) * batch));
+
+  BenchResult result;
+  result.container = _containerName;
+  result.type      = _typeName;
+  result.size      = size;
+
+  std::vector<TContainer> arrays;
+  auto fillArrays = [&]()
+  {
+    arrays.clear();
+    arrays.resize(batch);
+    for (auto & array : arrays)
+    {
+      for (const T & value : _source)
+      {
+        array.push_back(value);
+      }
+    }
+  };
+  auto clearArrays = [&]()
+  {
+    arrays.clear();
+    arrays.resize(batch);
+  };
+
+  auto enabled = [&](const char * _operation)
+  {
+    return _options.operation.empty() || _options.operation == _operation;
+  };
+
+  if (enabled("push_back"))
+  {
+    result.operation = "push_back";
+    measure(_options, result, clearArrays, [&]()
+            {
+              for (auto & array : arrays)
+              {
+                for (const T & value : _source)
+                {
+                  array.push_back(value);
+                }
+              }
+              return static_cast<unsigned long long>(size) * batch;
+            });
+  }
+
+  if (enabled("emplace_back"))
+  {
+    result.operation = "emplace_back";
+    measure(_options, result, clearArrays, [&]()
+            {
+              for (auto & array : arrays)
+              {
+                for (const T & value : _source)
+                {
+                  array.emplace_back(value);
+                }
+              }
+              return static_cast<unsigned long long>(size) * batch;
+            });
+  }
+
+  if (enabled("insert_random"))
+  {
+    const unsigned int inserts = static_cast<unsigned int>(std::min<unsigned long long>(1000, shiftOps));
+
+    result.operation = "insert_random";
+    measure(_options, result, fillArrays, [&]()
+            {
+              std::mt19937 random(size);
+              for (auto & array : arrays)
+              {
+                for (unsigned int index = 0; index < inserts; ++index)
+                {
+                  insertAt(array, random() % (array.size() + 1), _source[index % size]);
+                }
+              }
+              return static_cast<unsigned long long>(inserts) * batch;
+            });
+  }
+
+  if (enabled("erase_range"))
+  {
+    const unsigned int width  = std::max(1u, size / 1000);
+    const unsigned int erases = static_cast<unsigned int>(std::min<unsigned long long>({ 100, shiftOps, std::max(1u, size / 2 / width) }));
+
+    result.operation = "erase_range";
+    measure(_options, result, fillArrays, [&]()
+            {
+              std::mt19937 random(size);
+              for (auto & array : arrays)
+              {
+                for (unsigned int index = 0; index < erases && array.size() >= width; ++index)
+                {
+                  const unsigned int from = random() % (array.size() - width + 1);
+                  eraseRange(array, from, from + width);
+                }
+              }
+              return static_cast<unsigned long long>(erases) * batch;
+            });
+  }
+
+  if (enabled("sort"))
+  {
+    result.operation = "sort";
+    measure(_options, result, fillArrays, [&]()
+            {
+              for (auto & array : arrays)
+              {
+                std::sort(array.begin(), array.end());
+              }
+              return static_cast<unsigned long long>(size) * batch;
+            });
+  }
+
+  if (enabled("remove_if"))
+  {
+    result.operation = "remove_if";
+    measure(_options, result, fillArrays, [&]()
+            {
+              for (auto & array : arrays)
+              {
+                auto itEnd = std::remove_if(array.begin(), array.end(),
+                                            [](const T & _value) { return keyOf(_value) % 3 == 0; });
+                array.erase(itEnd, array.end());
+              }
+              return static_cast<unsigned long long>(size) * batch;
+            });
+  }
+
+  if (enabled("iterate"))
+  {
+    result.operation = "iterate";
+    measure(_options, result, fillArrays, [&]()
+            {
+              uint64_t sum = 0;
+              for (const auto & array : arrays)
+              {
+                for (const T & value : array)
+                {
+                  sum += keyOf(value);
+                }
+              }
+
+              // Не даем компилятору выбросить цикл
+              volatile uint64_t sink = sum;
+              (void)sink;
+
+              return static_cast<unsigned long long>(size) * batch;
+            });
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename T>
+void benchType(
+    const BenchOptions & _options,
+    const char *         _typeName
+  )
+{
+  if (!_options.type.empty() && _options.type != _typeName)
+  {
+    return;
+  }
+
+  for (unsigned long long size = 10; size <= _options.maxSize; size *= 10)
+  {
+    // Пропускаем размеры, для которых исходные данные и массивы не поместятся в память
+    if (size * sizeof(T) * 3 > _options.maxBytes)
+    {
+      break;
+    }
+
+    std::vector<T> source(static_cast<size_t>(size));
+    std::mt19937_64 random(size);
+    for (T & value : source)
+    {
+      makeValue(random(), value);
+    }
+
+    benchContainer<BenchVector<T>>(_options, "std::vector", _typeName, source);
+    benchContainer<BenchCArray<T>>(_options, "CArray", _typeName, source);
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Вывод результатов
+////////////////////////////////////////////////////////////////////////////////
+static bool printResults(
+    const BenchOptions & _options
+  )
+{
+  bool passed = true;
+
+  printf("{\n  \"suite\": \"CArrayBenchmark\",\n  \"repeat\": %u,\n  \"perf_counters\": {", _options.repeat);
+  for (unsigned int index = 0; index < PerfCounters::CountersCount; ++index)
+  {
+    printf("%s\"%s\": %s", index ? ", " : "", PerfCounters::name(index),
+           g_perfCounters->available(index) ? "true" : "false");
+  }
+  printf("},\n  \"results\": [");
+
+  for (size_t index = 0; index < g_results.size(); ++index)
+  {
+    const BenchResult & result = g_results[index];
+    printf("%s\n    {\"container\": \"%s\", \"type\": \"%s\", \"operation\": \"%s\", \"size\": %u, "
+           "\"ops\": %llu, \"ns_per_op\": %.3f, \"bytes_allocated\": %llu, \"allocations\": %llu, \"reallocations\": %llu",
+           index ? "," : "", result.container.c_str(), result.type.c_str(), result.operation.c_str(),
+           result.size, result.ops, result.nsPerOp, result.bytes, result.allocations, result.reallocations);
+
+    for (unsigned int counter = 0; counter < PerfCounters::CountersCount; ++counter)
+    {
+      if (g_perfCounters->available(counter))
+      {
+        printf(", \"%s\": %llu", PerfCounters::name(counter), result.counters[counter]);
+      }
+    }
+    printf("}");
+  }
+
+  // Отношение времени CArray к std::vector для каждой пары замеров
+  printf("\n  ],\n  \"comparisons\": [");
+  bool first = true;
+  for (const BenchResult & baseline : g_results)
+  {
+    if (baseline.container != "std::vector")
+    {
+      continue;
+    }
+
+    for (const BenchResult & result : g_results)
+    {
+      if (result.container != "CArray" || result.type != baseline.type
+          || result.operation != baseline.operation || result.size != baseline.size)
+      {
+        continue;
+      }
+
+      const double ratio      = baseline.nsPerOp > 0 ? result.nsPerOp / baseline.nsPerOp : 0;
+      const bool   regression = _options.maxRatio > 0 && ratio > _options.maxRatio;
+      passed = passed && !regression;
+
+      printf("%s\n    {\"type\": \"%s\", \"operation\": \"%s\", \"size\": %u, \"ratio_to_vector\": %.3f, \"regression\": %s}",
+             first ? "" : ",", result.type.c_str(), result.operation.c_str(), result.size, ratio,
+             regression ? "true" : "false");
+      first = false;
+    }
+  }
+  printf("\n  ],\n  \"passed\": %s\n}\n", passed ? "true" : "false");
+
+  return passed;
+}
+
+//----------------------------------------------------------------------------//
+int main(
+    int    _argc,
+    char * _argv[]
+  )
+{
+  BenchOptions options;
+
+  for (int index = 1; index < _argc; ++index)
+  {
+    const std::string argument = _argv[index];
+    const char *      value    = index + 1 < _argc ? _argv[index + 1] : nullptr;
+
+    if (!value)
+    {
+      fprintf(stderr, "Missing value for %s\n", argument.c_str());
+      return 1;
+    }
+
+    if (argument == "--max-size")
+    {
+      options.maxSize = static_cast<unsigned int>(strtoul(value, nullptr, 10));
+    }
+    else if (argument == "--max-bytes")
+    {
+      options.maxBytes = strtoull(value, nullptr, 10);
+    }
+    else if (argument == "--repeat")
+    {
+      options.repeat = std::max(1u, static_cast<unsigned int>(strtoul(value, nullptr, 10)));
+    }
+    else if (argument == "--type")
+    {
+      options.type = value;
+    }
+    else if (argument == "--op")
+    {
+      options.operation = value;
+    }
+    else if (argument == "--max-ratio")
+    {
+      options.maxRatio = strtod(value, nullptr);
+    }
+    else
+    {
+      fprintf(stderr, "Unknown option %s\n", argument.c_str());
+      return 1;
+    }
+
+    ++index;
+  }
+
+  PerfCounters perfCounters;
+  g_perfCounters = &perfCounters;
+
+  benchType<int>(options, "int");
+  benchType<std::string>(options, "string");
+  benchType<LargePod>(options, "pod");
+
+  return printResults(options) ? 0 : 2;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef _MSC_VER
+#  include <intrin.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Операции над 64-битными словами битовых карт
+
+//----------------------------------------------------------------------------//
+// Количество установленных битов
+inline unsigned int bitCount(
+    uint64_t _word
+  )
+{
+#ifdef _MSC_VER
+#  ifdef _WIN64
+  return static_cast<unsigned int>(__popcnt64(_word));
+#  else
+  return __popcnt(static_cast<unsigned int>(_word)) + __popcnt(static_cast<unsigned int>(_word >> 32));
+#  endif
+#else
+  return static_cast<unsigned int>(__builtin_popcountll(_word));
+#endif
+}
+
+//----------------------------------------------------------------------------//
+// Индекс младшего установленного бита (слово не должно быть нулевым)
+inline unsigned int lowestBitIndex(
+    uint64_t _word
+  )
+{
+#ifdef _MSC_VER
+  unsigned long index = 0;
+#  ifdef _WIN64
+  _BitScanForward64(&index, _word);
+#  else
+  if (!_BitScanForward(&index, static_cast<unsigned long>(_word)))
+  {
+    _BitScanForward(&index, static_cast<unsigned long>(_word >> 32));
+    index += 32;
+  }
+#  endif
+  return static_cast<unsigned int>(index);
+#else
+  return static_cast<unsigned int>(__builtin_ctzll(_word));
+#endif
+}
+
+//----------------------------------------------------------------------------//
+// Индекс старшего установленного бита (слово не должно быть нулевым)
+inline unsigned int highestBitIndex(
+    uint64_t _word
+  )
+{
+#ifdef _MSC_VER
+  unsigned long index = 0;
+#  ifdef _WIN64
+  _BitScanReverse64(&index, _word);
+#  else
+  if (_BitScanReverse(&index, static_cast<unsigned long>(_word >> 32)))
+  {
+    index += 32;
+  }
+  else
+  {
+    _BitScanReverse(&index, static_cast<unsigned long>(_word));
+  }
+#  endif
+  return static_cast<unsigned int>(index);
+#else
+  return 63u - static_cast<unsigned int>(__builtin_clzll(_word));
+#endif
+}
+
+//----------------------------------------------------------------------------//
+// Индекс _rank-го (с нуля) установленного бита слова
+inline unsigned int selectBit(
+    uint64_t     _word,
+    unsigned int _rank
+  )
+{
+  // Сначала пропускаем целые байты, затем биты внутри байта
+  unsigned int base = 0;
+  for (;;)
+  {
+    const unsigned int byteBits = bitCount(_word & 0xFF);
+    if (_rank < byteBits)
+    {
+      break;
+    }
+
+    _rank -= byteBits;
+    _word >>= 8;
+    base  += 8;
+  }
+
+  for ( ; _rank; --_rank)
+  {
+    _word &= _word - 1;
+  }
+
+  return base + lowestBitIndex(_word);
+}
+
+//----------------------------------------------------------------------------//
+// Маска из _count младших битов (_count <= 64)
+inline uint64_t lowBitsMask(
+    unsigned int _count
+  )
+{
+  return _count >= 64 ? ~uint64_t(0) : ((uint64_t(1) << _count) - 1);
+}
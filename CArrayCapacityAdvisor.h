@@ -0,0 +1,303 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__has_include)
+#  if __has_include(<version>)
+#    include <version>
+#  endif
+#endif
+
+#ifdef __cpp_lib_source_location
+#  include <source_location>
+#endif
+
+#include "CArrayBits.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// class CArrayCapacitySite - история итоговых размеров массивов, созданных
+// в одном месте программы, и прогноз начальной емкости для следующих.
+// Все операции неблокирующие и могут вызываться из разных потоков.
+class CArrayCapacitySite
+{
+public:
+
+  // _percentile - доля массивов (в процентах), которым прогноз должен
+  // хватить без увеличения буфера
+  explicit CArrayCapacitySite(
+      unsigned int _percentile = 95
+    )
+    : m_percentile(_percentile)
+  {
+  }
+
+  CArrayCapacitySite(const CArrayCapacitySite &) = delete;
+  CArrayCapacitySite& operator=(const CArrayCapacitySite &) = delete;
+
+  // Место, заданное строковым ключом
+  static CArrayCapacitySite & forKey(
+      const char * _key
+    );
+
+#ifdef __cpp_lib_source_location
+  // Место вызова: CArray<...> array(CArrayCapacitySite::current());
+  static CArrayCapacitySite & current(
+      const std::source_location & _location = std::source_location::current()
+    );
+#endif
+
+  // Учесть итоговый размер очередного массива
+  void record(
+      unsigned int _size
+    );
+
+  // Получить прогноз начальной емкости (0 - истории пока недостаточно)
+  unsigned int predictCapacity() const
+  {
+    return m_prediction.load(std::memory_order_relaxed);
+  }
+
+private:
+
+  friend class CArrayCapacitySiteTable;
+
+  CArrayCapacitySite(
+      unsigned int _percentile,
+      bool         _enabled
+    )
+    : m_percentile(_percentile),
+      m_enabled   (_enabled)
+  {
+  }
+
+  // Размеры группируются по степеням двойки с 4 подгруппами в каждой,
+  // так что прогноз превышает фактический размер не более чем на четверть
+  static constexpr unsigned int BucketsCount = 124;
+
+  // Количество записей, после которого пересчитывается прогноз
+  static constexpr unsigned int RecalculatePeriod = 32;
+
+  // Количество записей, после которого история уполовинивается,
+  // чтобы прогноз следовал за изменением нагрузки
+  static constexpr unsigned int DecayThreshold = 1u << 16;
+
+  static unsigned int bucketIndex(
+      unsigned int _size
+    );
+
+  static unsigned int bucketUpperBound(
+      unsigned int _bucket
+    );
+
+  void recalculate();
+
+private:
+
+  unsigned int               m_percentile;
+  bool                       m_enabled = true;               //< Выключено для переполненной таблицы мест
+  std::atomic<unsigned int>  m_buckets[BucketsCount] = {};
+  std::atomic<unsigned int>  m_recorded{0};
+  std::atomic<unsigned int>  m_prediction{0};
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CArrayCapacitySiteTable - места, найденные по ключу или по
+// source_location. Открытая адресация с захватом ячейки через CAS.
+class CArrayCapacitySiteTable
+{
+public:
+
+  static CArrayCapacitySite & find(
+      uint64_t _key
+    )
+  {
+    static Slot slots[SlotsCount];
+
+    // Ключ 0 означает свободную ячейку
+    _key |= 1;
+
+    for (unsigned int probe = 0; probe < SlotsCount; ++probe)
+    {
+      Slot & slot = slots[(_key + probe) & (SlotsCount - 1)];
+
+      uint64_t slotKey = slot.key.load(std::memory_order_acquire);
+      if (slotKey == 0 && slot.key.compare_exchange_strong(slotKey, _key, std::memory_order_acq_rel))
+      {
+        return slot.site;
+      }
+
+      if (slotKey == _key)
+      {
+        return slot.site;
+      }
+    }
+
+    // Таблица заполнена - массивы создаются без прогноза
+    static CArrayCapacitySite overflowSite(0, false);
+    return overflowSite;
+  }
+
+  // Хэш строки (FNV-1a)
+  static uint64_t hash(
+      const char * _text,
+      uint64_t     _seed = 14695981039346656037ull
+    )
+  {
+    for ( ; *_text; ++_text)
+    {
+      _seed = (_seed ^ static_cast<unsigned char>(*_text)) * 1099511628211ull;
+    }
+
+    return _seed;
+  }
+
+private:
+
+  static constexpr unsigned int SlotsCount = 1024;
+
+  struct Slot
+  {
+    std::atomic<uint64_t> key{0};
+    CArrayCapacitySite    site;
+  };
+};
+
+//----------------------------------------------------------------------------//
+inline CArrayCapacitySite &
+CArrayCapacitySite::forKey(
+    const char * _key
+  )
+{
+  return CArrayCapacitySiteTable::find(CArrayCapacitySiteTable::hash(_key));
+}
+
+#ifdef __cpp_lib_source_location
+//----------------------------------------------------------------------------//
+inline CArrayCapacitySite &
+CArrayCapacitySite::current(
+    const std::source_location & _location
+  )
+{
+  uint64_t key = CArrayCapacitySiteTable::hash(_location.file_name());
+  key = (key ^ _location.line())   * 1099511628211ull;
+  key = (key ^ _location.column()) * 1099511628211ull;
+
+  return CArrayCapacitySiteTable::find(key);
+}
+#endif
+
+//----------------------------------------------------------------------------//
+inline unsigned int
+CArrayCapacitySite::bucketIndex(
+    unsigned int _size
+  )
+{
+  if (_size < 4)
+  {
+    return _size;
+  }
+
+  // Старший бит задает группу, два следующих - подгруппу
+  const unsigned int highBit = highestBitIndex(_size);
+  const unsigned int mantissa = _size >> (highBit - 2);   //< от 4 до 7
+
+  return (highBit - 1) * 4 + (mantissa - 4);
+}
+
+//----------------------------------------------------------------------------//
+inline unsigned int
+CArrayCapacitySite::bucketUpperBound(
+    unsigned int _bucket
+  )
+{
+  if (_bucket < 4)
+  {
+    return _bucket;
+  }
+
+  const unsigned int highBit  = _bucket / 4 + 1;
+  const unsigned int mantissa = _bucket % 4 + 4;
+
+  const unsigned long long bound = (static_cast<unsigned long long>(mantissa + 1) << (highBit - 2)) - 1;
+  return bound > 0xFFFFFFFFull ? 0xFFFFFFFFu : static_cast<unsigned int>(bound);
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CArrayCapacitySite::record(
+    unsigned int _size
+  )
+{
+  if (!m_enabled)
+  {
+    return;
+  }
+
+  m_buckets[bucketIndex(_size)].fetch_add(1, std::memory_order_relaxed);
+
+  const unsigned int recorded = m_recorded.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (recorded % RecalculatePeriod == 0)
+  {
+    recalculate();
+  }
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CArrayCapacitySite::recalculate()
+{
+  unsigned int counts[BucketsCount];
+  unsigned long long total = 0;
+
+  for (unsigned int bucket = 0; bucket < BucketsCount; ++bucket)
+  {
+    counts[bucket] = m_buckets[bucket].load(std::memory_order_relaxed);
+    total += counts[bucket];
+  }
+
+  // Наименьшая группа, до которой включительно набирается нужная доля массивов
+  const unsigned long long needed = (total * m_percentile + 99) / 100;
+  unsigned long long       accumulated = 0;
+  unsigned int             prediction  = 0;
+
+  for (unsigned int bucket = 0; bucket < BucketsCount; ++bucket)
+  {
+    accumulated += counts[bucket];
+    if (accumulated >= needed)
+    {
+      prediction = bucketUpperBound(bucket);
+      break;
+    }
+  }
+
+  m_prediction.store(prediction, std::memory_order_relaxed);
+
+  if (total >= DecayThreshold)
+  {
+    // Уполовинивание не атомарно для гистограммы в целом: параллельные
+    // записи могут потеряться или учесться дважды, на прогноз это не влияет
+    for (unsigned int bucket = 0; bucket < BucketsCount; ++bucket)
+    {
+      m_buckets[bucket].fetch_sub(counts[bucket] / 2, std::memory_order_relaxed);
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class CArrayCapacitySiteLink - место создания массива (только для политик
+// с capacityAdvisor). При выключенном прогнозе класс пустой.
+template <bool enabled>
+class CArrayCapacitySiteLink
+{
+};
+
+//----------------------------------------------------------------------------//
+template <>
+class CArrayCapacitySiteLink<true>
+{
+protected:
+
+  CArrayCapacitySite * m_site = nullptr;
+};
@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "CArrayParallel.h"
+
+#if defined(__linux__)
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Размещение больших буферов массивов по узлам NUMA.
+//
+// Политика задается при выделении буфера через mbind (системный вызов
+// напрямую, без libnuma) и действует на страницы, к которым еще не было
+// обращений. set_mempolicy не используется: она меняет политику всех
+// последующих выделений потока, а не только буфера массива.
+// После этого буфер заполняется страницами параллельно (первое
+// обращение), а перенос элементов при росте выполняется частями в разных
+// потоках. Части по узлам (partitioned) и части первого обращения
+// составляются из единиц по CArrayNumaBytesPerUnit байтов, и каждая часть
+// первого обращения лежит в одной части по узлу. На системах без NUMA и
+// вне Linux размещение не выполняется, параллельное первое обращение
+// сохраняется.
+
+// Способ размещения буфера
+enum class CArrayNumaPlacement
+{
+  none,         //< Без изменений: страницы на узле первого обратившегося потока
+  interleaved,  //< Страницы поочередно на всех узлах
+  local,        //< Страницы на узле numaNode политики
+  partitioned   //< Буфер делится на равные части по числу узлов, по порядку
+};
+
+// Минимальный размер буфера, для которого выполняется размещение
+constexpr size_t CArrayNumaMinBytes = size_t(1) << 21;
+
+// Объем, обрабатываемый одним потоком при первом обращении и переносе
+constexpr size_t CArrayNumaBytesPerUnit = size_t(1) << 16;
+
+//----------------------------------------------------------------------------//
+// Количество узлов NUMA (1, если узлы не определены)
+inline unsigned int numaNodeCount()
+{
+  static const unsigned int nodeCount = []()
+  {
+    unsigned int count = 1;
+#if defined(__linux__)
+    // Формат файла: "0" или "0-1" или "0,2-3"; учитывается старший номер
+    if (FILE * pFile = fopen("/sys/devices/system/node/online", "r"))
+    {
+      char buffer[256] = {};
+      if (fgets(buffer, sizeof(buffer), pFile))
+      {
+        unsigned int number = 0;
+        bool         digits = false;
+        for (const char * pChar = buffer; ; ++pChar)
+        {
+          if (*pChar >= '0' && *pChar <= '9')
+          {
+            number = number * 10 + (*pChar - '0');
+            digits = true;
+            continue;
+          }
+
+          if (digits)
+          {
+            count = std::max(count, number + 1);
+          }
+          number = 0;
+          digits = false;
+
+          if (*pChar == '\0')
+          {
+            break;
+          }
+        }
+      }
+      fclose(pFile);
+    }
+#endif
+    return std::min(count, 64u);
+  }();
+
+  return nodeCount;
+}
+
+//----------------------------------------------------------------------------//
+// Получить количество частей буфера, размещаемых на разных узлах
+inline unsigned int numaPartCount(
+    CArrayNumaPlacement _placement
+  )
+{
+  return _placement == CArrayNumaPlacement::partitioned ? numaNodeCount() : 1;
+}
+
+//----------------------------------------------------------------------------//
+// Получить количество единиц CArrayNumaBytesPerUnit в _bytes байтах
+inline unsigned int numaUnitCount(
+    size_t _bytes
+  )
+{
+  return static_cast<unsigned int>((_bytes + CArrayNumaBytesPerUnit - 1) / CArrayNumaBytesPerUnit);
+}
+
+//----------------------------------------------------------------------------//
+// Получить количество частей для параллельной обработки _unitCount единиц
+// буфера из _partCount частей по узлам: кратно _partCount, чтобы каждая
+// часть по узлу делилась на целое количество частей обработки
+inline unsigned int numaChunkCount(
+    unsigned int _unitCount,
+    unsigned int _partCount
+  )
+{
+  const unsigned int chunkCount = parallelChunkCount(_unitCount, 16);
+  return _partCount <= 1 ? chunkCount : std::max(1u, chunkCount / _partCount) * _partCount;
+}
+
+//----------------------------------------------------------------------------//
+// Получить границу части _part при делении буфера из _bytes байтов на
+// _partCount частей по единицам CArrayNumaBytesPerUnit
+inline size_t numaPartBound(
+    size_t       _bytes,
+    unsigned int _partCount,
+    unsigned int _part
+  )
+{
+  const size_t bound = size_t(parallelChunkBound(numaUnitCount(_bytes), _partCount, _part)) * CArrayNumaBytesPerUnit;
+  return std::min(_bytes, bound);
+}
+
+//----------------------------------------------------------------------------//
+// Назначить политику размещения страницам, целиком лежащим в
+// [_pData, _pData + _bytes). _mode - MPOL_* ядра Linux.
+inline void numaBindRange(
+    void *   _pData,
+    size_t   _bytes,
+    int      _mode,
+    uint64_t _nodeMask
+  )
+{
+#if defined(__linux__) && defined(SYS_mbind)
+  const uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+  const uintptr_t from     = (reinterpret_cast<uintptr_t>(_pData) + pageSize - 1) & ~(pageSize - 1);
+  const uintptr_t to       = (reinterpret_cast<uintptr_t>(_pData) + _bytes) & ~(pageSize - 1);
+  if (from >= to)
+  {
+    return;
+  }
+
+  // Ошибка не критична: страницы будут размещены по умолчанию
+  syscall(SYS_mbind, from, to - from, _mode, &_nodeMask, 64ul, 0u);
+#else
+  (void)_pData;
+  (void)_bytes;
+  (void)_mode;
+  (void)_nodeMask;
+#endif
+}
+
+//----------------------------------------------------------------------------//
+// Разместить буфер по политике _placement. Вызывается до первого
+// обращения к буферу.
+inline void numaPlaceBuffer(
+    void *              _pData,
+    size_t              _bytes,
+    CArrayNumaPlacement _placement,
+    unsigned int        _node
+  )
+{
+  // Значения MPOL_* из linux/mempolicy.h
+  constexpr int MpolPreferred  = 1;
+  constexpr int MpolInterleave = 3;
+
+  const unsigned int nodeCount = numaNodeCount();
+  if (_placement == CArrayNumaPlacement::none || _bytes < CArrayNumaMinBytes || nodeCount <= 1)
+  {
+    return;
+  }
+
+  switch (_placement)
+  {
+    case CArrayNumaPlacement::interleaved:
+      numaBindRange(_pData, _bytes, MpolInterleave, ~uint64_t(0) >> (64 - nodeCount));
+      break;
+
+    case CArrayNumaPlacement::local:
+      if (_node < nodeCount)
+      {
+        numaBindRange(_pData, _bytes, MpolPreferred, uint64_t(1) << _node);
+      }
+      break;
+
+    case CArrayNumaPlacement::partitioned:
+      // Части идут по порядку узлов, как части parallelForChunks
+      // по порядку потоков
+      for (unsigned int node = 0; node < nodeCount; ++node)
+      {
+        const size_t from = numaPartBound(_bytes, nodeCount, node);
+        const size_t to   = numaPartBound(_bytes, nodeCount, node + 1);
+        numaBindRange(static_cast<char *>(_pData) + from, to - from, MpolPreferred, uint64_t(1) << node);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+//----------------------------------------------------------------------------//
+// Обратиться к каждой странице буфера из нескольких потоков, чтобы
+// выделение страниц выполнялось параллельно. Части обращения не выходят
+// за границы _partCount частей по узлам.
+inline void numaFirstTouch(
+    void *       _pData,
+    size_t       _bytes,
+    unsigned int _partCount = 1
+  )
+{
+  if (_bytes < CArrayNumaMinBytes)
+  {
+    return;
+  }
+
+  constexpr size_t PageBytes = 4096;
+
+  char * const       pBytes    = static_cast<char *>(_pData);
+  const unsigned int unitCount = numaUnitCount(_bytes);
+
+  parallelForChunks(unitCount, numaChunkCount(unitCount, _partCount),
+                    [pBytes, _bytes](unsigned int, unsigned int _unitFrom, unsigned int _unitTo)
+                    {
+                      const size_t to = std::min(_bytes, _unitTo * CArrayNumaBytesPerUnit);
+                      for (size_t offset = _unitFrom * CArrayNumaBytesPerUnit; offset < to; offset += PageBytes)
+                      {
+                        pBytes[offset] = 0;
+                      }
+                    });
+}
+
+//----------------------------------------------------------------------------//
+// Скопировать _bytes байтов частями в нескольких потоках
+inline void numaParallelCopy(
+    void *       _pTarget,
+    const void * _pSource,
+    size_t       _bytes
+  )
+{
+  if (_bytes < CArrayNumaMinBytes)
+  {
+    if (_bytes)
+    {
+      std::memcpy(_pTarget, _pSource, _bytes);
+    }
+    return;
+  }
+
+  char * const       pTarget   = static_cast<char *>(_pTarget);
+  const char * const pSource   = static_cast<const char *>(_pSource);
+  const unsigned int unitCount = numaUnitCount(_bytes);
+
+  parallelForChunks(unitCount, parallelChunkCount(unitCount, 16),
+                    [pTarget, pSource, _bytes](unsigned int, unsigned int _unitFrom, unsigned int _unitTo)
+                    {
+                      const size_t from = _unitFrom * CArrayNumaBytesPerUnit;
+                      const size_t to   = std::min(_bytes, _unitTo * CArrayNumaBytesPerUnit);
+                      std::memcpy(pTarget + from, pSource + from, to - from);
+                    });
+}
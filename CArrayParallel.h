@@ -0,0 +1,75 @@
+#pragma once
+
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// Разбиение работы над массивом на части для параллельных алгоритмов
+
+// Минимальное количество элементов на поток, при меньших объемах
+// параллельные варианты алгоритмов выполняются последовательно
+constexpr unsigned int CArrayParallelMinItemsPerThread = 1u << 16;
+
+//----------------------------------------------------------------------------//
+// Получить количество частей для обработки _count элементов
+inline unsigned int parallelChunkCount(
+    unsigned int _count,
+    unsigned int _minItemsPerThread = CArrayParallelMinItemsPerThread
+  )
+{
+  const unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+  const unsigned int byVolume        = std::max(1u, _count / std::max(1u, _minItemsPerThread));
+
+  return std::min(hardwareThreads, byVolume);
+}
+
+//----------------------------------------------------------------------------//
+// Получить границу части _chunkIndex при разбиении _count элементов
+// на _chunkCount почти равных частей
+inline unsigned int parallelChunkBound(
+    unsigned int _count,
+    unsigned int _chunkCount,
+    unsigned int _chunkIndex
+  )
+{
+  return static_cast<unsigned int>(static_cast<unsigned long long>(_count) * _chunkIndex / _chunkCount);
+}
+
+//----------------------------------------------------------------------------//
+// Выполнить _func(chunkIndex, indexFrom, indexTo) для каждой из _chunkCount
+// частей диапазона [0, _count). Первая часть выполняется в текущем потоке.
+// Функция не должна выбрасывать исключения.
+template <typename TFunc>
+void parallelForChunks(
+    unsigned int _count,
+    unsigned int _chunkCount,
+    TFunc &&     _func
+  )
+{
+  if (_chunkCount <= 1)
+  {
+    _func(0u, 0u, _count);
+    return;
+  }
+
+  std::vector<std::thread> workers;
+  workers.reserve(_chunkCount - 1);
+
+  for (unsigned int chunkIndex = 1; chunkIndex < _chunkCount; ++chunkIndex)
+  {
+    workers.emplace_back([&_func, _count, _chunkCount, chunkIndex]()
+                         {
+                           _func(chunkIndex,
+                                 parallelChunkBound(_count, _chunkCount, chunkIndex),
+                                 parallelChunkBound(_count, _chunkCount, chunkIndex + 1));
+                         });
+  }
+
+  _func(0u, 0u, parallelChunkBound(_count, _chunkCount, 1));
+
+  for (auto & worker : workers)
+  {
+    worker.join();
+  }
+}
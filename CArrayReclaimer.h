@@ -0,0 +1,205 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <algorithm>
+
+///////////////////////////////////////////////////////////////////////////////
+// class CArrayReclaimer - фоновое освобождение больших массивов.
+//
+// Объект, переданный в submit(), разрушается одним из рабочих потоков.
+// Потоки создаются при первой передаче. Очередь ограничена: если в ней
+// уже maxPending объектов, submit() возвращает false и объект
+// разрушает вызывающий поток (так освобождение не опережает накопление
+// памяти). drain() дожидается разрушения всех переданных объектов;
+// деструктор выполняет drain() и останавливает потоки.
+class CArrayReclaimer
+{
+public: // Interface
+
+  // Функция разрушения объекта
+  using TDestroyFunc = void (*)(void *);
+
+  // Конструктор
+  explicit CArrayReclaimer(
+      unsigned int _threadCount = 1,
+      unsigned int _maxPending  = 64
+    );
+
+  // Деструктор
+  ~CArrayReclaimer();
+
+  CArrayReclaimer(const CArrayReclaimer &)             = delete;
+  CArrayReclaimer & operator=(const CArrayReclaimer &) = delete;
+
+  // Общий экземпляр, используемый CArray::destroy_async
+  static CArrayReclaimer & instance();
+
+  // Передать объект на разрушение. Возвращает false, если очередь
+  // заполнена или освобождение остановлено: объект остается у вызывающего.
+  bool submit(
+      void *       _pObject,
+      TDestroyFunc _destroy
+    );
+
+  // Дождаться разрушения всех переданных объектов
+  void drain();
+
+  // Получить количество переданных и еще не разрушенных объектов
+  unsigned int pending() const;
+
+  // Изменить ограничение очереди
+  void setMaxPending(
+      unsigned int _maxPending
+    );
+
+protected:  // Методы
+
+  // Задание на разрушение
+  struct Job
+  {
+    void *       m_pObject;
+    TDestroyFunc m_destroy;
+  };
+
+  // Цикл рабочего потока
+  void workerLoop();
+
+protected: // Attributes
+
+  mutable std::mutex       m_mutex;
+  std::condition_variable  m_jobReady;        //< Появилось задание или остановка
+  std::condition_variable  m_jobDone;         //< Задание выполнено
+  std::vector<Job>         m_jobs;            //< Очередь заданий
+  std::vector<std::thread> m_workers;         //< Рабочие потоки (создаются лениво)
+  unsigned int             m_threadCount;     //< Количество рабочих потоков
+  unsigned int             m_maxPending;      //< Ограничение очереди
+  unsigned int             m_pending = 0;     //< Заданий в очереди и в работе
+  bool                     m_stopping = false;
+};
+
+//----------------------------------------------------------------------------//
+inline CArrayReclaimer::CArrayReclaimer(
+    unsigned int _threadCount,
+    unsigned int _maxPending
+  )
+  : m_threadCount(std::max(1u, _threadCount)),
+    m_maxPending(_maxPending)
+{
+}
+
+//----------------------------------------------------------------------------//
+inline CArrayReclaimer::~CArrayReclaimer()
+{
+  drain();
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stopping = true;
+  }
+  m_jobReady.notify_all();
+
+  for (auto & worker : m_workers)
+  {
+    worker.join();
+  }
+}
+
+//----------------------------------------------------------------------------//
+inline CArrayReclaimer & CArrayReclaimer::instance()
+{
+  static CArrayReclaimer reclaimer;
+  return reclaimer;
+}
+
+//----------------------------------------------------------------------------//
+inline bool CArrayReclaimer::submit(
+    void *       _pObject,
+    TDestroyFunc _destroy
+  )
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_stopping || m_pending >= m_maxPending)
+    {
+      return false;
+    }
+
+    if (m_workers.empty())
+    {
+      try
+      {
+        for (unsigned int index = 0; index < m_threadCount; ++index)
+        {
+          m_workers.emplace_back(&CArrayReclaimer::workerLoop, this);
+        }
+      }
+      catch (...)
+      {
+        // Без потоков задание не будет выполнено
+        if (m_workers.empty())
+        {
+          return false;
+        }
+      }
+    }
+
+    m_jobs.push_back(Job{_pObject, _destroy});
+    ++m_pending;
+  }
+
+  m_jobReady.notify_one();
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+inline void CArrayReclaimer::drain()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_jobDone.wait(lock, [this]() { return m_pending == 0; });
+}
+
+//----------------------------------------------------------------------------//
+inline unsigned int CArrayReclaimer::pending() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_pending;
+}
+
+//----------------------------------------------------------------------------//
+inline void CArrayReclaimer::setMaxPending(
+    unsigned int _maxPending
+  )
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_maxPending = _maxPending;
+}
+
+//----------------------------------------------------------------------------//
+inline void CArrayReclaimer::workerLoop()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (;;)
+  {
+    m_jobReady.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+    if (m_jobs.empty())
+    {
+      return;
+    }
+
+    const Job job = m_jobs.back();
+    m_jobs.pop_back();
+
+    // Разрушение выполняется без блокировки
+    lock.unlock();
+    job.m_destroy(job.m_pObject);
+    lock.lock();
+
+    if (--m_pending == 0)
+    {
+      m_jobDone.notify_all();
+    }
+  }
+}
@@ -0,0 +1,519 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "CArrayParallel.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Поразрядная сортировка массивов целых и вещественных чисел.
+//
+// Значение отображается в беззнаковый ключ с тем же порядком (у знаковых
+// инвертируется старший бит, у IEEE-чисел отрицательные инвертируются
+// целиком), ключи сортируются по байтам начиная с младшего (LSD).
+// Гистограммы всех байтов строятся за один проход, байты, одинаковые у
+// всех элементов, пропускаются. Большие массивы сначала распределяются
+// между потоками по старшему байту (MSD), затем каждая корзина
+// досортировывается LSD независимо.
+//
+// Порядок вещественных: -NaN < -inf < ... < -0.0 < +0.0 < ... < +inf < +NaN.
+
+// Размер, начиная с которого сортировка распределяется между потоками
+constexpr unsigned int CArrayRadixParallelThreshold = 1u << 20;
+
+// Размер, до которого выгоднее сортировка сравнением
+constexpr unsigned int CArrayRadixMinCount = 256;
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CArrayRadixKey - беззнаковый ключ значения, сохраняющий порядок.
+// supported - тип сортируется поразрядно.
+template <typename T, typename = void>
+struct CArrayRadixKey
+{
+  static constexpr bool supported = false;
+};
+
+//----------------------------------------------------------------------------//
+template <typename T>
+struct CArrayRadixKey<T, std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>>
+{
+  static constexpr bool supported = true;
+
+  using type = std::make_unsigned_t<T>;
+
+  static type get(
+      T _value
+    )
+  {
+    constexpr type signBit = std::is_signed<T>::value ? type(type(1) << (sizeof(T) * 8 - 1)) : type(0);
+    return type(type(_value) ^ signBit);
+  }
+};
+
+//----------------------------------------------------------------------------//
+template <typename T>
+struct CArrayRadixKey<T, std::enable_if_t<std::is_floating_point<T>::value
+                                          && std::numeric_limits<T>::is_iec559
+                                          && (sizeof(T) == 4 || sizeof(T) == 8)>>
+{
+  static constexpr bool supported = true;
+
+  using type = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+
+  static type get(
+      T _value
+    )
+  {
+    constexpr type signBit = type(type(1) << (sizeof(T) * 8 - 1));
+
+    type bits;
+    std::memcpy(&bits, &_value, sizeof(bits));
+
+    return (bits & signBit) ? type(~bits) : type(bits | signBit);
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CArrayRadixSorter - сортировка буфера _data с временным буфером
+// _scratch того же размера. TKey - отображение элемента в беззнаковый
+// ключ (по умолчанию CArrayRadixKey), элементы копируются побайтно.
+template <typename T, typename TKey = CArrayRadixKey<T>>
+class CArrayRadixSorter
+{
+  using TKeyType = typename TKey::type;
+
+  static_assert(TKey::supported, "Radix sort supports only integral and IEEE floating point types");
+
+  static constexpr unsigned int DigitsCount = sizeof(TKeyType);
+
+  using THistogram = unsigned int[DigitsCount][256];
+
+public:
+
+  static void sort(
+      T *          _data,
+      T *          _scratch,
+      unsigned int _count
+    );
+
+private:
+
+  // Байт ключа с номером _digit (0 - младший)
+  static unsigned int digitOf(
+      const T &    _value,
+      unsigned int _digit
+    )
+  {
+    return static_cast<unsigned int>(TKey::get(_value) >> (_digit * 8)) & 0xFF;
+  }
+
+  // Сортировка сравнением ключей (для малых массивов и корзин)
+  static void sortByComparison(
+      T *          _data,
+      unsigned int _count
+    )
+  {
+    std::sort(_data, _data + _count,
+              [](const T & _left, const T & _right) { return TKey::get(_left) < TKey::get(_right); });
+  }
+
+  // Упорядочить _src по младшим _digitsCount байтам, используя _dst как
+  // временный буфер. Возвращает буфер с результатом (_src или _dst).
+  static T * sortDigits(
+      T *          _src,
+      T *          _dst,
+      unsigned int _count,
+      unsigned int _digitsCount
+    );
+
+  // Распределение по старшему байту между потоками и досортировка корзин
+  static void sortParallel(
+      T *          _data,
+      T *          _scratch,
+      unsigned int _count,
+      unsigned int _chunkCount
+    );
+};
+
+//----------------------------------------------------------------------------//
+template <typename T, typename TKey>
+void
+CArrayRadixSorter<T, TKey>::sort(
+    T *          _data,
+    T *          _scratch,
+    unsigned int _count
+  )
+{
+  if (_count < CArrayRadixMinCount)
+  {
+    sortByComparison(_data, _count);
+    return;
+  }
+
+  const unsigned int chunkCount = _count >= CArrayRadixParallelThreshold ? parallelChunkCount(_count) : 1;
+  if (chunkCount > 1)
+  {
+    sortParallel(_data, _scratch, _count, chunkCount);
+    return;
+  }
+
+  T * result = sortDigits(_data, _scratch, _count, DigitsCount);
+  if (result != _data)
+  {
+    std::memcpy(_data, result, sizeof(T) * _count);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename T, typename TKey>
+T *
+CArrayRadixSorter<T, TKey>::sortDigits(
+    T *          _src,
+    T *          _dst,
+    unsigned int _count,
+    unsigned int _digitsCount
+  )
+{
+  if (_count < CArrayRadixMinCount)
+  {
+    sortByComparison(_src, _count);
+    return _src;
+  }
+
+  // Гистограммы всех байтов за один проход
+  THistogram histogram = {};
+  for (unsigned int index = 0; index < _count; ++index)
+  {
+    const TKeyType key = TKey::get(_src[index]);
+    for (unsigned int digit = 0; digit < _digitsCount; ++digit)
+    {
+      ++histogram[digit][static_cast<unsigned int>(key >> (digit * 8)) & 0xFF];
+    }
+  }
+
+  for (unsigned int digit = 0; digit < _digitsCount; ++digit)
+  {
+    unsigned int * counts = histogram[digit];
+
+    // Все элементы в одной корзине - байт не влияет на порядок
+    if (counts[digitOf(_src[0], digit)] == _count)
+    {
+      continue;
+    }
+
+    unsigned int offset = 0;
+    for (unsigned int bucket = 0; bucket < 256; ++bucket)
+    {
+      const unsigned int bucketCount = counts[bucket];
+      counts[bucket] = offset;
+      offset += bucketCount;
+    }
+
+    for (unsigned int index = 0; index < _count; ++index)
+    {
+      _dst[counts[digitOf(_src[index], digit)]++] = _src[index];
+    }
+
+    std::swap(_src, _dst);
+  }
+
+  return _src;
+}
+
+//----------------------------------------------------------------------------//
+template <typename T, typename TKey>
+void
+CArrayRadixSorter<T, TKey>::sortParallel(
+    T *          _data,
+    T *          _scratch,
+    unsigned int _count,
+    unsigned int _chunkCount
+  )
+{
+  const unsigned int topDigit = DigitsCount - 1;
+
+  // Гистограммы старшего байта по частям
+  std::vector<unsigned int> offsets(static_cast<size_t>(_chunkCount) * 256, 0);
+
+  parallelForChunks(_count, _chunkCount,
+                    [&](unsigned int _chunkIndex, unsigned int _indexFrom, unsigned int _indexTo)
+                    {
+                      unsigned int * counts = &offsets[static_cast<size_t>(_chunkIndex) * 256];
+                      for (unsigned int index = _indexFrom; index < _indexTo; ++index)
+                      {
+                        ++counts[digitOf(_data[index], topDigit)];
+                      }
+                    });
+
+  // Смещения частей внутри корзин: корзина за корзиной, часть за частью,
+  // что сохраняет устойчивость распределения
+  unsigned int bucketBounds[257];
+  unsigned int offset = 0;
+  for (unsigned int bucket = 0; bucket < 256; ++bucket)
+  {
+    bucketBounds[bucket] = offset;
+    for (unsigned int chunkIndex = 0; chunkIndex < _chunkCount; ++chunkIndex)
+    {
+      unsigned int & counter = offsets[static_cast<size_t>(chunkIndex) * 256 + bucket];
+      const unsigned int chunkItems = counter;
+      counter = offset;
+      offset += chunkItems;
+    }
+  }
+  bucketBounds[256] = offset;
+
+  parallelForChunks(_count, _chunkCount,
+                    [&](unsigned int _chunkIndex, unsigned int _indexFrom, unsigned int _indexTo)
+                    {
+                      unsigned int * positions = &offsets[static_cast<size_t>(_chunkIndex) * 256];
+                      for (unsigned int index = _indexFrom; index < _indexTo; ++index)
+                      {
+                        _scratch[positions[digitOf(_data[index], topDigit)]++] = _data[index];
+                      }
+                    });
+
+  // Корзины досортировываются по младшим байтам; потоки разбирают корзины
+  // по очереди, так как их размеры могут сильно отличаться
+  std::atomic<unsigned int> nextBucket(0);
+
+  parallelForChunks(_chunkCount, _chunkCount,
+                    [&](unsigned int, unsigned int, unsigned int)
+                    {
+                      for (unsigned int bucket = nextBucket++; bucket < 256; bucket = nextBucket++)
+                      {
+                        const unsigned int bucketFrom  = bucketBounds[bucket];
+                        const unsigned int bucketCount = bucketBounds[bucket + 1] - bucketFrom;
+                        if (bucketCount == 0)
+                        {
+                          continue;
+                        }
+
+                        T * result = sortDigits(_scratch + bucketFrom, _data + bucketFrom, bucketCount, topDigit);
+                        if (result != _data + bucketFrom)
+                        {
+                          std::memcpy(_data + bucketFrom, result, sizeof(T) * bucketCount);
+                        }
+                      }
+                    });
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// class CArrayStringSorter - сортировка строк по кэшированным префиксам.
+//
+// Для каждой строки запоминается ключ из 8 байтов, начиная с текущей
+// глубины (старший байт - первый символ), и исходный индекс. Записи
+// упорядочиваются поразрядно по ключам (параллельно для больших массивов).
+// Группы с одинаковым ключом уточняются по следующим 8 байтам, так что
+// общие префиксы не сравниваются повторно, а строки читаются только при
+// построении ключей. Сами строки не перемещаются: результат - порядок,
+// по которому массив переносит элементы.
+template <typename TString>
+class CArrayStringSorter
+{
+public:
+
+  // Заполнить _order[position] индексом элемента, который должен стоять
+  // на месте position
+  static void sortedOrder(
+      const TString * _data,
+      unsigned int    _count,
+      unsigned int *  _order
+    );
+
+private:
+
+  // Группа, меньше которой уточнение ключами невыгодно
+  static constexpr unsigned int MinRefineCount = 32;
+
+  struct Entry
+  {
+    uint64_t     prefix;
+    unsigned int index;
+  };
+
+  struct EntryKey
+  {
+    static constexpr bool supported = true;
+
+    using type = uint64_t;
+
+    static type get(
+        const Entry & _entry
+      )
+    {
+      return _entry.prefix;
+    }
+  };
+
+  // Группа записей [m_from, m_to), совпадающих в первых m_depth байтах
+  struct Group
+  {
+    unsigned int m_from;
+    unsigned int m_to;
+    unsigned int m_depth;
+  };
+
+  // 8 байтов строки начиная с _depth, дополненные нулями
+  static uint64_t prefixOf(
+      const TString & _value,
+      unsigned int    _depth
+    )
+  {
+    const size_t length = _value.size() > _depth ? std::min<size_t>(_value.size() - _depth, 8) : 0;
+
+    uint64_t prefix = 0;
+    for (size_t index = 0; index < length; ++index)
+    {
+      prefix = (prefix << 8) | static_cast<unsigned char>(_value[_depth + index]);
+    }
+
+    return length ? prefix << ((8 - length) * 8) : 0;
+  }
+
+  // Упорядочить группу записей сравнением строк с байта _depth
+  static void sortByComparison(
+      const TString * _data,
+      Entry *         _entryFrom,
+      Entry *         _entryTo,
+      unsigned int    _depth
+    );
+
+  // Упорядочить записи с одинаковым ключом на глубине _depth: строки,
+  // закончившиеся в пределах ключа, предшествуют остальным и упорядочены
+  // по длине. Возвращает начало записей, требующих уточнения.
+  static Entry * splitFinished(
+      const TString * _data,
+      Entry *         _entryFrom,
+      Entry *         _entryTo,
+      unsigned int    _depth
+    );
+};
+
+//----------------------------------------------------------------------------//
+template <typename TString>
+void
+CArrayStringSorter<TString>::sortByComparison(
+    const TString * _data,
+    Entry *         _entryFrom,
+    Entry *         _entryTo,
+    unsigned int    _depth
+  )
+{
+  std::sort(_entryFrom, _entryTo,
+            [_data, _depth](const Entry & _left, const Entry & _right)
+            {
+              const TString & left  = _data[_left.index];
+              const TString & right = _data[_right.index];
+
+              return left.compare(_depth, TString::npos, right, _depth, TString::npos) < 0;
+            });
+}
+
+//----------------------------------------------------------------------------//
+template <typename TString>
+typename CArrayStringSorter<TString>::Entry *
+CArrayStringSorter<TString>::splitFinished(
+    const TString * _data,
+    Entry *         _entryFrom,
+    Entry *         _entryTo,
+    unsigned int    _depth
+  )
+{
+  // Закончившаяся строка - префикс любой более длинной строки группы
+  Entry * unfinished = std::partition(_entryFrom, _entryTo,
+                                      [_data, _depth](const Entry & _entry)
+                                      {
+                                        return _data[_entry.index].size() <= _depth + 8;
+                                      });
+
+  std::sort(_entryFrom, unfinished,
+            [_data](const Entry & _left, const Entry & _right)
+            {
+              return _data[_left.index].size() < _data[_right.index].size();
+            });
+
+  return unfinished;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TString>
+void
+CArrayStringSorter<TString>::sortedOrder(
+    const TString * _data,
+    unsigned int    _count,
+    unsigned int *  _order
+  )
+{
+  std::vector<Entry> entries(_count);
+  std::vector<Entry> scratch(_count);
+
+  for (unsigned int index = 0; index < _count; ++index)
+  {
+    entries[index] = Entry{ prefixOf(_data[index], 0), index };
+  }
+
+  // Группы обрабатываются через стек, а не рекурсией: глубина зависит
+  // от длины общих префиксов
+  std::vector<Group> groups;
+  groups.push_back(Group{ 0, _count, 0 });
+
+  bool keysReady = true;
+  while (!groups.empty())
+  {
+    const Group group = groups.back();
+    groups.pop_back();
+
+    Entry * const entryFrom = entries.data() + group.m_from;
+    Entry * const entryTo   = entries.data() + group.m_to;
+
+    if (group.m_to - group.m_from < MinRefineCount)
+    {
+      sortByComparison(_data, entryFrom, entryTo, group.m_depth);
+      continue;
+    }
+
+    if (!keysReady)
+    {
+      for (Entry * entry = entryFrom; entry != entryTo; ++entry)
+      {
+        entry->prefix = prefixOf(_data[entry->index], group.m_depth);
+      }
+    }
+    keysReady = false;
+
+    CArrayRadixSorter<Entry, EntryKey>::sort(entryFrom, scratch.data() + group.m_from, group.m_to - group.m_from);
+
+    for (Entry * runFrom = entryFrom; runFrom != entryTo; )
+    {
+      Entry * runTo = runFrom + 1;
+      while (runTo != entryTo && runTo->prefix == runFrom->prefix)
+      {
+        ++runTo;
+      }
+
+      if (runTo - runFrom > 1)
+      {
+        Entry * unfinished = splitFinished(_data, runFrom, runTo, group.m_depth);
+        if (runTo - unfinished > 1)
+        {
+          groups.push_back(Group{ static_cast<unsigned int>(unfinished - entries.data()),
+                                  static_cast<unsigned int>(runTo - entries.data()),
+                                  group.m_depth + 8 });
+        }
+      }
+
+      runFrom = runTo;
+    }
+  }
+
+  for (unsigned int position = 0; position < _count; ++position)
+  {
+    _order[position] = entries[position].index;
+  }
+}
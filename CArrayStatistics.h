@@ -0,0 +1,261 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <ostream>
+#include <typeinfo>
+#include <algorithm>
+#include <utility>
+#include <cstdlib>
+
+#ifdef __GNUG__
+#  include <cxxabi.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CArrayStatistics - счетчики работы массива с памятью
+struct CArrayStatistics
+{
+  unsigned long long allocations        = 0;  //< Количество выделений буфера
+  unsigned long long allocatedBytes     = 0;  //< Суммарный объем выделенных буферов
+  unsigned long long reallocations      = 0;  //< Количество увеличений уже выделенного буфера
+  unsigned long long growthMovedItems   = 0;  //< Элементов перенесено при увеличении буфера
+  unsigned long long copiedItems        = 0;  //< Элементов скопировано при копировании массива
+  unsigned long long insertShiftedItems = 0;  //< Элементов сдвинуто вставками
+  unsigned long long eraseShiftedItems  = 0;  //< Элементов сдвинуто удалениями
+  unsigned long long peakCapacity       = 0;  //< Наибольшая емкость буфера в элементах
+
+  // Добавить счетчики другого набора (пиковая емкость берется наибольшая)
+  CArrayStatistics & operator+=(
+      const CArrayStatistics & _other
+    )
+  {
+    allocations        += _other.allocations;
+    allocatedBytes     += _other.allocatedBytes;
+    reallocations      += _other.reallocations;
+    growthMovedItems   += _other.growthMovedItems;
+    copiedItems        += _other.copiedItems;
+    insertShiftedItems += _other.insertShiftedItems;
+    eraseShiftedItems  += _other.eraseShiftedItems;
+    peakCapacity        = std::max(peakCapacity, _other.peakCapacity);
+
+    return *this;
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CArrayStatisticsRegistry - счетчики всех массивов потока,
+// сгруппированные по типу элементов
+class CArrayStatisticsRegistry
+{
+public:
+
+  struct Entry
+  {
+    std::string      typeName;
+    unsigned int     itemSize = 0;
+    CArrayStatistics statistics;
+  };
+
+  using TEntries = std::map<std::string, Entry>;
+
+  // Реестр текущего потока
+  static CArrayStatisticsRegistry & local()
+  {
+    static thread_local CArrayStatisticsRegistry registry;
+    return registry;
+  }
+
+  // Получить счетчики для типа элементов. Ссылка остается действительной
+  // все время жизни потока.
+  CArrayStatistics & entry(
+      const char * _typeName,
+      unsigned int _itemSize
+    )
+  {
+    Entry & item = m_entries[_typeName];
+    if (item.typeName.empty())
+    {
+      item.typeName = readableTypeName(_typeName);
+      item.itemSize = _itemSize;
+    }
+
+    return item.statistics;
+  }
+
+  // Получить копию счетчиков всех типов
+  TEntries snapshot() const
+  {
+    return m_entries;
+  }
+
+  // Обнулить счетчики (записи сохраняются, так как на них ссылаются массивы)
+  void reset()
+  {
+    for (auto & item : m_entries)
+    {
+      item.second.statistics = CArrayStatistics();
+    }
+  }
+
+  // Вывести счетчики всех типов, по строке на тип
+  void dump(
+      std::ostream & _stream
+    ) const
+  {
+    for (const auto & item : m_entries)
+    {
+      _stream << item.second.typeName << " (" << item.second.itemSize << " bytes): ";
+      dumpStatistics(_stream, item.second.statistics);
+      _stream << '\n';
+    }
+  }
+
+  // Вывести один набор счетчиков
+  static void dumpStatistics(
+      std::ostream &           _stream,
+      const CArrayStatistics & _statistics
+    )
+  {
+    _stream << "allocations="          << _statistics.allocations
+            << " allocated_bytes="     << _statistics.allocatedBytes
+            << " reallocations="       << _statistics.reallocations
+            << " growth_moved_items="  << _statistics.growthMovedItems
+            << " copied_items="        << _statistics.copiedItems
+            << " insert_shifted_items=" << _statistics.insertShiftedItems
+            << " erase_shifted_items=" << _statistics.eraseShiftedItems
+            << " peak_capacity="       << _statistics.peakCapacity;
+  }
+
+private:
+
+  CArrayStatisticsRegistry() = default;
+
+  // Имя типа из typeid в читаемом виде (GCC и Clang возвращают декорированное)
+  static std::string readableTypeName(
+      const char * _typeName
+    )
+  {
+    std::string result = _typeName;
+#ifdef __GNUG__
+    int    status    = 0;
+    char * demangled = abi::__cxa_demangle(_typeName, nullptr, nullptr, &status);
+    if (demangled)
+    {
+      if (status == 0)
+      {
+        result = demangled;
+      }
+      std::free(demangled);
+    }
+#endif
+    return result;
+  }
+
+  TEntries m_entries;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CArrayStatisticsCollector - сбор счетчиков буфером массива.
+// При выключенной статистике класс пустой, а все вызовы ничего не делают.
+template <typename TItemType, bool enabled>
+class CArrayStatisticsCollector
+{
+public:
+
+  void noteGrowth(unsigned int, unsigned int, unsigned int) {}
+  void noteCopy(unsigned int, unsigned int) {}
+  void noteInsertShift(unsigned int) {}
+  void noteEraseShift(unsigned int) {}
+  void swapStatistics(CArrayStatisticsCollector &) {}
+};
+
+//----------------------------------------------------------------------------//
+template <typename TItemType>
+class CArrayStatisticsCollector<TItemType, true>
+{
+public:
+
+  // Счетчики этого массива
+  const CArrayStatistics & statistics() const
+  {
+    return m_statistics;
+  }
+
+  // Выделен буфер на _newCapacity элементов вместо буфера на _oldCapacity,
+  // в него перенесено _movedItems элементов
+  void noteGrowth(
+      unsigned int _oldCapacity,
+      unsigned int _newCapacity,
+      unsigned int _movedItems
+    )
+  {
+    apply([=](CArrayStatistics & _statistics)
+          {
+            ++_statistics.allocations;
+            _statistics.allocatedBytes   += static_cast<unsigned long long>(_newCapacity) * sizeof(TItemType);
+            _statistics.reallocations    += _oldCapacity ? 1 : 0;
+            _statistics.growthMovedItems += _movedItems;
+            _statistics.peakCapacity      = std::max<unsigned long long>(_statistics.peakCapacity, _newCapacity);
+          });
+  }
+
+  // Выделен буфер на _capacity элементов под копию _copiedItems элементов
+  void noteCopy(
+      unsigned int _capacity,
+      unsigned int _copiedItems
+    )
+  {
+    apply([=](CArrayStatistics & _statistics)
+          {
+            ++_statistics.allocations;
+            _statistics.allocatedBytes += static_cast<unsigned long long>(_capacity) * sizeof(TItemType);
+            _statistics.copiedItems    += _copiedItems;
+            _statistics.peakCapacity    = std::max<unsigned long long>(_statistics.peakCapacity, _capacity);
+          });
+  }
+
+  // При вставке сдвинуто _shiftedItems элементов
+  void noteInsertShift(
+      unsigned int _shiftedItems
+    )
+  {
+    apply([=](CArrayStatistics & _statistics) { _statistics.insertShiftedItems += _shiftedItems; });
+  }
+
+  // При удалении сдвинуто _shiftedItems элементов
+  void noteEraseShift(
+      unsigned int _shiftedItems
+    )
+  {
+    apply([=](CArrayStatistics & _statistics) { _statistics.eraseShiftedItems += _shiftedItems; });
+  }
+
+  // Обменяться счетчиками (при перемещении массива счетчики переходят
+  // вместе с буфером)
+  void swapStatistics(
+      CArrayStatisticsCollector & _other
+    )
+  {
+    std::swap(m_statistics, _other.m_statistics);
+  }
+
+private:
+
+  // Обновить счетчики массива и реестра текущего потока
+  template <typename TUpdate>
+  void apply(
+      TUpdate _update
+    )
+  {
+    static thread_local CArrayStatistics & typeStatistics =
+      CArrayStatisticsRegistry::local().entry(typeid(TItemType).name(), sizeof(TItemType));
+
+    _update(m_statistics);
+    _update(typeStatistics);
+  }
+
+private:
+
+  CArrayStatistics m_statistics;
+};
@@ -0,0 +1,430 @@
+#pragma once
+
+#include <cassert>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+
+#if defined(__has_include)
+#  if __has_include(<version>)
+#    include <version>
+#  endif
+#endif
+
+#ifdef __cpp_lib_span
+#  include <span>
+#endif
+
+#include "CArrayParallel.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CArrayViewGuard - связь представлений с исходным массивом для
+// отладочной проверки (только при _DEBUG). Массив обнуляет m_source
+// в деструкторе, а при перемещении передает связь массиву, получившему
+// буфер; m_check проверяет, что диапазон по-прежнему находится
+// по тому же адресу и в пределах размера массива.
+struct CArrayViewGuard
+{
+  using TCheck = bool (*)(const void * _source, const void * _data, unsigned int _indexFrom, unsigned int _indexTo);
+
+  const void * m_source = nullptr;
+  TCheck       m_check  = nullptr;
+};
+
+template <typename TData> class CArrayView;
+template <typename TData> class CArraySlice;
+
+// Условие построения диапазона с элементами TItem из непрерывного
+// контейнера TContainer (std::data и std::size): std::vector, std::array,
+// std::string, встроенного массива. Сами диапазоны копируются своими
+// конструкторами, чтобы сохранить отладочную связь с массивом.
+template <typename TContainer, typename TItem>
+using CArrayIfContiguous = std::enable_if_t<
+    std::is_convertible<decltype(std::data(std::declval<TContainer &>())), TItem *>::value
+    && std::is_convertible<decltype(std::size(std::declval<TContainer &>())), std::size_t>::value
+    && !std::is_same<std::remove_cv_t<TContainer>, CArrayView<std::remove_cv_t<TItem>>>::value
+    && !std::is_same<std::remove_cv_t<TContainer>, CArraySlice<std::remove_cv_t<TItem>>>::value, int>;
+
+///////////////////////////////////////////////////////////////////////////////
+// class CArrayRangeBase - общая часть CArrayView и CArraySlice: непрерывный
+// диапазон элементов чужого буфера. TItem - тип элемента с учетом const,
+// TRange - производный класс, возвращаемый subview().
+template <typename TItem, typename TRange>
+class CArrayRangeBase
+{
+public: // Interface
+
+  using value_type      = std::remove_cv_t<TItem>;
+  using size_type       = unsigned int;
+  using difference_type = std::ptrdiff_t;
+  using pointer         = TItem *;
+  using reference       = TItem &;
+  using iterator        = TItem *;
+  using const_iterator  = TItem *;
+
+  // Получить размер диапазона
+  unsigned int size() const
+  {
+    return m_size;
+  }
+
+  // Определить что диапазон пустой
+  bool empty() const
+  {
+    return m_size == 0;
+  }
+
+  // Получить элемент диапазона по заданному индексу
+  TItem & operator[](
+      unsigned int _index
+    ) const;
+
+  // Получить указатель на первый элемент
+  TItem * data() const;
+
+  iterator begin() const;
+  iterator end()   const;
+
+  // Получить часть диапазона [_indexFrom, _indexTo) без копирования
+  TRange subview(
+      unsigned int _indexFrom,
+      unsigned int _indexTo
+    ) const;
+
+  // Вызвать _func(item) для каждого элемента, разбив большие диапазоны
+  // между потоками. Функция вызывается из разных потоков. Исключение
+  // прекращает обработку своей части и передается вызывающему, когда
+  // завершатся все части.
+  template <typename TFunc>
+  void for_each_parallel(
+      TFunc _func
+    ) const;
+
+  // Вызвать _func(subview) для частей диапазона, обрабатываемых разными
+  // потоками. Части не пересекаются и покрывают весь диапазон. Исключения
+  // передаются так же, как в for_each_parallel.
+  template <typename TFunc>
+  void for_chunks_parallel(
+      TFunc _func
+    ) const;
+
+#ifdef __cpp_lib_span
+  // Преобразовать в std::span
+  operator std::span<TItem>() const
+  {
+    return std::span<TItem>(data(), m_size);
+  }
+#endif
+
+protected:  // Методы
+
+  CArrayRangeBase() = default;
+
+  CArrayRangeBase(
+      TItem *      _data,
+      unsigned int _size
+    )
+    : m_data(_data),
+      m_size(_size)
+  {
+  }
+
+#ifdef _DEBUG
+  // Проверить, что исходный массив жив и диапазон не перемещен
+  bool isValid() const;
+#endif
+
+  // Выполнить _func(indexFrom, indexTo) для частей диапазона в разных
+  // потоках. Исключение части перехватывается в ее потоке, первое из них
+  // выбрасывается после завершения всех частей.
+  template <typename TFunc>
+  void forChunks(
+      TFunc & _func
+    ) const;
+
+protected: // Attributes
+
+  TItem *      m_data = nullptr;
+  unsigned int m_size = 0;
+
+#ifdef _DEBUG
+  std::shared_ptr<const CArrayViewGuard> m_guard;           //< Нет для диапазонов из указателя, контейнера и std::span
+  unsigned int                           m_sourceIndex = 0; //< Индекс первого элемента в исходном массиве
+#endif
+
+  template <typename TOtherItem, typename TOtherRange>
+  friend class CArrayRangeBase;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CArrayView - неизменяемое представление части массива без
+// копирования. Представление не владеет элементами: оно действительно,
+// пока массив существует и не перевыделяет буфер.
+template <typename TData>
+class CArrayView : public CArrayRangeBase<const TData, CArrayView<TData>>
+{
+  using TBase = CArrayRangeBase<const TData, CArrayView<TData>>;
+
+public: // Interface
+
+  CArrayView() = default;
+
+  CArrayView(
+      const TData * _data,
+      unsigned int  _size
+    )
+    : TBase(_data, _size)
+  {
+  }
+
+  // Представление элементов непрерывного контейнера (при C++17 вместо
+  // std::span)
+  template <typename TContainer, CArrayIfContiguous<const TContainer, const TData> = 0>
+  CArrayView(
+      const TContainer & _container
+    )
+    : TBase(std::data(_container), static_cast<unsigned int>(std::size(_container)))
+  {
+  }
+
+#ifdef __cpp_lib_span
+  CArrayView(
+      std::span<const TData> _span
+    )
+    : TBase(_span.data(), static_cast<unsigned int>(_span.size()))
+  {
+  }
+#endif
+
+#ifdef _DEBUG
+  // Представление, проверяемое через связь с исходным массивом
+  CArrayView(
+      const TData *                                 _data,
+      unsigned int                                  _size,
+      const std::shared_ptr<const CArrayViewGuard> & _guard,
+      unsigned int                                  _sourceIndex
+    )
+    : TBase(_data, _size)
+  {
+    this->m_guard       = _guard;
+    this->m_sourceIndex = _sourceIndex;
+  }
+#endif
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CArraySlice - изменяемое представление части массива без
+// копирования. Размер массива через представление не изменяется.
+template <typename TData>
+class CArraySlice : public CArrayRangeBase<TData, CArraySlice<TData>>
+{
+  using TBase = CArrayRangeBase<TData, CArraySlice<TData>>;
+
+public: // Interface
+
+  CArraySlice() = default;
+
+  CArraySlice(
+      TData *      _data,
+      unsigned int _size
+    )
+    : TBase(_data, _size)
+  {
+  }
+
+  // Изменяемое представление элементов непрерывного контейнера (при C++17
+  // вместо std::span)
+  template <typename TContainer, CArrayIfContiguous<TContainer, TData> = 0>
+  CArraySlice(
+      TContainer & _container
+    )
+    : TBase(std::data(_container), static_cast<unsigned int>(std::size(_container)))
+  {
+  }
+
+#ifdef __cpp_lib_span
+  CArraySlice(
+      std::span<TData> _span
+    )
+    : TBase(_span.data(), static_cast<unsigned int>(_span.size()))
+  {
+  }
+#endif
+
+#ifdef _DEBUG
+  // Представление, проверяемое через связь с исходным массивом
+  CArraySlice(
+      TData *                                       _data,
+      unsigned int                                  _size,
+      const std::shared_ptr<const CArrayViewGuard> & _guard,
+      unsigned int                                  _sourceIndex
+    )
+    : TBase(_data, _size)
+  {
+    this->m_guard       = _guard;
+    this->m_sourceIndex = _sourceIndex;
+  }
+#endif
+
+  // Получить неизменяемое представление тех же элементов
+  operator CArrayView<TData>() const
+  {
+#ifdef _DEBUG
+    return CArrayView<TData>(this->m_data, this->m_size, this->m_guard, this->m_sourceIndex);
+#else
+    return CArrayView<TData>(this->m_data, this->m_size);
+#endif
+  }
+};
+
+#ifdef _DEBUG
+//----------------------------------------------------------------------------//
+template <typename TItem, typename TRange>
+bool
+CArrayRangeBase<TItem, TRange>::isValid() const
+{
+  if (!m_guard)
+  {
+    return true;
+  }
+
+  return m_guard->m_source
+      && m_guard->m_check(m_guard->m_source, m_data, m_sourceIndex, m_sourceIndex + m_size);
+}
+#endif
+
+//----------------------------------------------------------------------------//
+template <typename TItem, typename TRange>
+TItem &
+CArrayRangeBase<TItem, TRange>::operator[](
+    unsigned int _index
+  ) const
+{
+  assert(_index < m_size);
+#ifdef _DEBUG
+  assert(isValid());
+#endif
+
+  return m_data[_index];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TItem, typename TRange>
+TItem *
+CArrayRangeBase<TItem, TRange>::data() const
+{
+#ifdef _DEBUG
+  assert(isValid());
+#endif
+
+  return m_data;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TItem, typename TRange>
+typename CArrayRangeBase<TItem, TRange>::iterator
+CArrayRangeBase<TItem, TRange>::begin() const
+{
+  return data();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TItem, typename TRange>
+typename CArrayRangeBase<TItem, TRange>::iterator
+CArrayRangeBase<TItem, TRange>::end() const
+{
+  return data() + m_size;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TItem, typename TRange>
+TRange
+CArrayRangeBase<TItem, TRange>::subview(
+    unsigned int _indexFrom,
+    unsigned int _indexTo
+  ) const
+{
+  assert(_indexFrom <= _indexTo && _indexTo <= m_size);
+
+#ifdef _DEBUG
+  assert(isValid());
+  return TRange(m_data + _indexFrom, _indexTo - _indexFrom, m_guard, m_sourceIndex + _indexFrom);
+#else
+  return TRange(m_data + _indexFrom, _indexTo - _indexFrom);
+#endif
+}
+
+//----------------------------------------------------------------------------//
+template <typename TItem, typename TRange>
+template <typename TFunc>
+void
+CArrayRangeBase<TItem, TRange>::for_each_parallel(
+    TFunc _func
+  ) const
+{
+  TItem * const pData = data();
+
+  auto chunkFunc = [pData, &_func](unsigned int _indexFrom, unsigned int _indexTo)
+                   {
+                     for (unsigned int index = _indexFrom; index < _indexTo; ++index)
+                     {
+                       _func(pData[index]);
+                     }
+                   };
+  forChunks(chunkFunc);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TItem, typename TRange>
+template <typename TFunc>
+void
+CArrayRangeBase<TItem, TRange>::for_chunks_parallel(
+    TFunc _func
+  ) const
+{
+  auto chunkFunc = [this, &_func](unsigned int _indexFrom, unsigned int _indexTo)
+                   {
+                     _func(subview(_indexFrom, _indexTo));
+                   };
+  forChunks(chunkFunc);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TItem, typename TRange>
+template <typename TFunc>
+void
+CArrayRangeBase<TItem, TRange>::forChunks(
+    TFunc & _func
+  ) const
+{
+  const unsigned int chunkCount = parallelChunkCount(m_size);
+  if (chunkCount <= 1)
+  {
+    _func(0u, m_size);
+    return;
+  }
+
+  std::unique_ptr<std::exception_ptr[]> errors(new std::exception_ptr[chunkCount]);
+
+  parallelForChunks(m_size, chunkCount,
+                    [&_func, &errors](unsigned int _chunkIndex, unsigned int _indexFrom, unsigned int _indexTo)
+                    {
+                      try
+                      {
+                        _func(_indexFrom, _indexTo);
+                      }
+                      catch (...)
+                      {
+                        errors[_chunkIndex] = std::current_exception();
+                      }
+                    });
+
+  for (unsigned int chunkIndex = 0; chunkIndex < chunkCount; ++chunkIndex)
+  {
+    if (errors[chunkIndex])
+    {
+      std::rethrow_exception(errors[chunkIndex]);
+    }
+  }
+}
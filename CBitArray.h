@@ -0,0 +1,864 @@
+#pragma once
+
+#include <cstdint>
+#include <cassert>
+#include <iterator>
+
+#include "CArray.h"
+#include "CArrayBits.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// class CBitArray - массив логических значений, упакованных по одному биту
+// в 64-битные слова.
+//
+// Интерфейс повторяет CArray (push_back/insert/erase/итераторы), доступ
+// к элементу на запись идет через прокси-ссылку. Вставка и удаление
+// сдвигают хвост целыми словами, count() считает биты через popcount,
+// поиск установленных битов пропускает нулевые слова, а логические
+// операции с другим массивом выполняются простыми циклами по словам,
+// которые компилятор векторизует.
+//
+// Биты последнего слова за пределами размера всегда нулевые.
+class CBitArray
+{
+public: // Interface
+
+  class reference;
+
+  template <typename TArray, typename TReference>
+  class iterator_base;
+
+  using iterator       = iterator_base<CBitArray, reference>;
+  using const_iterator = iterator_base<const CBitArray, bool>;
+
+  // Признак отсутствия установленного бита в find_first/find_next
+  static constexpr unsigned int npos = ~0u;
+
+  // Конструктор по умолчанию
+  CBitArray() = default;
+
+  // Создать массив из _count значений _value
+  explicit CBitArray(
+      unsigned int _count,
+      bool         _value = false
+    );
+
+  // Добавить элемент в конец массива
+  void push_back(
+      bool _value
+    );
+
+  // Добавить элемент в массив по заданному индексу
+  void insert(
+      unsigned int _index,
+      bool         _value
+    );
+
+  // Добавить _count значений _value по заданному индексу
+  void insert(
+      unsigned int _index,
+      unsigned int _count,
+      bool         _value
+    );
+
+  // Удалить элемент массива по заданному индексу
+  void erase(
+      unsigned int _index
+    );
+
+  // Удалить элементы [_indexFrom, _indexTo)
+  void erase(
+      unsigned int _indexFrom,
+      unsigned int _indexTo
+    );
+
+  // Изменить размер массива, заполнив новые элементы значением _value
+  void resize(
+      unsigned int _count,
+      bool         _value = false
+    );
+
+  // Очистить массив
+  void clear();
+
+  // Зарезервировать память под заданное количество элементов
+  void reserve(
+      unsigned int _capacity
+    );
+
+  // Получить размер массива
+  unsigned int size() const;
+
+  // Определить что массив пустой
+  bool empty() const;
+
+  // Получить значение элемента
+  bool test(
+      unsigned int _index
+    ) const;
+
+  // Установить значение элемента
+  void set(
+      unsigned int _index,
+      bool         _value = true
+    );
+
+  // Установить значение элементов [_indexFrom, _indexTo)
+  void set(
+      unsigned int _indexFrom,
+      unsigned int _indexTo,
+      bool         _value
+    );
+
+  // Инвертировать значение элемента
+  void flip(
+      unsigned int _index
+    );
+
+  // Получить количество установленных элементов
+  unsigned int count() const;
+
+  // Получить индекс первого установленного элемента (npos, если нет)
+  unsigned int find_first() const;
+
+  // Получить индекс первого установленного элемента после _index
+  // (npos, если нет)
+  unsigned int find_next(
+      unsigned int _index
+    ) const;
+
+  // Логические операции с массивом того же размера
+  CBitArray & operator&=(
+      const CBitArray & _array
+    );
+
+  CBitArray & operator|=(
+      const CBitArray & _array
+    );
+
+  CBitArray & operator^=(
+      const CBitArray & _array
+    );
+
+  // Сбросить элементы, установленные в _array (this &= ~_array)
+  CBitArray & and_not(
+      const CBitArray & _array
+    );
+
+  bool operator==(
+      const CBitArray & _array
+    ) const;
+
+  bool operator!=(
+      const CBitArray & _array
+    ) const;
+
+  // Получить элемент массива по заданному индексу
+  reference operator[](
+      unsigned int _index
+    );
+
+  bool operator[](
+      unsigned int _index
+    ) const;
+
+  iterator        begin();
+  const_iterator  begin()  const;
+  const_iterator  cbegin() const;
+  iterator        end();
+  const_iterator  end()    const;
+  const_iterator  cend()   const;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Ссылка на элемент массива
+  class reference
+  {
+    friend CBitArray;
+
+  public:
+
+    operator bool() const
+    {
+      return (*m_word & m_mask) != 0;
+    }
+
+    reference & operator=(
+        bool _value
+      )
+    {
+      *m_word = _value ? (*m_word | m_mask) : (*m_word & ~m_mask);
+      return *this;
+    }
+
+    reference & operator=(
+        const reference & _reference
+      )
+    {
+      return *this = static_cast<bool>(_reference);
+    }
+
+    void flip()
+    {
+      *m_word ^= m_mask;
+    }
+
+  private:
+
+    reference(
+        uint64_t * _word,
+        uint64_t   _mask
+      )
+      : m_word(_word),
+        m_mask(_mask)
+    {
+    }
+
+    uint64_t * m_word;
+    uint64_t   m_mask;
+  };
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Итератор по элементам массива
+  template <typename TArray, typename TReference>
+  class iterator_base
+  {
+  public:
+
+    // iterator traits
+    using difference_type   = int;
+    using value_type        = bool;
+    using pointer           = void;
+    using reference         = TReference;
+    using iterator_category = std::random_access_iterator_tag;
+
+    iterator_base() = default;
+
+    iterator_base(
+        TArray *     _array,
+        unsigned int _index
+      )
+      : m_array(_array),
+        m_index(_index)
+    {
+    }
+
+    // Преобразование iterator в const_iterator
+    operator iterator_base<const CBitArray, bool>() const
+    {
+      return iterator_base<const CBitArray, bool>(m_array, m_index);
+    }
+
+    TReference operator*() const            { return (*m_array)[m_index]; }
+    TReference operator[](int _offset) const { return (*m_array)[m_index + _offset]; }
+
+    iterator_base & operator++()    { ++m_index; return *this; }
+    iterator_base & operator--()    { --m_index; return *this; }
+    iterator_base   operator++(int) { iterator_base tmp(*this); ++m_index; return tmp; }
+    iterator_base   operator--(int) { iterator_base tmp(*this); --m_index; return tmp; }
+
+    iterator_base & operator+=(int _offset)      { m_index += _offset; return *this; }
+    iterator_base & operator-=(int _offset)      { m_index -= _offset; return *this; }
+    iterator_base   operator+(int _offset) const { return iterator_base(m_array, m_index + _offset); }
+    iterator_base   operator-(int _offset) const { return iterator_base(m_array, m_index - _offset); }
+
+    friend iterator_base operator+(int _offset, const iterator_base & _it) { return _it + _offset; }
+
+    int operator-(const iterator_base & _it) const { return static_cast<int>(m_index - _it.m_index); }
+
+    bool operator==(const iterator_base & _it) const { return m_index == _it.m_index; }
+    bool operator!=(const iterator_base & _it) const { return m_index != _it.m_index; }
+    bool operator< (const iterator_base & _it) const { return m_index <  _it.m_index; }
+    bool operator> (const iterator_base & _it) const { return m_index >  _it.m_index; }
+    bool operator<=(const iterator_base & _it) const { return m_index <= _it.m_index; }
+    bool operator>=(const iterator_base & _it) const { return m_index >= _it.m_index; }
+
+  private:
+
+    TArray *     m_array = nullptr;
+    unsigned int m_index = 0;
+  };
+
+protected:  // Методы
+
+  static constexpr unsigned int WordBits = 64;
+
+  // Получить количество слов для _count элементов
+  static unsigned int wordsFor(
+      unsigned int _count
+    );
+
+  // Получить указатель на первое слово (nullptr для пустого массива)
+  uint64_t * words();
+
+  const uint64_t * words() const;
+
+  // Изменить количество слов, заполняя новые слова нулями
+  void resizeWords(
+      unsigned int _count
+    );
+
+  // Получить 64 бита, начиная с позиции _position (позиции за концом
+  // массива дают нули)
+  uint64_t bitsAt(
+      unsigned int _position
+    ) const;
+
+  // Обнулить биты последнего слова за пределами размера
+  void clearTail();
+
+  // Выполнить _op(word, otherWord) для всех слов
+  template <typename TOperation>
+  CBitArray & combine(
+      const CBitArray & _array,
+      TOperation        _op
+    );
+
+protected: // Attributes
+
+  CArray<uint64_t> m_words;     //< Слова с битами элементов
+  unsigned int     m_size = 0;  //< Количество элементов
+};
+
+//----------------------------------------------------------------------------//
+inline
+CBitArray::CBitArray(
+    unsigned int _count,
+    bool         _value
+  )
+{
+  resize(_count, _value);
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CBitArray::push_back(
+    bool _value
+  )
+{
+  if (m_size % WordBits == 0)
+  {
+    m_words.push_back(0);
+  }
+
+  if (_value)
+  {
+    m_words[m_size / WordBits] |= uint64_t(1) << (m_size % WordBits);
+  }
+  ++m_size;
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CBitArray::insert(
+    unsigned int _index,
+    bool         _value
+  )
+{
+  insert(_index, 1, _value);
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CBitArray::insert(
+    unsigned int _index,
+    unsigned int _count,
+    bool         _value
+  )
+{
+  assert(_index <= m_size);
+
+  if (_count == 0)
+  {
+    return;
+  }
+
+  const unsigned int oldSize = m_size;
+  m_size += _count;
+  resizeWords(wordsFor(m_size));
+
+  // Хвост [_index, oldSize) сдвигается на _count позиций вправо. Слова
+  // обходятся от старших к младшим, поэтому источник еще не перезаписан.
+  uint64_t * const   pWords     = words();
+  const unsigned int indexWord  = _index / WordBits;
+  const uint64_t     indexBits  = pWords[indexWord];
+  const unsigned int firstWord  = (_index + _count) / WordBits;
+  const unsigned int lastWord   = wordsFor(m_size) - 1;
+
+  if (_index < oldSize)
+  {
+    for (unsigned int wordIndex = lastWord; ; --wordIndex)
+    {
+      const unsigned int position = wordIndex * WordBits;
+      uint64_t word;
+      if (position >= _count)
+      {
+        word = bitsAt(position - _count);
+      }
+      else
+      {
+        word = pWords[0] << (_count - position);
+      }
+      pWords[wordIndex] = word;
+
+      if (wordIndex == firstWord)
+      {
+        break;
+      }
+    }
+  }
+
+  // Биты перед _index восстанавливаются, вставленные заполняются
+  const uint64_t lowMask = lowBitsMask(_index % WordBits);
+  pWords[indexWord] = (pWords[indexWord] & ~lowMask) | (indexBits & lowMask);
+  set(_index, _index + _count, _value);
+  clearTail();
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CBitArray::erase(
+    unsigned int _index
+  )
+{
+  erase(_index, _index + 1);
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CBitArray::erase(
+    unsigned int _indexFrom,
+    unsigned int _indexTo
+  )
+{
+  assert(_indexFrom <= _indexTo && _indexTo <= m_size);
+
+  const unsigned int count = _indexTo - _indexFrom;
+  if (count == 0)
+  {
+    return;
+  }
+
+  // Хвост [_indexTo, m_size) сдвигается на count позиций влево. Слова
+  // обходятся от младших к старшим: источник всегда не левее приемника.
+  uint64_t * const   pWords    = words();
+  const unsigned int firstWord = _indexFrom / WordBits;
+  const unsigned int firstBit  = _indexFrom % WordBits;
+  const unsigned int wordCount = wordsFor(m_size);
+
+  const uint64_t lowMask = lowBitsMask(firstBit);
+  pWords[firstWord] = (pWords[firstWord] & lowMask) | (bitsAt(_indexTo) << firstBit);
+
+  for (unsigned int wordIndex = firstWord + 1; wordIndex < wordCount; ++wordIndex)
+  {
+    pWords[wordIndex] = bitsAt(wordIndex * WordBits + count);
+  }
+
+  m_size -= count;
+  resizeWords(wordsFor(m_size));
+  clearTail();
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CBitArray::resize(
+    unsigned int _count,
+    bool         _value
+  )
+{
+  if (_count <= m_size)
+  {
+    m_size = _count;
+    resizeWords(wordsFor(m_size));
+    clearTail();
+    return;
+  }
+
+  const unsigned int oldSize = m_size;
+  m_size = _count;
+  resizeWords(wordsFor(m_size));
+  set(oldSize, m_size, _value);
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CBitArray::clear()
+{
+  m_words.clear();
+  m_size = 0;
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CBitArray::reserve(
+    unsigned int _capacity
+  )
+{
+  m_words.reserve(wordsFor(_capacity));
+}
+
+//----------------------------------------------------------------------------//
+inline unsigned int
+CBitArray::size() const
+{
+  return m_size;
+}
+
+//----------------------------------------------------------------------------//
+inline bool
+CBitArray::empty() const
+{
+  return m_size == 0;
+}
+
+//----------------------------------------------------------------------------//
+inline bool
+CBitArray::test(
+    unsigned int _index
+  ) const
+{
+  assert(_index < m_size);
+
+  return (m_words[_index / WordBits] >> (_index % WordBits)) & 1;
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CBitArray::set(
+    unsigned int _index,
+    bool         _value
+  )
+{
+  assert(_index < m_size);
+
+  (*this)[_index] = _value;
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CBitArray::set(
+    unsigned int _indexFrom,
+    unsigned int _indexTo,
+    bool         _value
+  )
+{
+  assert(_indexFrom <= _indexTo && _indexTo <= m_size);
+
+  if (_indexFrom == _indexTo)
+  {
+    return;
+  }
+
+  uint64_t * const   pWords    = words();
+  const unsigned int firstWord = _indexFrom / WordBits;
+  const unsigned int lastWord  = (_indexTo - 1) / WordBits;
+  const uint64_t     fill      = _value ? ~uint64_t(0) : 0;
+
+  for (unsigned int wordIndex = firstWord; wordIndex <= lastWord; ++wordIndex)
+  {
+    uint64_t mask = ~uint64_t(0);
+    if (wordIndex == firstWord)
+    {
+      mask &= ~lowBitsMask(_indexFrom % WordBits);
+    }
+    if (wordIndex == lastWord)
+    {
+      mask &= lowBitsMask(_indexTo - lastWord * WordBits);
+    }
+
+    pWords[wordIndex] = (pWords[wordIndex] & ~mask) | (fill & mask);
+  }
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CBitArray::flip(
+    unsigned int _index
+  )
+{
+  assert(_index < m_size);
+
+  m_words[_index / WordBits] ^= uint64_t(1) << (_index % WordBits);
+}
+
+//----------------------------------------------------------------------------//
+inline unsigned int
+CBitArray::count() const
+{
+  const uint64_t * const pWords    = words();
+  const unsigned int     wordCount = m_words.size();
+
+  unsigned int result = 0;
+  for (unsigned int wordIndex = 0; wordIndex < wordCount; ++wordIndex)
+  {
+    result += bitCount(pWords[wordIndex]);
+  }
+
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+inline unsigned int
+CBitArray::find_first() const
+{
+  return m_size ? (test(0) ? 0 : find_next(0)) : npos;
+}
+
+//----------------------------------------------------------------------------//
+inline unsigned int
+CBitArray::find_next(
+    unsigned int _index
+  ) const
+{
+  const unsigned int position = _index + 1;
+  if (position >= m_size)
+  {
+    return npos;
+  }
+
+  const uint64_t * const pWords    = words();
+  const unsigned int     wordCount = m_words.size();
+
+  unsigned int wordIndex = position / WordBits;
+  uint64_t     word      = pWords[wordIndex] & ~lowBitsMask(position % WordBits);
+  while (word == 0)
+  {
+    if (++wordIndex == wordCount)
+    {
+      return npos;
+    }
+    word = pWords[wordIndex];
+  }
+
+  return wordIndex * WordBits + lowestBitIndex(word);
+}
+
+//----------------------------------------------------------------------------//
+inline CBitArray &
+CBitArray::operator&=(
+    const CBitArray & _array
+  )
+{
+  return combine(_array, [](uint64_t _word, uint64_t _other) { return _word & _other; });
+}
+
+//----------------------------------------------------------------------------//
+inline CBitArray &
+CBitArray::operator|=(
+    const CBitArray & _array
+  )
+{
+  return combine(_array, [](uint64_t _word, uint64_t _other) { return _word | _other; });
+}
+
+//----------------------------------------------------------------------------//
+inline CBitArray &
+CBitArray::operator^=(
+    const CBitArray & _array
+  )
+{
+  return combine(_array, [](uint64_t _word, uint64_t _other) { return _word ^ _other; });
+}
+
+//----------------------------------------------------------------------------//
+inline CBitArray &
+CBitArray::and_not(
+    const CBitArray & _array
+  )
+{
+  return combine(_array, [](uint64_t _word, uint64_t _other) { return _word & ~_other; });
+}
+
+//----------------------------------------------------------------------------//
+inline bool
+CBitArray::operator==(
+    const CBitArray & _array
+  ) const
+{
+  if (m_size != _array.m_size)
+  {
+    return false;
+  }
+
+  const uint64_t * const pWords    = words();
+  const uint64_t * const pOther    = _array.words();
+  const unsigned int     wordCount = m_words.size();
+
+  uint64_t difference = 0;
+  for (unsigned int wordIndex = 0; wordIndex < wordCount; ++wordIndex)
+  {
+    difference |= pWords[wordIndex] ^ pOther[wordIndex];
+  }
+
+  return difference == 0;
+}
+
+//----------------------------------------------------------------------------//
+inline bool
+CBitArray::operator!=(
+    const CBitArray & _array
+  ) const
+{
+  return !(*this == _array);
+}
+
+//----------------------------------------------------------------------------//
+inline CBitArray::reference
+CBitArray::operator[](
+    unsigned int _index
+  )
+{
+  assert(_index < m_size);
+
+  return reference(&m_words[_index / WordBits], uint64_t(1) << (_index % WordBits));
+}
+
+//----------------------------------------------------------------------------//
+inline bool
+CBitArray::operator[](
+    unsigned int _index
+  ) const
+{
+  return test(_index);
+}
+
+//----------------------------------------------------------------------------//
+inline CBitArray::iterator
+CBitArray::begin()
+{
+  return iterator(this, 0);
+}
+
+//----------------------------------------------------------------------------//
+inline CBitArray::const_iterator
+CBitArray::begin() const
+{
+  return cbegin();
+}
+
+//----------------------------------------------------------------------------//
+inline CBitArray::const_iterator
+CBitArray::cbegin() const
+{
+  return const_iterator(this, 0);
+}
+
+//----------------------------------------------------------------------------//
+inline CBitArray::iterator
+CBitArray::end()
+{
+  return iterator(this, m_size);
+}
+
+//----------------------------------------------------------------------------//
+inline CBitArray::const_iterator
+CBitArray::end() const
+{
+  return cend();
+}
+
+//----------------------------------------------------------------------------//
+inline CBitArray::const_iterator
+CBitArray::cend() const
+{
+  return const_iterator(this, m_size);
+}
+
+//----------------------------------------------------------------------------//
+inline unsigned int
+CBitArray::wordsFor(
+    unsigned int _count
+  )
+{
+  return _count / WordBits + (_count % WordBits != 0);
+}
+
+//----------------------------------------------------------------------------//
+inline uint64_t *
+CBitArray::words()
+{
+  return m_words.empty() ? nullptr : &m_words[0];
+}
+
+//----------------------------------------------------------------------------//
+inline const uint64_t *
+CBitArray::words() const
+{
+  return m_words.empty() ? nullptr : &m_words[0];
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CBitArray::resizeWords(
+    unsigned int _count
+  )
+{
+  const unsigned int wordCount = m_words.size();
+  if (_count < wordCount)
+  {
+    m_words.erase(m_words.begin() + _count, m_words.end());
+    return;
+  }
+
+  m_words.reserve(_count);
+  for (unsigned int wordIndex = wordCount; wordIndex < _count; ++wordIndex)
+  {
+    m_words.push_back(0);
+  }
+}
+
+//----------------------------------------------------------------------------//
+inline uint64_t
+CBitArray::bitsAt(
+    unsigned int _position
+  ) const
+{
+  const uint64_t * const pWords    = words();
+  const unsigned int     wordCount = m_words.size();
+  const unsigned int     wordIndex = _position / WordBits;
+  const unsigned int     bitIndex  = _position % WordBits;
+
+  if (wordIndex >= wordCount)
+  {
+    return 0;
+  }
+
+  uint64_t word = pWords[wordIndex] >> bitIndex;
+  if (bitIndex && wordIndex + 1 < wordCount)
+  {
+    word |= pWords[wordIndex + 1] << (WordBits - bitIndex);
+  }
+
+  return word;
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CBitArray::clearTail()
+{
+  if (m_size % WordBits)
+  {
+    m_words[m_size / WordBits] &= lowBitsMask(m_size % WordBits);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TOperation>
+CBitArray &
+CBitArray::combine(
+    const CBitArray & _array,
+    TOperation        _op
+  )
+{
+  assert(m_size == _array.m_size);
+
+  uint64_t * const       pWords    = words();
+  const uint64_t * const pOther    = _array.words();
+  const unsigned int     wordCount = m_words.size();
+
+  for (unsigned int wordIndex = 0; wordIndex < wordCount; ++wordIndex)
+  {
+    pWords[wordIndex] = _op(pWords[wordIndex], pOther[wordIndex]);
+  }
+
+  return *this;
+}
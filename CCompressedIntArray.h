@@ -0,0 +1,617 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+#include <iterator>
+#include <type_traits>
+
+#include "CArray.h"
+#include "CArrayBits.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// class CCompressedIntArray - массив целых чисел, сжатых блоками по
+// BlockSize значений.
+//
+// Заполненный блок хранится одним из двух способов, какой короче:
+//  - относительно минимума (frame of reference): упакованы разности
+//    значений с минимумом блока;
+//  - разностями соседних значений (delta): упакованы разности с предыдущим
+//    значением, в заголовке - первое значение блока. Для возрастающих
+//    рядов (идентификаторы, отметки времени) ширина определяется шагом,
+//    а не разбросом блока. Вслед за разностями упакованы контрольные
+//    точки: смещения каждого CheckpointStep-го значения от первого.
+// Ширина в битах одна на блок, поэтому operator[] распаковывает значение,
+// не выходя за пределы блока: одним извлечением для первого способа и
+// от ближайшей контрольной точки, не более CheckpointStep - 1 разностей,
+// для второго. Контрольные точки учитываются при выборе способа.
+// Последние (неполный блок) значения хранятся несжатыми и упаковываются
+// при заполнении блока.
+//
+// Для упорядоченных по возрастанию значений база блока совпадает с его
+// первым элементом, что позволяет lower_bound искать блок по заголовкам и
+// распаковывать только один блок.
+template <typename TData>
+class CCompressedIntArray
+{
+  static_assert(std::is_integral<TData>::value && !std::is_same<TData, bool>::value,
+                "CCompressedIntArray requires an integral type");
+
+public: // Interface
+
+  class const_iterator;
+  using iterator = const_iterator;
+
+  // Количество значений в блоке
+  static constexpr unsigned int BlockSize = 128;
+
+  // Конструктор по умолчанию
+  CCompressedIntArray() = default;
+
+  // Добавить значение в конец массива
+  void push_back(
+      TData _value
+    );
+
+  // Очистить массив
+  void clear();
+
+  // Получить размер массива
+  unsigned int size() const;
+
+  // Определить что массив пустой
+  bool empty() const;
+
+  // Получить значение по заданному индексу
+  TData operator[](
+      unsigned int _index
+    ) const;
+
+  // Вызвать _func(value) для всех значений по порядку, распаковывая
+  // блоки целиком
+  template <typename TFunc>
+  void for_each(
+      TFunc _func
+    ) const;
+
+  // Распаковать значения блока _blockIndex в _pOutput (BlockSize значений;
+  // для неполного последнего блока - оставшиеся). Возвращает количество.
+  unsigned int decode_block(
+      unsigned int _blockIndex,
+      TData *      _pOutput
+    ) const;
+
+  // Получить количество блоков, включая неполный последний
+  unsigned int block_count() const;
+
+  // Получить индекс первого значения, не меньшего _value. Значения должны
+  // быть упорядочены по возрастанию.
+  unsigned int lower_bound(
+      TData _value
+    ) const;
+
+  // Получить объем памяти, занятой массивом, в байтах
+  size_t memoryUsage() const;
+
+  const_iterator begin()  const;
+  const_iterator cbegin() const;
+  const_iterator end()    const;
+  const_iterator cend()   const;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Итератор по значениям массива
+  class const_iterator
+  {
+  public:
+
+    // iterator traits
+    using difference_type   = int;
+    using value_type        = TData;
+    using pointer           = void;
+    using reference         = TData;
+    using iterator_category = std::random_access_iterator_tag;
+
+    const_iterator() = default;
+
+    const_iterator(
+        const CCompressedIntArray * _array,
+        unsigned int                _index
+      )
+      : m_array(_array),
+        m_index(_index)
+    {
+    }
+
+    TData operator*() const               { return (*m_array)[m_index]; }
+    TData operator[](int _offset) const   { return (*m_array)[m_index + _offset]; }
+
+    const_iterator & operator++()    { ++m_index; return *this; }
+    const_iterator & operator--()    { --m_index; return *this; }
+    const_iterator   operator++(int) { const_iterator tmp(*this); ++m_index; return tmp; }
+    const_iterator   operator--(int) { const_iterator tmp(*this); --m_index; return tmp; }
+
+    const_iterator & operator+=(int _offset)      { m_index += _offset; return *this; }
+    const_iterator & operator-=(int _offset)      { m_index -= _offset; return *this; }
+    const_iterator   operator+(int _offset) const { return const_iterator(m_array, m_index + _offset); }
+    const_iterator   operator-(int _offset) const { return const_iterator(m_array, m_index - _offset); }
+
+    friend const_iterator operator+(int _offset, const const_iterator & _it) { return _it + _offset; }
+
+    int operator-(const const_iterator & _it) const { return static_cast<int>(m_index - _it.m_index); }
+
+    bool operator==(const const_iterator & _it) const { return m_index == _it.m_index; }
+    bool operator!=(const const_iterator & _it) const { return m_index != _it.m_index; }
+    bool operator< (const const_iterator & _it) const { return m_index <  _it.m_index; }
+    bool operator> (const const_iterator & _it) const { return m_index >  _it.m_index; }
+    bool operator<=(const const_iterator & _it) const { return m_index <= _it.m_index; }
+    bool operator>=(const const_iterator & _it) const { return m_index >= _it.m_index; }
+
+  private:
+
+    const CCompressedIntArray * m_array = nullptr;
+    unsigned int                m_index = 0;
+  };
+
+protected:  // Методы
+
+  using TUnsigned = std::make_unsigned_t<TData>;
+
+  static constexpr unsigned int WordBits = 64;
+
+  // Шаг контрольных точек блока с разностями
+  static constexpr unsigned int CheckpointStep  = 16;
+  static constexpr unsigned int CheckpointCount = BlockSize / CheckpointStep;
+
+  // Заголовок упакованного блока
+  struct Block
+  {
+    TUnsigned     m_base;             //< Минимум блока или первое значение (m_delta)
+    unsigned int  m_wordOffset;       //< Смещение упакованных разностей в m_words
+    unsigned char m_width;            //< Ширина разности в битах
+    unsigned char m_checkpointWidth;  //< Ширина контрольной точки в битах (m_delta)
+    bool          m_delta;            //< Разности с предыдущим значением
+  };
+
+  // Упаковать заполненный хвост в новый блок
+  void packTail();
+
+  // Добавить в конец m_words _count значений шириной _width бит
+  void packWords(
+      const TUnsigned * _pValues,
+      unsigned int      _count,
+      unsigned int      _width
+    );
+
+  // Распаковать блок _blockIndex и найти в нем первое значение, не меньшее
+  // _value. Возвращает позицию в блоке (BlockSize, если такого нет).
+  unsigned int lowerBoundInBlock(
+      unsigned int _blockIndex,
+      TData        _value
+    ) const;
+
+  // Получить ширину в битах, достаточную для _value
+  static unsigned int widthOf(
+      TUnsigned _value
+    );
+
+  // Получить разность _position-го значения блока
+  static TUnsigned unpack(
+      const uint64_t * _pWords,
+      unsigned int     _width,
+      unsigned int     _position
+    );
+
+protected: // Attributes
+
+  CArray<Block>    m_blocks;     //< Заголовки упакованных блоков
+  CArray<uint64_t> m_words;      //< Упакованные разности всех блоков
+  CArray<TData>    m_tail;       //< Несжатые значения неполного блока
+};
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CCompressedIntArray<TData>::push_back(
+    TData _value
+  )
+{
+  if (m_tail.empty())
+  {
+    m_tail.reserve(BlockSize);
+  }
+
+  m_tail.push_back(_value);
+  if (m_tail.size() == BlockSize)
+  {
+    packTail();
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CCompressedIntArray<TData>::clear()
+{
+  m_blocks.clear();
+  m_words.clear();
+  m_tail.clear();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+unsigned int
+CCompressedIntArray<TData>::size() const
+{
+  return m_blocks.size() * BlockSize + m_tail.size();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+bool
+CCompressedIntArray<TData>::empty() const
+{
+  return size() == 0;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+TData
+CCompressedIntArray<TData>::operator[](
+    unsigned int _index
+  ) const
+{
+  assert(_index < size());
+
+  const unsigned int blockIndex = _index / BlockSize;
+  if (blockIndex == m_blocks.size())
+  {
+    return m_tail[_index % BlockSize];
+  }
+
+  const Block & block = m_blocks[blockIndex];
+  if (block.m_width == 0)
+  {
+    return static_cast<TData>(block.m_base);
+  }
+
+  const uint64_t * const pWords   = &m_words[block.m_wordOffset];
+  const unsigned int     position = _index % BlockSize;
+  if (!block.m_delta)
+  {
+    return static_cast<TData>(static_cast<TUnsigned>(block.m_base + unpack(pWords, block.m_width, position)));
+  }
+
+  // Ближайшая контрольная точка не дальше position, затем разности до нее
+  const unsigned int checkpoint = position / CheckpointStep;
+
+  // Нулевая ширина: все контрольные точки равны нулю и не записаны в m_words
+  TUnsigned value = block.m_base;
+  if (checkpoint && block.m_checkpointWidth)
+  {
+    const uint64_t * const pCheckpoints = pWords + BlockSize / WordBits * block.m_width;
+    value = static_cast<TUnsigned>(value + unpack(pCheckpoints, block.m_checkpointWidth, checkpoint));
+  }
+
+  for (unsigned int deltaIndex = checkpoint * CheckpointStep + 1; deltaIndex <= position; ++deltaIndex)
+  {
+    value = static_cast<TUnsigned>(value + unpack(pWords, block.m_width, deltaIndex));
+  }
+  return static_cast<TData>(value);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+template <typename TFunc>
+void
+CCompressedIntArray<TData>::for_each(
+    TFunc _func
+  ) const
+{
+  TData values[BlockSize];
+
+  const unsigned int blockCount = block_count();
+  for (unsigned int blockIndex = 0; blockIndex < blockCount; ++blockIndex)
+  {
+    const unsigned int count = decode_block(blockIndex, values);
+    for (unsigned int index = 0; index < count; ++index)
+    {
+      _func(values[index]);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+unsigned int
+CCompressedIntArray<TData>::decode_block(
+    unsigned int _blockIndex,
+    TData *      _pOutput
+  ) const
+{
+  assert(_blockIndex < block_count());
+
+  if (_blockIndex == m_blocks.size())
+  {
+    const unsigned int count = m_tail.size();
+    std::copy(m_tail.begin(), m_tail.end(), _pOutput);
+    return count;
+  }
+
+  const Block &   block = m_blocks[_blockIndex];
+  const TUnsigned base  = block.m_base;
+  if (block.m_width == 0)
+  {
+    std::fill(_pOutput, _pOutput + BlockSize, static_cast<TData>(base));
+    return BlockSize;
+  }
+
+  const uint64_t * const pWords = &m_words[block.m_wordOffset];
+  const unsigned int     width  = block.m_width;
+
+  if (!block.m_delta)
+  {
+    for (unsigned int position = 0; position < BlockSize; ++position)
+    {
+      _pOutput[position] = static_cast<TData>(static_cast<TUnsigned>(base + unpack(pWords, width, position)));
+    }
+  }
+  else
+  {
+    TUnsigned value = base;
+    for (unsigned int position = 0; position < BlockSize; ++position)
+    {
+      value = static_cast<TUnsigned>(value + unpack(pWords, width, position));
+      _pOutput[position] = static_cast<TData>(value);
+    }
+  }
+
+  return BlockSize;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+unsigned int
+CCompressedIntArray<TData>::block_count() const
+{
+  return m_blocks.size() + (m_tail.empty() ? 0 : 1);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+unsigned int
+CCompressedIntArray<TData>::lower_bound(
+    TData _value
+  ) const
+{
+  // Первый упакованный блок с минимумом не меньше _value: первое
+  // подходящее значение находится в конце предыдущего блока или
+  // с начала этого
+  const unsigned int blockCount = m_blocks.size();
+
+  unsigned int low  = 0;
+  unsigned int high = blockCount;
+  while (low < high)
+  {
+    const unsigned int middle = low + (high - low) / 2;
+    if (static_cast<TData>(m_blocks[middle].m_base) < _value)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+
+  if (low > 0)
+  {
+    const unsigned int position = lowerBoundInBlock(low - 1, _value);
+    if (position < BlockSize)
+    {
+      return (low - 1) * BlockSize + position;
+    }
+  }
+
+  if (low < blockCount || m_tail.empty())
+  {
+    return low * BlockSize;
+  }
+
+  // Все упакованные значения меньше _value - поиск в несжатом хвосте
+  const TData * const pTail = &m_tail[0];
+  return blockCount * BlockSize
+       + static_cast<unsigned int>(std::lower_bound(pTail, pTail + m_tail.size(), _value) - pTail);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+size_t
+CCompressedIntArray<TData>::memoryUsage() const
+{
+  return sizeof(*this)
+       + size_t(m_blocks.capacity()) * sizeof(Block)
+       + size_t(m_words.capacity())  * sizeof(uint64_t)
+       + size_t(m_tail.capacity())   * sizeof(TData);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CCompressedIntArray<TData>::const_iterator
+CCompressedIntArray<TData>::begin() const
+{
+  return cbegin();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CCompressedIntArray<TData>::const_iterator
+CCompressedIntArray<TData>::cbegin() const
+{
+  return const_iterator(this, 0);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CCompressedIntArray<TData>::const_iterator
+CCompressedIntArray<TData>::end() const
+{
+  return cend();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CCompressedIntArray<TData>::const_iterator
+CCompressedIntArray<TData>::cend() const
+{
+  return const_iterator(this, size());
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CCompressedIntArray<TData>::packTail()
+{
+  assert(m_tail.size() == BlockSize);
+
+  const TData * const pTail = &m_tail[0];
+  const TUnsigned     min   = static_cast<TUnsigned>(*std::min_element(pTail, pTail + BlockSize));
+  const TUnsigned     first = static_cast<TUnsigned>(pTail[0]);
+
+  // Разности для обоих способов: с минимумом и с предыдущим значением
+  // (для первого значения блока - ноль)
+  TUnsigned deltas[BlockSize];
+  TUnsigned maxOffset = 0;
+  TUnsigned maxDelta  = 0;
+  for (unsigned int position = 0; position < BlockSize; ++position)
+  {
+    const TUnsigned value = static_cast<TUnsigned>(pTail[position]);
+    const TUnsigned prev  = position ? static_cast<TUnsigned>(pTail[position - 1]) : value;
+
+    deltas[position] = static_cast<TUnsigned>(value - prev);
+    maxOffset        = std::max<TUnsigned>(maxOffset, static_cast<TUnsigned>(value - min));
+    maxDelta         = std::max<TUnsigned>(maxDelta,  deltas[position]);
+  }
+
+  // Контрольные точки: смещения каждого CheckpointStep-го значения
+  // от первого
+  TUnsigned checkpoints[CheckpointCount];
+  TUnsigned maxCheckpoint = 0;
+  for (unsigned int checkpoint = 0; checkpoint < CheckpointCount; ++checkpoint)
+  {
+    checkpoints[checkpoint] = static_cast<TUnsigned>(static_cast<TUnsigned>(pTail[checkpoint * CheckpointStep]) - first);
+    maxCheckpoint           = std::max<TUnsigned>(maxCheckpoint, checkpoints[checkpoint]);
+  }
+
+  const unsigned int offsetWidth     = widthOf(maxOffset);
+  const unsigned int deltaWidth      = widthOf(maxDelta);
+  const unsigned int checkpointWidth = widthOf(maxCheckpoint);
+
+  Block block;
+  block.m_wordOffset      = m_words.size();
+  block.m_delta           = BlockSize * deltaWidth + CheckpointCount * checkpointWidth < BlockSize * offsetWidth;
+  block.m_base            = block.m_delta ? first : min;
+  block.m_width           = static_cast<unsigned char>(block.m_delta ? deltaWidth : offsetWidth);
+  block.m_checkpointWidth = static_cast<unsigned char>(block.m_delta ? checkpointWidth : 0);
+
+  if (!block.m_delta)
+  {
+    for (unsigned int position = 0; position < BlockSize; ++position)
+    {
+      deltas[position] = static_cast<TUnsigned>(static_cast<TUnsigned>(pTail[position]) - min);
+    }
+  }
+
+  packWords(deltas, BlockSize, block.m_width);
+  if (block.m_delta)
+  {
+    packWords(checkpoints, CheckpointCount, block.m_checkpointWidth);
+  }
+
+  m_blocks.push_back(block);
+
+  // Память хвоста сохраняется для следующего блока
+  m_tail.erase(m_tail.begin(), m_tail.end());
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CCompressedIntArray<TData>::packWords(
+    const TUnsigned * _pValues,
+    unsigned int      _count,
+    unsigned int      _width
+  )
+{
+  const unsigned int wordOffset = m_words.size();
+  const unsigned int wordCount  = (_count * _width + WordBits - 1) / WordBits;
+  if (wordCount == 0)
+  {
+    return;
+  }
+
+  for (unsigned int wordIndex = 0; wordIndex < wordCount; ++wordIndex)
+  {
+    m_words.push_back(0);
+  }
+
+  uint64_t * const pWords = &m_words[wordOffset];
+  for (unsigned int position = 0; position < _count; ++position)
+  {
+    const uint64_t     value       = _pValues[position];
+    const unsigned int bitPosition = position * _width;
+    const unsigned int wordIndex   = bitPosition / WordBits;
+    const unsigned int bitIndex    = bitPosition % WordBits;
+
+    pWords[wordIndex] |= value << bitIndex;
+    if (bitIndex + _width > WordBits)
+    {
+      pWords[wordIndex + 1] |= value >> (WordBits - bitIndex);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+unsigned int
+CCompressedIntArray<TData>::lowerBoundInBlock(
+    unsigned int _blockIndex,
+    TData        _value
+  ) const
+{
+  TData values[BlockSize];
+  decode_block(_blockIndex, values);
+
+  return static_cast<unsigned int>(std::lower_bound(values, values + BlockSize, _value) - values);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+unsigned int
+CCompressedIntArray<TData>::widthOf(
+    TUnsigned _value
+  )
+{
+  return _value ? highestBitIndex(_value) + 1 : 0;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CCompressedIntArray<TData>::TUnsigned
+CCompressedIntArray<TData>::unpack(
+    const uint64_t * _pWords,
+    unsigned int     _width,
+    unsigned int     _position
+  )
+{
+  const unsigned int bitPosition = _position * _width;
+  const unsigned int wordIndex   = bitPosition / WordBits;
+  const unsigned int bitIndex    = bitPosition % WordBits;
+
+  uint64_t bits = _pWords[wordIndex] >> bitIndex;
+  if (bitIndex + _width > WordBits)
+  {
+    bits |= _pWords[wordIndex + 1] << (WordBits - bitIndex);
+  }
+
+  return static_cast<TUnsigned>(bits & lowBitsMask(_width));
+}
@@ -0,0 +1,763 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cassert>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+#include "CArray.h"
+#include "CArrayBits.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// class CDictArray - массив со словарным кодированием значений.
+//
+// Различные значения хранятся один раз в словаре, а элементы массива -
+// кодами (индексами в словаре). Ширина кода выбирается по размеру
+// словаря: 8, 16 или 32 бита, и увеличивается при его росте.
+// Условия contains/count_if/erase_if вычисляются один раз для каждого
+// значения словаря, после чего просматриваются только коды - простые
+// циклы по узким целым, которые компилятор векторизует.
+//
+// Значения хранятся только в словаре: поиск кода по значению выполняется
+// по хеш-таблице кодов с открытой адресацией, ячейки которой ссылаются
+// на словарь.
+//
+// Значения, на которые не осталось ссылок, остаются в словаре до вызова
+// compact_dictionary() или clear().
+template <typename TData, typename THash = std::hash<TData>>
+class CDictArray
+{
+public: // Interface
+
+  class const_iterator;
+  using iterator = const_iterator;
+
+  // Конструктор по умолчанию
+  CDictArray() = default;
+
+  // Добавить элемент в конец массива
+  void push_back(
+      const TData & _value
+    );
+
+  // Добавить элемент в массив по заданному индексу
+  void insert(
+      unsigned int  _index,
+      const TData & _value
+    );
+
+  // Заменить элемент массива по заданному индексу
+  void set(
+      unsigned int  _index,
+      const TData & _value
+    );
+
+  // Удалить элемент массива по заданному индексу
+  void erase(
+      unsigned int _index
+    );
+
+  // Удалить элементы, удовлетворяющие условию. Условие вызывается по разу
+  // для каждого значения словаря. Возвращает количество удаленных.
+  template <typename TPredicate>
+  unsigned int erase_if(
+      TPredicate _pred
+    );
+
+  // Определить наличие элемента, равного _value
+  bool contains(
+      const TData & _value
+    ) const;
+
+  // Получить количество элементов, равных _value
+  unsigned int count(
+      const TData & _value
+    ) const;
+
+  // Получить количество элементов, удовлетворяющих условию
+  template <typename TPredicate>
+  unsigned int count_if(
+      TPredicate _pred
+    ) const;
+
+  // Удалить из словаря значения, на которые нет ссылок, и по возможности
+  // сузить коды
+  void compact_dictionary();
+
+  // Очистить массив и словарь
+  void clear();
+
+  // Получить размер массива
+  unsigned int size() const;
+
+  // Определить что массив пустой
+  bool empty() const;
+
+  // Получить количество значений в словаре
+  unsigned int dictionary_size() const;
+
+  // Получить ширину кода в байтах (1, 2 или 4)
+  unsigned int code_width() const;
+
+  // Получить элемент массива по заданному индексу
+  const TData & operator[](
+      unsigned int _index
+    ) const;
+
+  const_iterator begin()  const;
+  const_iterator cbegin() const;
+  const_iterator end()    const;
+  const_iterator cend()   const;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Итератор по элементам массива
+  class const_iterator
+  {
+  public:
+
+    // iterator traits
+    using difference_type   = int;
+    using value_type        = TData;
+    using pointer           = const TData *;
+    using reference         = const TData &;
+    using iterator_category = std::random_access_iterator_tag;
+
+    const_iterator() = default;
+
+    const_iterator(
+        const CDictArray * _array,
+        unsigned int       _index
+      )
+      : m_array(_array),
+        m_index(_index)
+    {
+    }
+
+    const TData & operator*() const              { return (*m_array)[m_index]; }
+    const TData * operator->() const             { return &(*m_array)[m_index]; }
+    const TData & operator[](int _offset) const  { return (*m_array)[m_index + _offset]; }
+
+    const_iterator & operator++()    { ++m_index; return *this; }
+    const_iterator & operator--()    { --m_index; return *this; }
+    const_iterator   operator++(int) { const_iterator tmp(*this); ++m_index; return tmp; }
+    const_iterator   operator--(int) { const_iterator tmp(*this); --m_index; return tmp; }
+
+    const_iterator & operator+=(int _offset)      { m_index += _offset; return *this; }
+    const_iterator & operator-=(int _offset)      { m_index -= _offset; return *this; }
+    const_iterator   operator+(int _offset) const { return const_iterator(m_array, m_index + _offset); }
+    const_iterator   operator-(int _offset) const { return const_iterator(m_array, m_index - _offset); }
+
+    friend const_iterator operator+(int _offset, const const_iterator & _it) { return _it + _offset; }
+
+    int operator-(const const_iterator & _it) const { return static_cast<int>(m_index - _it.m_index); }
+
+    bool operator==(const const_iterator & _it) const { return m_index == _it.m_index; }
+    bool operator!=(const const_iterator & _it) const { return m_index != _it.m_index; }
+    bool operator< (const const_iterator & _it) const { return m_index <  _it.m_index; }
+    bool operator> (const const_iterator & _it) const { return m_index >  _it.m_index; }
+    bool operator<=(const const_iterator & _it) const { return m_index <= _it.m_index; }
+    bool operator>=(const const_iterator & _it) const { return m_index >= _it.m_index; }
+
+  private:
+
+    const CDictArray * m_array = nullptr;
+    unsigned int       m_index = 0;
+  };
+
+protected:  // Методы
+
+  // Нет кода (значение отсутствует в словаре)
+  static constexpr unsigned int NoCode = ~0u;
+
+  // Получить код значения, добавив его в словарь при необходимости
+  unsigned int encode(
+      const TData & _value
+    );
+
+  // Получить код значения без добавления (NoCode, если значения нет)
+  unsigned int findCode(
+      const TData & _value
+    ) const;
+
+  // Получить ячейку хеш-таблицы с кодом значения или свободную ячейку,
+  // в которую его следует поместить (таблица не должна быть пустой)
+  unsigned int findSlot(
+      const TData & _value
+    ) const;
+
+  // Перестроить хеш-таблицу для _dictionarySize значений по текущему словарю
+  void rebuildIndex(
+      unsigned int _dictionarySize
+    );
+
+  // Получить код элемента по индексу
+  unsigned int codeAt(
+      unsigned int _index
+    ) const;
+
+  // Установить ширину кода (в байтах), перенеся коды
+  void setCodeWidth(
+      unsigned int _width
+    );
+
+  // Получить ширину кода, достаточную для _dictionarySize значений
+  static unsigned int widthFor(
+      unsigned int _dictionarySize
+    );
+
+  // Вызвать _func(codes) для массива кодов текущей ширины
+  template <typename TFunc>
+  decltype(auto) withCodes(
+      TFunc && _func
+    );
+
+  template <typename TFunc>
+  decltype(auto) withCodes(
+      TFunc && _func
+    ) const;
+
+  // Отметить коды значений словаря, удовлетворяющих условию.
+  // Возвращает количество отмеченных.
+  template <typename TPredicate>
+  unsigned int markCodes(
+      TPredicate &                _pred,
+      std::vector<unsigned char> & _marks
+    ) const;
+
+protected: // Attributes
+
+  CArray<TData>    m_dictionary;     //< Значения по кодам
+  CArray<uint32_t> m_index;          //< Хеш-таблица кодов (NoCode - свободная ячейка)
+  unsigned int     m_indexBits = 0;  //< Размер хеш-таблицы - 2^m_indexBits
+  CArray<uint8_t>  m_codes8;
+  CArray<uint16_t> m_codes16;
+  CArray<uint32_t> m_codes32;
+  unsigned int     m_codeWidth = 1;  //< Используемый массив кодов
+};
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CDictArray<TData, THash>::push_back(
+    const TData & _value
+  )
+{
+  const unsigned int code = encode(_value);
+  withCodes([code](auto & _codes) { _codes.push_back(static_cast<std::decay_t<decltype(_codes[0])>>(code)); });
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CDictArray<TData, THash>::insert(
+    unsigned int  _index,
+    const TData & _value
+  )
+{
+  assert(_index <= size());
+
+  const unsigned int code = encode(_value);
+  withCodes([_index, code](auto & _codes)
+            {
+              _codes.insert(_index, static_cast<std::decay_t<decltype(_codes[0])>>(code));
+            });
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CDictArray<TData, THash>::set(
+    unsigned int  _index,
+    const TData & _value
+  )
+{
+  assert(_index < size());
+
+  const unsigned int code = encode(_value);
+  withCodes([_index, code](auto & _codes)
+            {
+              _codes[_index] = static_cast<std::decay_t<decltype(_codes[0])>>(code);
+            });
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CDictArray<TData, THash>::erase(
+    unsigned int _index
+  )
+{
+  assert(_index < size());
+
+  withCodes([_index](auto & _codes) { _codes.erase(_index); });
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+template <typename TPredicate>
+unsigned int
+CDictArray<TData, THash>::erase_if(
+    TPredicate _pred
+  )
+{
+  std::vector<unsigned char> marks;
+  if (markCodes(_pred, marks) == 0)
+  {
+    return 0;
+  }
+
+  const unsigned char * const pMarks = marks.data();
+  return withCodes([pMarks](auto & _codes)
+                   {
+                     return _codes.erase_if([pMarks](auto _code) { return pMarks[_code] != 0; });
+                   });
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+bool
+CDictArray<TData, THash>::contains(
+    const TData & _value
+  ) const
+{
+  const unsigned int code = findCode(_value);
+  if (code == NoCode)
+  {
+    return false;
+  }
+
+  return withCodes([code](const auto & _codes)
+                   {
+                     const unsigned int count = _codes.size();
+                     if (count == 0)
+                     {
+                       return false;
+                     }
+
+                     // Просмотр блоками без ветвлений внутри блока
+                     const auto * const pCodes = &_codes[0];
+                     constexpr unsigned int BlockSize = 256;
+                     for (unsigned int blockFrom = 0; blockFrom < count; blockFrom += BlockSize)
+                     {
+                       const unsigned int blockTo = std::min(count, blockFrom + BlockSize);
+
+                       unsigned int found = 0;
+                       for (unsigned int index = blockFrom; index < blockTo; ++index)
+                       {
+                         found |= pCodes[index] == code;
+                       }
+
+                       if (found)
+                       {
+                         return true;
+                       }
+                     }
+                     return false;
+                   });
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+unsigned int
+CDictArray<TData, THash>::count(
+    const TData & _value
+  ) const
+{
+  const unsigned int code = findCode(_value);
+  if (code == NoCode)
+  {
+    return 0;
+  }
+
+  return withCodes([code](const auto & _codes)
+                   {
+                     const unsigned int count = _codes.size();
+                     if (count == 0)
+                     {
+                       return 0u;
+                     }
+
+                     const auto * const pCodes = &_codes[0];
+                     unsigned int result = 0;
+                     for (unsigned int index = 0; index < count; ++index)
+                     {
+                       result += pCodes[index] == code;
+                     }
+                     return result;
+                   });
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+template <typename TPredicate>
+unsigned int
+CDictArray<TData, THash>::count_if(
+    TPredicate _pred
+  ) const
+{
+  std::vector<unsigned char> marks;
+  if (markCodes(_pred, marks) == 0)
+  {
+    return 0;
+  }
+
+  const unsigned char * const pMarks = marks.data();
+  return withCodes([pMarks](const auto & _codes)
+                   {
+                     const unsigned int count = _codes.size();
+                     if (count == 0)
+                     {
+                       return 0u;
+                     }
+
+                     const auto * const pCodes = &_codes[0];
+                     unsigned int result = 0;
+                     for (unsigned int index = 0; index < count; ++index)
+                     {
+                       result += pMarks[pCodes[index]];
+                     }
+                     return result;
+                   });
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CDictArray<TData, THash>::compact_dictionary()
+{
+  // Новые коды используемых значений в порядке словаря
+  const unsigned int        dictionarySize = m_dictionary.size();
+  std::vector<unsigned int> newCodes(dictionarySize, NoCode);
+
+  withCodes([&newCodes](const auto & _codes)
+            {
+              for (auto code : _codes)
+              {
+                newCodes[code] = 0;
+              }
+            });
+
+  CArray<TData> dictionary;
+  for (unsigned int code = 0; code < dictionarySize; ++code)
+  {
+    if (newCodes[code] != NoCode)
+    {
+      newCodes[code] = dictionary.size();
+      dictionary.push_back(std::move(m_dictionary[code]));
+    }
+  }
+  m_dictionary = std::move(dictionary);
+  rebuildIndex(m_dictionary.size());
+
+  withCodes([&newCodes](auto & _codes)
+            {
+              for (auto & code : _codes)
+              {
+                code = static_cast<std::decay_t<decltype(code)>>(newCodes[code]);
+              }
+            });
+
+  setCodeWidth(widthFor(m_dictionary.size()));
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CDictArray<TData, THash>::clear()
+{
+  m_dictionary.clear();
+  m_index.clear();
+  m_indexBits = 0;
+  m_codes8.clear();
+  m_codes16.clear();
+  m_codes32.clear();
+  m_codeWidth = 1;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+unsigned int
+CDictArray<TData, THash>::size() const
+{
+  return withCodes([](const auto & _codes) { return _codes.size(); });
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+bool
+CDictArray<TData, THash>::empty() const
+{
+  return size() == 0;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+unsigned int
+CDictArray<TData, THash>::dictionary_size() const
+{
+  return m_dictionary.size();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+unsigned int
+CDictArray<TData, THash>::code_width() const
+{
+  return m_codeWidth;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+const TData &
+CDictArray<TData, THash>::operator[](
+    unsigned int _index
+  ) const
+{
+  return m_dictionary[codeAt(_index)];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+typename CDictArray<TData, THash>::const_iterator
+CDictArray<TData, THash>::begin() const
+{
+  return cbegin();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+typename CDictArray<TData, THash>::const_iterator
+CDictArray<TData, THash>::cbegin() const
+{
+  return const_iterator(this, 0);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+typename CDictArray<TData, THash>::const_iterator
+CDictArray<TData, THash>::end() const
+{
+  return cend();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+typename CDictArray<TData, THash>::const_iterator
+CDictArray<TData, THash>::cend() const
+{
+  return const_iterator(this, size());
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+unsigned int
+CDictArray<TData, THash>::encode(
+    const TData & _value
+  )
+{
+  unsigned int slot = m_index.empty() ? 0 : findSlot(_value);
+  if (!m_index.empty() && m_index[slot] != NoCode)
+  {
+    return m_index[slot];
+  }
+
+  // Заполнение таблицы не превышает половины
+  const unsigned int code = m_dictionary.size();
+  if (2 * (code + 1) > m_index.size())
+  {
+    rebuildIndex(code + 1);
+    slot = findSlot(_value);
+  }
+
+  m_dictionary.push_back(_value);
+  m_index[slot] = code;
+
+  const unsigned int width = widthFor(m_dictionary.size());
+  if (width > m_codeWidth)
+  {
+    setCodeWidth(width);
+  }
+
+  return code;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+unsigned int
+CDictArray<TData, THash>::findCode(
+    const TData & _value
+  ) const
+{
+  return m_index.empty() ? NoCode : m_index[findSlot(_value)];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+unsigned int
+CDictArray<TData, THash>::findSlot(
+    const TData & _value
+  ) const
+{
+  // Старшие биты произведения на 2^64 / phi равномерны и для хешей
+  // с закономерностями в младших битах (std::hash целых чисел)
+  const uint64_t     hash = static_cast<uint64_t>(THash()(_value)) * 0x9E3779B97F4A7C15ull;
+  const unsigned int mask = m_index.size() - 1;
+
+  unsigned int slot = static_cast<unsigned int>(hash >> (64 - m_indexBits));
+  for (;;)
+  {
+    const unsigned int code = m_index[slot];
+    if (code == NoCode || m_dictionary[code] == _value)
+    {
+      return slot;
+    }
+    slot = (slot + 1) & mask;
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CDictArray<TData, THash>::rebuildIndex(
+    unsigned int _dictionarySize
+  )
+{
+  // Не менее 16 ячеек и не менее двух на значение
+  m_indexBits = std::max(4u, highestBitIndex(std::max(1u, 2 * _dictionarySize - 1)) + 1);
+
+  const unsigned int slotCount = 1u << m_indexBits;
+  CArray<uint32_t>   index;
+  index.reserve(slotCount);
+  for (unsigned int slot = 0; slot < slotCount; ++slot)
+  {
+    index.push_back(NoCode);
+  }
+  m_index = std::move(index);
+
+  const unsigned int dictionarySize = m_dictionary.size();
+  for (unsigned int code = 0; code < dictionarySize; ++code)
+  {
+    m_index[findSlot(m_dictionary[code])] = code;
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+unsigned int
+CDictArray<TData, THash>::codeAt(
+    unsigned int _index
+  ) const
+{
+  switch (m_codeWidth)
+  {
+    case 1:  return m_codes8[_index];
+    case 2:  return m_codes16[_index];
+    default: return m_codes32[_index];
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CDictArray<TData, THash>::setCodeWidth(
+    unsigned int _width
+  )
+{
+  if (_width == m_codeWidth)
+  {
+    return;
+  }
+
+  // Коды переносятся в массив новой ширины, старый освобождается
+  const unsigned int count = size();
+  auto transfer = [this, count](auto & _target)
+                  {
+                    using TCode = std::decay_t<decltype(_target[0])>;
+
+                    _target.reserve(count);
+                    for (unsigned int index = 0; index < count; ++index)
+                    {
+                      _target.push_back(static_cast<TCode>(codeAt(index)));
+                    }
+                  };
+
+  switch (_width)
+  {
+    case 1:  transfer(m_codes8);  break;
+    case 2:  transfer(m_codes16); break;
+    default: transfer(m_codes32); break;
+  }
+
+  withCodes([](auto & _codes) { _codes = std::decay_t<decltype(_codes)>(); });
+  m_codeWidth = _width;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+unsigned int
+CDictArray<TData, THash>::widthFor(
+    unsigned int _dictionarySize
+  )
+{
+  // Код не превышает размер словаря минус один
+  return _dictionarySize <= 0x100u ? 1 : _dictionarySize <= 0x10000u ? 2 : 4;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+template <typename TFunc>
+decltype(auto)
+CDictArray<TData, THash>::withCodes(
+    TFunc && _func
+  )
+{
+  switch (m_codeWidth)
+  {
+    case 1:  return _func(m_codes8);
+    case 2:  return _func(m_codes16);
+    default: return _func(m_codes32);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+template <typename TFunc>
+decltype(auto)
+CDictArray<TData, THash>::withCodes(
+    TFunc && _func
+  ) const
+{
+  switch (m_codeWidth)
+  {
+    case 1:  return _func(m_codes8);
+    case 2:  return _func(m_codes16);
+    default: return _func(m_codes32);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+template <typename TPredicate>
+unsigned int
+CDictArray<TData, THash>::markCodes(
+    TPredicate &                 _pred,
+    std::vector<unsigned char> & _marks
+  ) const
+{
+  const unsigned int dictionarySize = m_dictionary.size();
+  _marks.assign(dictionarySize, 0);
+
+  unsigned int marked = 0;
+  for (unsigned int code = 0; code < dictionarySize; ++code)
+  {
+    if (_pred(m_dictionary[code]))
+    {
+      _marks[code] = 1;
+      ++marked;
+    }
+  }
+
+  return marked;
+}
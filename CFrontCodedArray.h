@@ -0,0 +1,556 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <iterator>
+#include <cassert>
+#include <cstring>
+
+#include "CArray.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// class CFrontCodedArray - упорядоченный массив строк со сжатием общих
+// префиксов (front coding), только для чтения.
+//
+// Строки делятся на группы по _bucketSize. Первая строка группы хранится
+// полностью, остальные - длиной общего с предыдущей строкой префикса
+// и оставшимся суффиксом. Длины записываются переменным числом байтов
+// (по 7 бит в байте). Для каждой группы хранится смещение ее начала,
+// поэтому поиск идет двоичным поиском по первым строкам групп, которые
+// сравниваются без распаковки, и последовательной распаковкой одной
+// группы.
+class CFrontCodedArray
+{
+public: // Interface
+
+  class const_iterator;
+  using iterator = const_iterator;
+
+  // Признак отсутствия строки в find
+  static constexpr unsigned int npos = ~0u;
+
+  // Количество строк в группе по умолчанию
+  static constexpr unsigned int DefaultBucketSize = 16;
+
+  // Конструктор по умолчанию
+  CFrontCodedArray() = default;
+
+  // Построить массив из упорядоченного по возрастанию контейнера строк
+  // (CArray<std::string>, CStringArray и т.п.)
+  template <typename TStrings>
+  explicit CFrontCodedArray(
+      const TStrings & _strings,
+      unsigned int     _bucketSize = DefaultBucketSize
+    );
+
+  // Получить размер массива
+  unsigned int size() const;
+
+  // Определить что массив пустой
+  bool empty() const;
+
+  // Получить количество строк в группе
+  unsigned int bucket_size() const;
+
+  // Получить объем памяти, занятой массивом, в байтах
+  size_t memoryUsage() const;
+
+  // Получить строку по заданному индексу
+  std::string operator[](
+      unsigned int _index
+    ) const;
+
+  // Получить индекс первой строки, не меньшей _value
+  unsigned int lower_bound(
+      std::string_view _value
+    ) const;
+
+  // Получить индекс строки, равной _value (npos, если нет)
+  unsigned int find(
+      std::string_view _value
+    ) const;
+
+  // Получить диапазон индексов [first, second) строк, начинающихся
+  // с _prefix
+  std::pair<unsigned int, unsigned int> prefix_range(
+      std::string_view _prefix
+    ) const;
+
+  // Вызвать _func(std::string_view) для строк [_indexFrom, _indexTo)
+  // по порядку. Строка действительна только во время вызова.
+  template <typename TFunc>
+  void for_each(
+      TFunc        _func,
+      unsigned int _indexFrom = 0,
+      unsigned int _indexTo   = npos
+    ) const;
+
+  const_iterator begin()  const;
+  const_iterator cbegin() const;
+  const_iterator end()    const;
+  const_iterator cend()   const;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Итератор по строкам массива (каждое разыменование распаковывает
+  // строку, для последовательного обхода быстрее for_each)
+  class const_iterator
+  {
+  public:
+
+    // iterator traits
+    using difference_type   = int;
+    using value_type        = std::string;
+    using pointer           = void;
+    using reference         = std::string;
+    using iterator_category = std::random_access_iterator_tag;
+
+    const_iterator() = default;
+
+    const_iterator(
+        const CFrontCodedArray * _array,
+        unsigned int             _index
+      )
+      : m_array(_array),
+        m_index(_index)
+    {
+    }
+
+    std::string operator*() const             { return (*m_array)[m_index]; }
+    std::string operator[](int _offset) const { return (*m_array)[m_index + _offset]; }
+
+    const_iterator & operator++()    { ++m_index; return *this; }
+    const_iterator & operator--()    { --m_index; return *this; }
+    const_iterator   operator++(int) { const_iterator tmp(*this); ++m_index; return tmp; }
+    const_iterator   operator--(int) { const_iterator tmp(*this); --m_index; return tmp; }
+
+    const_iterator & operator+=(int _offset)      { m_index += _offset; return *this; }
+    const_iterator & operator-=(int _offset)      { m_index -= _offset; return *this; }
+    const_iterator   operator+(int _offset) const { return const_iterator(m_array, m_index + _offset); }
+    const_iterator   operator-(int _offset) const { return const_iterator(m_array, m_index - _offset); }
+
+    friend const_iterator operator+(int _offset, const const_iterator & _it) { return _it + _offset; }
+
+    int operator-(const const_iterator & _it) const { return static_cast<int>(m_index - _it.m_index); }
+
+    bool operator==(const const_iterator & _it) const { return m_index == _it.m_index; }
+    bool operator!=(const const_iterator & _it) const { return m_index != _it.m_index; }
+    bool operator< (const const_iterator & _it) const { return m_index <  _it.m_index; }
+    bool operator> (const const_iterator & _it) const { return m_index >  _it.m_index; }
+    bool operator<=(const const_iterator & _it) const { return m_index <= _it.m_index; }
+    bool operator>=(const const_iterator & _it) const { return m_index >= _it.m_index; }
+
+  private:
+
+    const CFrontCodedArray * m_array = nullptr;
+    unsigned int             m_index = 0;
+  };
+
+protected:  // Методы
+
+  // Получить количество байтов записи _value
+  static unsigned int varintSize(
+      unsigned int _value
+    );
+
+  // Записать _value по 7 бит в байте, сдвинув _pOutput
+  static void writeVarint(
+      char *&      _pOutput,
+      unsigned int _value
+    );
+
+  // Прочитать значение, записанное writeVarint, сдвинув _pInput
+  static unsigned int readVarint(
+      const char *& _pInput
+    );
+
+  // Получить первую строку группы без распаковки
+  std::string_view bucketHead(
+      unsigned int _bucketIndex
+    ) const;
+
+  // Получить количество строк в группе
+  unsigned int bucketCount(
+      unsigned int _bucketIndex
+    ) const;
+
+  // Распаковать строки группы по порядку, вызывая _func(position, value).
+  // Распаковка прекращается, когда _func возвращает false.
+  template <typename TFunc>
+  void decodeBucket(
+      unsigned int _bucketIndex,
+      std::string & _buffer,
+      TFunc         _func
+    ) const;
+
+protected: // Attributes
+
+  std::string          m_bytes;                          //< Закодированные группы
+  CArray<unsigned int> m_bucketOffsets;                  //< Смещения начал групп в m_bytes
+  unsigned int         m_size       = 0;
+  unsigned int         m_bucketSize = DefaultBucketSize;
+};
+
+//----------------------------------------------------------------------------//
+template <typename TStrings>
+CFrontCodedArray::CFrontCodedArray(
+    const TStrings & _strings,
+    unsigned int     _bucketSize
+  )
+  : m_size      (static_cast<unsigned int>(_strings.size())),
+    m_bucketSize(std::max(1u, _bucketSize))
+{
+  // Первый проход считает размер, второй записывает группы
+  size_t bytes = 0;
+  for (unsigned int index = 0; index < m_size; ++index)
+  {
+    const std::string_view value(_strings[index]);
+    if (index % m_bucketSize == 0)
+    {
+      bytes += varintSize(static_cast<unsigned int>(value.size())) + value.size();
+      continue;
+    }
+
+    const std::string_view prev(_strings[index - 1]);
+    assert(prev <= value);
+
+    const size_t common = std::mismatch(prev.begin(), prev.begin() + std::min(prev.size(), value.size()), value.begin()).first
+                        - prev.begin();
+    const size_t suffix = value.size() - common;
+    bytes += varintSize(static_cast<unsigned int>(common)) + varintSize(static_cast<unsigned int>(suffix)) + suffix;
+  }
+
+  m_bytes.resize(bytes);
+  m_bucketOffsets.reserve((m_size + m_bucketSize - 1) / m_bucketSize);
+
+  char * pOutput = &m_bytes[0];
+  for (unsigned int index = 0; index < m_size; ++index)
+  {
+    const std::string_view value(_strings[index]);
+    size_t                 common = 0;
+
+    if (index % m_bucketSize == 0)
+    {
+      m_bucketOffsets.push_back(static_cast<unsigned int>(pOutput - &m_bytes[0]));
+      writeVarint(pOutput, static_cast<unsigned int>(value.size()));
+    }
+    else
+    {
+      const std::string_view prev(_strings[index - 1]);
+      common = std::mismatch(prev.begin(), prev.begin() + std::min(prev.size(), value.size()), value.begin()).first
+             - prev.begin();
+
+      writeVarint(pOutput, static_cast<unsigned int>(common));
+      writeVarint(pOutput, static_cast<unsigned int>(value.size() - common));
+    }
+
+    if (value.size() > common)
+    {
+      std::memcpy(pOutput, value.data() + common, value.size() - common);
+      pOutput += value.size() - common;
+    }
+  }
+
+  assert(pOutput == m_bytes.data() + m_bytes.size());
+}
+
+//----------------------------------------------------------------------------//
+inline unsigned int
+CFrontCodedArray::size() const
+{
+  return m_size;
+}
+
+//----------------------------------------------------------------------------//
+inline bool
+CFrontCodedArray::empty() const
+{
+  return m_size == 0;
+}
+
+//----------------------------------------------------------------------------//
+inline unsigned int
+CFrontCodedArray::bucket_size() const
+{
+  return m_bucketSize;
+}
+
+//----------------------------------------------------------------------------//
+inline size_t
+CFrontCodedArray::memoryUsage() const
+{
+  return sizeof(*this) + m_bytes.capacity() + size_t(m_bucketOffsets.capacity()) * sizeof(unsigned int);
+}
+
+//----------------------------------------------------------------------------//
+inline std::string
+CFrontCodedArray::operator[](
+    unsigned int _index
+  ) const
+{
+  assert(_index < m_size);
+
+  std::string value;
+  decodeBucket(_index / m_bucketSize, value,
+               [_index, this](unsigned int _position, const std::string &)
+               {
+                 return _position < _index % m_bucketSize;
+               });
+
+  return value;
+}
+
+//----------------------------------------------------------------------------//
+inline unsigned int
+CFrontCodedArray::lower_bound(
+    std::string_view _value
+  ) const
+{
+  // Первая группа, начинающаяся со строки не меньше _value: искомая строка
+  // в предыдущей группе или первая строка этой
+  const unsigned int buckets = m_bucketOffsets.size();
+
+  unsigned int low  = 0;
+  unsigned int high = buckets;
+  while (low < high)
+  {
+    const unsigned int middle = low + (high - low) / 2;
+    if (bucketHead(middle) < _value)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+
+  if (low == 0)
+  {
+    return 0;
+  }
+
+  const unsigned int bucketIndex = low - 1;
+  unsigned int       result      = low * m_bucketSize;
+  std::string        buffer;
+
+  decodeBucket(bucketIndex, buffer,
+               [&](unsigned int _position, const std::string & _current)
+               {
+                 if (std::string_view(_current) >= _value)
+                 {
+                   result = bucketIndex * m_bucketSize + _position;
+                   return false;
+                 }
+                 return true;
+               });
+
+  return std::min(result, m_size);
+}
+
+//----------------------------------------------------------------------------//
+inline unsigned int
+CFrontCodedArray::find(
+    std::string_view _value
+  ) const
+{
+  const unsigned int index = lower_bound(_value);
+  return index < m_size && (*this)[index] == _value ? index : npos;
+}
+
+//----------------------------------------------------------------------------//
+inline std::pair<unsigned int, unsigned int>
+CFrontCodedArray::prefix_range(
+    std::string_view _prefix
+  ) const
+{
+  const unsigned int from = lower_bound(_prefix);
+
+  // Граница - наименьшая строка, большая всех строк с префиксом:
+  // префикс без завершающих байтов 0xFF с увеличенным последним байтом
+  std::string bound(_prefix);
+  while (!bound.empty() && static_cast<unsigned char>(bound.back()) == 0xFF)
+  {
+    bound.pop_back();
+  }
+
+  if (bound.empty())
+  {
+    return std::make_pair(from, m_size);
+  }
+
+  bound.back() = static_cast<char>(static_cast<unsigned char>(bound.back()) + 1);
+  return std::make_pair(from, std::max(from, lower_bound(bound)));
+}
+
+//----------------------------------------------------------------------------//
+template <typename TFunc>
+void
+CFrontCodedArray::for_each(
+    TFunc        _func,
+    unsigned int _indexFrom,
+    unsigned int _indexTo
+  ) const
+{
+  _indexTo = std::min(_indexTo, m_size);
+  if (_indexFrom >= _indexTo)
+  {
+    return;
+  }
+
+  std::string buffer;
+  for (unsigned int bucketIndex = _indexFrom / m_bucketSize; bucketIndex * m_bucketSize < _indexTo; ++bucketIndex)
+  {
+    const unsigned int bucketFrom = bucketIndex * m_bucketSize;
+    decodeBucket(bucketIndex, buffer,
+                 [&](unsigned int _position, const std::string & _current)
+                 {
+                   const unsigned int index = bucketFrom + _position;
+                   if (index >= _indexTo)
+                   {
+                     return false;
+                   }
+                   if (index >= _indexFrom)
+                   {
+                     _func(std::string_view(_current));
+                   }
+                   return true;
+                 });
+  }
+}
+
+//----------------------------------------------------------------------------//
+inline CFrontCodedArray::const_iterator
+CFrontCodedArray::begin() const
+{
+  return cbegin();
+}
+
+//----------------------------------------------------------------------------//
+inline CFrontCodedArray::const_iterator
+CFrontCodedArray::cbegin() const
+{
+  return const_iterator(this, 0);
+}
+
+//----------------------------------------------------------------------------//
+inline CFrontCodedArray::const_iterator
+CFrontCodedArray::end() const
+{
+  return cend();
+}
+
+//----------------------------------------------------------------------------//
+inline CFrontCodedArray::const_iterator
+CFrontCodedArray::cend() const
+{
+  return const_iterator(this, m_size);
+}
+
+//----------------------------------------------------------------------------//
+inline unsigned int
+CFrontCodedArray::varintSize(
+    unsigned int _value
+  )
+{
+  unsigned int bytes = 1;
+  for ( ; _value >= 0x80; _value >>= 7)
+  {
+    ++bytes;
+  }
+
+  return bytes;
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CFrontCodedArray::writeVarint(
+    char *&      _pOutput,
+    unsigned int _value
+  )
+{
+  for ( ; _value >= 0x80; _value >>= 7)
+  {
+    *_pOutput++ = static_cast<char>((_value & 0x7F) | 0x80);
+  }
+  *_pOutput++ = static_cast<char>(_value);
+}
+
+//----------------------------------------------------------------------------//
+inline unsigned int
+CFrontCodedArray::readVarint(
+    const char *& _pInput
+  )
+{
+  unsigned int value = 0;
+  for (unsigned int shift = 0; ; shift += 7)
+  {
+    const unsigned char byte = static_cast<unsigned char>(*_pInput++);
+    value |= static_cast<unsigned int>(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+    {
+      break;
+    }
+  }
+
+  return value;
+}
+
+//----------------------------------------------------------------------------//
+inline std::string_view
+CFrontCodedArray::bucketHead(
+    unsigned int _bucketIndex
+  ) const
+{
+  const char *       pInput = m_bytes.data() + m_bucketOffsets[_bucketIndex];
+  const unsigned int length = readVarint(pInput);
+
+  return std::string_view(pInput, length);
+}
+
+//----------------------------------------------------------------------------//
+inline unsigned int
+CFrontCodedArray::bucketCount(
+    unsigned int _bucketIndex
+  ) const
+{
+  return std::min(m_bucketSize, m_size - _bucketIndex * m_bucketSize);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TFunc>
+void
+CFrontCodedArray::decodeBucket(
+    unsigned int  _bucketIndex,
+    std::string & _buffer,
+    TFunc         _func
+  ) const
+{
+  const char *       pInput = m_bytes.data() + m_bucketOffsets[_bucketIndex];
+  const unsigned int count  = bucketCount(_bucketIndex);
+
+  const unsigned int length = readVarint(pInput);
+  _buffer.assign(pInput, length);
+  pInput += length;
+
+  if (!_func(0u, static_cast<const std::string &>(_buffer)))
+  {
+    return;
+  }
+
+  for (unsigned int position = 1; position < count; ++position)
+  {
+    const unsigned int common = readVarint(pInput);
+    const unsigned int suffix = readVarint(pInput);
+
+    _buffer.resize(common);
+    _buffer.append(pInput, suffix);
+    pInput += suffix;
+
+    if (!_func(position, static_cast<const std::string &>(_buffer)))
+    {
+      return;
+    }
+  }
+}
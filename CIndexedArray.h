@@ -0,0 +1,603 @@
+#pragma once
+
+#include <cstdint>
+#include <cassert>
+#include <functional>
+
+#include "CArray.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// class CIndexedArray - массив с хеш-индексом от значения элемента к его
+// позиции.
+//
+// Индекс - таблица с открытой адресацией, в ячейке которой хранится
+// позиция элемента и старшие биты его хеша; сами значения берутся из
+// массива. Таблица обновляется вместе с массивом: push_back добавляет
+// ячейку, erase удаляет. Сдвиг позиций при вставке и удалении в середине
+// не переписывает таблицу, а записывается в журнал сдвигов; ячейка
+// помнит длину журнала на момент записи и при поиске ее позиция
+// пересчитывается по более поздним сдвигам. Когда журнал заполняется,
+// позиции всех ячеек исправляются за один проход, без перехеширования.
+//
+// Память таблицы выделяется только при ее росте (вдвое), не на каждый
+// элемент. Элементы доступны только для чтения, изменение - через set().
+template <typename TData, typename THash = std::hash<TData>>
+class CIndexedArray
+{
+public: // Interface
+
+  using const_iterator = typename CArray<TData>::const_iterator;
+
+  // Признак отсутствия элемента в index_of
+  static constexpr unsigned int npos = ~0u;
+
+  // Конструктор по умолчанию
+  CIndexedArray() = default;
+
+  // Добавить элемент в конец массива
+  void push_back(
+      const TData & _value
+    );
+
+  // Добавить элемент в массив по заданному индексу
+  void insert(
+      unsigned int  _index,
+      const TData & _value
+    );
+
+  // Удалить элемент массива по заданному индексу
+  void erase(
+      unsigned int _index
+    );
+
+  // Заменить элемент массива по заданному индексу
+  void set(
+      unsigned int  _index,
+      const TData & _value
+    );
+
+  // Очистить массив
+  void clear();
+
+  // Зарезервировать память под заданное количество элементов
+  void reserve(
+      unsigned int _capacity
+    );
+
+  // Получить размер массива
+  unsigned int size() const;
+
+  // Определить что массив пустой
+  bool empty() const;
+
+  // Получить элемент массива по заданному индексу
+  const TData & operator[](
+      unsigned int _index
+    ) const;
+
+  // Получить наименьший индекс элемента, равного _value (npos, если нет)
+  unsigned int index_of(
+      const TData & _value
+    ) const;
+
+  // Получить итератор на первый элемент, равный _value (end(), если нет)
+  const_iterator find(
+      const TData & _value
+    ) const;
+
+  // Определить наличие элемента, равного _value
+  bool contains(
+      const TData & _value
+    ) const;
+
+  // Получить количество элементов, равных _value
+  unsigned int count(
+      const TData & _value
+    ) const;
+
+  const_iterator begin()  const;
+  const_iterator cbegin() const;
+  const_iterator end()    const;
+  const_iterator cend()   const;
+
+protected:  // Методы
+
+  // Длина журнала сдвигов
+  static constexpr unsigned int MaxPendingShifts = 64;
+
+  // Минимальная емкость таблицы
+  static constexpr unsigned int MinSlotCount = 16;
+
+  static constexpr unsigned int EmptySlot   = ~0u;
+  static constexpr unsigned int DeletedSlot = ~0u - 1;
+
+  // Ячейка таблицы
+  struct Slot
+  {
+    unsigned int   m_position; //< Позиция до сдвигов журнала, начиная с m_epoch
+    unsigned short m_tag;      //< Старшие биты хеша
+    unsigned char  m_epoch;    //< Длина журнала на момент записи позиции
+  };
+
+  // Сдвиг позиций: вставка (+1) или удаление (-1) в позиции m_position
+  struct Shift
+  {
+    unsigned int m_position;
+    int          m_delta;
+  };
+
+  // Получить хеш значения
+  static uint64_t hashOf(
+      const TData & _value
+    );
+
+  // Получить текущую позицию ячейки с учетом журнала сдвигов
+  unsigned int positionOf(
+      const Slot & _slot
+    ) const;
+
+  // Вызвать _func(slotIndex, position) для ячеек со значением _value,
+  // пока _func возвращает true
+  template <typename TFunc>
+  void probe(
+      const TData & _value,
+      TFunc         _func
+    ) const;
+
+  // Добавить в таблицу ячейку элемента _position
+  void addSlot(
+      unsigned int _position
+    );
+
+  // Удалить из таблицы ячейку элемента _position
+  void removeSlot(
+      unsigned int _position
+    );
+
+  // Записать сдвиг позиций, исправив таблицу при заполнении журнала
+  void recordShift(
+      unsigned int _position,
+      int          _delta
+    );
+
+  // Исправить позиции всех ячеек по журналу и очистить журнал
+  void applyShifts();
+
+  // Перестроить таблицу на _slotCount ячеек
+  void rebuild(
+      unsigned int _slotCount
+    );
+
+protected: // Attributes
+
+  CArray<TData> m_items;                 //< Элементы
+  CArray<Slot>  m_slots;                 //< Таблица (размер - степень двойки)
+  Shift         m_shifts[MaxPendingShifts];
+  unsigned int  m_shiftCount = 0;        //< Длина журнала сдвигов
+  unsigned int  m_usedSlots  = 0;        //< Занятые и удаленные ячейки
+};
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CIndexedArray<TData, THash>::push_back(
+    const TData & _value
+  )
+{
+  m_items.push_back(_value);
+  addSlot(m_items.size() - 1);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CIndexedArray<TData, THash>::insert(
+    unsigned int  _index,
+    const TData & _value
+  )
+{
+  assert(_index <= size());
+
+  if (_index == size())
+  {
+    push_back(_value);
+    return;
+  }
+
+  recordShift(_index, +1);
+  m_items.insert(_index, _value);
+  addSlot(_index);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CIndexedArray<TData, THash>::erase(
+    unsigned int _index
+  )
+{
+  assert(_index < size());
+
+  removeSlot(_index);
+  if (_index + 1 < size())
+  {
+    recordShift(_index, -1);
+  }
+  m_items.erase(_index);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CIndexedArray<TData, THash>::set(
+    unsigned int  _index,
+    const TData & _value
+  )
+{
+  assert(_index < size());
+
+  removeSlot(_index);
+  m_items[_index] = _value;
+  addSlot(_index);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CIndexedArray<TData, THash>::clear()
+{
+  m_items.clear();
+  m_slots.clear();
+  m_shiftCount = 0;
+  m_usedSlots  = 0;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CIndexedArray<TData, THash>::reserve(
+    unsigned int _capacity
+  )
+{
+  m_items.reserve(_capacity);
+
+  // Заполнение таблицы не превышает половины
+  unsigned int slotCount = MinSlotCount;
+  while (slotCount / 2 < _capacity)
+  {
+    slotCount *= 2;
+  }
+
+  if (slotCount > m_slots.size())
+  {
+    rebuild(slotCount);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+unsigned int
+CIndexedArray<TData, THash>::size() const
+{
+  return m_items.size();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+bool
+CIndexedArray<TData, THash>::empty() const
+{
+  return m_items.empty();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+const TData &
+CIndexedArray<TData, THash>::operator[](
+    unsigned int _index
+  ) const
+{
+  return m_items[_index];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+unsigned int
+CIndexedArray<TData, THash>::index_of(
+    const TData & _value
+  ) const
+{
+  // Цепочка просматривается до конца: равных значений может быть несколько
+  unsigned int result = npos;
+  probe(_value, [&result](unsigned int, unsigned int _position)
+                {
+                  result = std::min(result, _position);
+                  return true;
+                });
+
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+typename CIndexedArray<TData, THash>::const_iterator
+CIndexedArray<TData, THash>::find(
+    const TData & _value
+  ) const
+{
+  const unsigned int index = index_of(_value);
+  return index == npos ? end() : begin() + index;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+bool
+CIndexedArray<TData, THash>::contains(
+    const TData & _value
+  ) const
+{
+  bool found = false;
+  probe(_value, [&found](unsigned int, unsigned int)
+                {
+                  found = true;
+                  return false;
+                });
+
+  return found;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+unsigned int
+CIndexedArray<TData, THash>::count(
+    const TData & _value
+  ) const
+{
+  unsigned int result = 0;
+  probe(_value, [&result](unsigned int, unsigned int)
+                {
+                  ++result;
+                  return true;
+                });
+
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+typename CIndexedArray<TData, THash>::const_iterator
+CIndexedArray<TData, THash>::begin() const
+{
+  return m_items.begin();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+typename CIndexedArray<TData, THash>::const_iterator
+CIndexedArray<TData, THash>::cbegin() const
+{
+  return m_items.cbegin();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+typename CIndexedArray<TData, THash>::const_iterator
+CIndexedArray<TData, THash>::end() const
+{
+  return m_items.end();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+typename CIndexedArray<TData, THash>::const_iterator
+CIndexedArray<TData, THash>::cend() const
+{
+  return m_items.cend();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+uint64_t
+CIndexedArray<TData, THash>::hashOf(
+    const TData & _value
+  )
+{
+  // Перемешивание: std::hash для целых - тождественная функция
+  return static_cast<uint64_t>(THash()(_value)) * 0x9E3779B97F4A7C15ull;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+unsigned int
+CIndexedArray<TData, THash>::positionOf(
+    const Slot & _slot
+  ) const
+{
+  unsigned int position = _slot.m_position;
+  for (unsigned int shiftIndex = _slot.m_epoch; shiftIndex < m_shiftCount; ++shiftIndex)
+  {
+    const Shift & shift = m_shifts[shiftIndex];
+    if (shift.m_delta > 0 ? position >= shift.m_position : position > shift.m_position)
+    {
+      position += shift.m_delta;
+    }
+  }
+
+  return position;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+template <typename TFunc>
+void
+CIndexedArray<TData, THash>::probe(
+    const TData & _value,
+    TFunc         _func
+  ) const
+{
+  const unsigned int slotCount = m_slots.size();
+  if (slotCount == 0)
+  {
+    return;
+  }
+
+  const uint64_t       hash  = hashOf(_value);
+  const unsigned short tag   = static_cast<unsigned short>(hash >> 48);
+  const unsigned int   mask  = slotCount - 1;
+  const Slot * const   slots = &m_slots[0];
+
+  for (unsigned int slotIndex = static_cast<unsigned int>(hash >> 32) & mask; ; slotIndex = (slotIndex + 1) & mask)
+  {
+    const Slot & slot = slots[slotIndex];
+    if (slot.m_position == EmptySlot)
+    {
+      return;
+    }
+
+    if (slot.m_position != DeletedSlot && slot.m_tag == tag)
+    {
+      const unsigned int position = positionOf(slot);
+      if (m_items[position] == _value && !_func(slotIndex, position))
+      {
+        return;
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CIndexedArray<TData, THash>::addSlot(
+    unsigned int _position
+  )
+{
+  if ((m_usedSlots + 1) * 2 > m_slots.size())
+  {
+    // Удаленные ячейки не учитываются: при их обилии таблица не растет,
+    // а перестраивается на прежнем размере
+    unsigned int slotCount = std::max(MinSlotCount, m_slots.size());
+    while (slotCount / 2 < size())
+    {
+      slotCount *= 2;
+    }
+    rebuild(slotCount);
+    return;
+  }
+
+  const uint64_t     hash  = hashOf(m_items[_position]);
+  const unsigned int mask  = m_slots.size() - 1;
+  Slot * const       slots = &m_slots[0];
+
+  unsigned int slotIndex = static_cast<unsigned int>(hash >> 32) & mask;
+  while (slots[slotIndex].m_position < DeletedSlot)
+  {
+    slotIndex = (slotIndex + 1) & mask;
+  }
+
+  if (slots[slotIndex].m_position == EmptySlot)
+  {
+    ++m_usedSlots;
+  }
+
+  slots[slotIndex].m_position = _position;
+  slots[slotIndex].m_tag      = static_cast<unsigned short>(hash >> 48);
+  slots[slotIndex].m_epoch    = static_cast<unsigned char>(m_shiftCount);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CIndexedArray<TData, THash>::removeSlot(
+    unsigned int _position
+  )
+{
+  unsigned int found = EmptySlot;
+  probe(m_items[_position], [&found, _position](unsigned int _slotIndex, unsigned int _slotPosition)
+                            {
+                              if (_slotPosition == _position)
+                              {
+                                found = _slotIndex;
+                                return false;
+                              }
+                              return true;
+                            });
+
+  assert(found != EmptySlot);
+  m_slots[found].m_position = DeletedSlot;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CIndexedArray<TData, THash>::recordShift(
+    unsigned int _position,
+    int          _delta
+  )
+{
+  if (m_shiftCount == MaxPendingShifts)
+  {
+    applyShifts();
+  }
+
+  m_shifts[m_shiftCount].m_position = _position;
+  m_shifts[m_shiftCount].m_delta    = _delta;
+  ++m_shiftCount;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CIndexedArray<TData, THash>::applyShifts()
+{
+  const unsigned int slotCount = m_slots.size();
+  for (unsigned int slotIndex = 0; slotIndex < slotCount; ++slotIndex)
+  {
+    Slot & slot = m_slots[slotIndex];
+    if (slot.m_position < DeletedSlot)
+    {
+      slot.m_position = positionOf(slot);
+      slot.m_epoch    = 0;
+    }
+  }
+
+  m_shiftCount = 0;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename THash>
+void
+CIndexedArray<TData, THash>::rebuild(
+    unsigned int _slotCount
+  )
+{
+  assert((_slotCount & (_slotCount - 1)) == 0);
+
+  // Позиции заполняются заново по массиву, журнал больше не нужен
+  if (m_slots.size() != _slotCount)
+  {
+    CArray<Slot> slots;
+    slots.reserve(_slotCount);
+    for (unsigned int slotIndex = 0; slotIndex < _slotCount; ++slotIndex)
+    {
+      slots.push_back(Slot{EmptySlot, 0, 0});
+    }
+    m_slots = std::move(slots);
+  }
+  else
+  {
+    for (unsigned int slotIndex = 0; slotIndex < _slotCount; ++slotIndex)
+    {
+      m_slots[slotIndex].m_position = EmptySlot;
+    }
+  }
+
+  m_shiftCount = 0;
+  m_usedSlots  = 0;
+
+  const unsigned int count = size();
+  for (unsigned int position = 0; position < count; ++position)
+  {
+    addSlot(position);
+  }
+}
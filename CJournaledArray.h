@@ -0,0 +1,633 @@
+#pragma once
+
+#include <utility>
+#include <cassert>
+
+#include "CArray.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// class CJournaledArray - массив с журналом изменений для передачи
+// копиям только изменившейся части.
+//
+// Каждое изменение записывается в журнал операцией: добавление в конец,
+// вставка, удаление диапазона или замена элементов; значения операций
+// хранятся подряд в отдельном массиве. Изменение, продолжающее последнюю
+// операцию, объединяется с ней: добавления подряд дают одну операцию,
+// удаление только что вставленных элементов сокращает вставку, замена
+// вставленного элемента меняет записанное значение.
+//
+// take_delta() забирает журнал с момента предыдущего вызова, apply_delta()
+// воспроизводит его на копии. Размер журнала ограничен: при переполнении
+// запись прекращается, и следующий take_delta() вернет снимок всего
+// массива; снимок возвращается и тогда, когда он не больше журнала.
+// Элементы доступны только для чтения, изменение - через set().
+template <typename TData>
+class CJournaledArray
+{
+public: // Interface
+
+  using const_iterator = typename CArray<TData>::const_iterator;
+
+  // Вид операции журнала
+  enum class op_kind : unsigned char
+  {
+    append,  //< Добавление m_count значений в конец (m_position - размер до)
+    insert,  //< Вставка m_count значений в позицию m_position
+    erase,   //< Удаление m_count элементов с позиции m_position
+    set      //< Замена m_count элементов с позиции m_position
+  };
+
+  // Операция журнала. Операции с значениями берут их из values()
+  // по порядку.
+  struct operation
+  {
+    op_kind      m_kind;
+    unsigned int m_position;
+    unsigned int m_count;
+  };
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Изменения массива с момента предыдущего take_delta() или снимок
+  class delta
+  {
+    friend CJournaledArray;
+
+  public:
+
+    delta() = default;
+
+    // Собрать изменения из переданных частей (например, после передачи)
+    delta(
+        bool                  _snapshot,
+        CArray<operation> &&  _operations,
+        CArray<TData> &&      _values
+      )
+      : m_snapshot(_snapshot),
+        m_operations(std::move(_operations)),
+        m_values(std::move(_values))
+    {
+    }
+
+    // Снимок: values() - все элементы массива, операций нет
+    bool is_snapshot() const { return m_snapshot; }
+
+    // Определить что изменений нет
+    bool empty() const { return !m_snapshot && m_operations.empty(); }
+
+    CArrayView<operation> operations() const { return m_operations; }
+    CArrayView<TData>     values()     const { return m_values; }
+
+  private:
+
+    bool              m_snapshot = false;
+    CArray<operation> m_operations;
+    CArray<TData>     m_values;
+  };
+
+  // Конструктор. _maxJournal - предельное количество операций и значений
+  // в журнале.
+  explicit CJournaledArray(
+      unsigned int _maxJournal = 4096
+    );
+
+  // Добавить элемент в конец массива
+  void push_back(
+      const TData & _value
+    );
+
+  // Добавить элемент в массив по заданному индексу
+  void insert(
+      unsigned int  _index,
+      const TData & _value
+    );
+
+  // Удалить элемент массива по заданному индексу
+  void erase(
+      unsigned int _index
+    );
+
+  // Удалить элементы [_indexFrom, _indexTo)
+  void erase(
+      unsigned int _indexFrom,
+      unsigned int _indexTo
+    );
+
+  // Заменить элемент массива по заданному индексу
+  void set(
+      unsigned int  _index,
+      const TData & _value
+    );
+
+  // Очистить массив
+  void clear();
+
+  // Зарезервировать память под заданное количество элементов
+  void reserve(
+      unsigned int _capacity
+    );
+
+  // Получить размер массива
+  unsigned int size() const;
+
+  // Определить что массив пустой
+  bool empty() const;
+
+  // Получить элемент массива по заданному индексу
+  const TData & operator[](
+      unsigned int _index
+    ) const;
+
+  // Забрать изменения с момента предыдущего вызова (контрольная точка)
+  delta take_delta();
+
+  // Получить снимок всего массива (журнал не меняется)
+  delta snapshot() const;
+
+  // Применить изменения, полученные от take_delta() массива, копией
+  // которого является этот массив. Применение записывается в журнал.
+  void apply_delta(
+      const delta & _delta
+    );
+
+  // Получить количество операций и значений в журнале
+  unsigned int journal_size() const;
+
+  const_iterator begin()  const;
+  const_iterator cbegin() const;
+  const_iterator end()    const;
+  const_iterator cend()   const;
+
+protected:  // Методы
+
+  // Вставить _count значений в позицию _index
+  void insertRun(
+      unsigned int  _index,
+      const TData * _pValues,
+      unsigned int  _count
+    );
+
+  // Заменить _count элементов с позиции _index
+  void setRun(
+      unsigned int  _index,
+      const TData * _pValues,
+      unsigned int  _count
+    );
+
+  // Записать вставку значения в позицию _index (до изменения массива)
+  void recordInsert(
+      unsigned int  _index,
+      const TData & _value
+    );
+
+  // Записать удаление [_indexFrom, _indexTo) (до изменения массива)
+  void recordErase(
+      unsigned int _indexFrom,
+      unsigned int _indexTo
+    );
+
+  // Записать замену элемента _index
+  void recordSet(
+      unsigned int  _index,
+      const TData & _value
+    );
+
+  // Получить последнюю операцию журнала (nullptr, если журнал пуст)
+  operation * lastOperation();
+
+  // Прекратить запись при переполнении журнала
+  void checkOverflow();
+
+protected: // Attributes
+
+  CArray<TData>     m_items;                //< Элементы массива
+  CArray<operation> m_operations;           //< Операции журнала
+  CArray<TData>     m_values;               //< Значения операций подряд
+  unsigned int      m_maxJournal;           //< Предельный размер журнала
+  bool              m_overflow = false;     //< Журнал переполнен, нужен снимок
+};
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+CJournaledArray<TData>::CJournaledArray(
+    unsigned int _maxJournal
+  )
+  : m_maxJournal(_maxJournal)
+{
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CJournaledArray<TData>::push_back(
+    const TData & _value
+  )
+{
+  recordInsert(m_items.size(), _value);
+  m_items.push_back(_value);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CJournaledArray<TData>::insert(
+    unsigned int  _index,
+    const TData & _value
+  )
+{
+  assert(_index <= m_items.size());
+
+  recordInsert(_index, _value);
+  m_items.insert(_index, _value);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CJournaledArray<TData>::erase(
+    unsigned int _index
+  )
+{
+  erase(_index, _index + 1);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CJournaledArray<TData>::erase(
+    unsigned int _indexFrom,
+    unsigned int _indexTo
+  )
+{
+  assert(_indexFrom <= _indexTo && _indexTo <= m_items.size());
+
+  if (_indexFrom == _indexTo)
+  {
+    return;
+  }
+
+  recordErase(_indexFrom, _indexTo);
+  m_items.erase(m_items.begin() + _indexFrom, m_items.begin() + _indexTo);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CJournaledArray<TData>::set(
+    unsigned int  _index,
+    const TData & _value
+  )
+{
+  assert(_index < m_items.size());
+
+  recordSet(_index, _value);
+  m_items[_index] = _value;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CJournaledArray<TData>::clear()
+{
+  erase(0, m_items.size());
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CJournaledArray<TData>::reserve(
+    unsigned int _capacity
+  )
+{
+  m_items.reserve(_capacity);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+unsigned int
+CJournaledArray<TData>::size() const
+{
+  return m_items.size();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+bool
+CJournaledArray<TData>::empty() const
+{
+  return m_items.empty();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+const TData &
+CJournaledArray<TData>::operator[](
+    unsigned int _index
+  ) const
+{
+  return m_items[_index];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CJournaledArray<TData>::delta
+CJournaledArray<TData>::take_delta()
+{
+  // Снимок не больше журнала - передается снимок
+  if (m_overflow || (!m_operations.empty() && m_values.size() >= m_items.size()))
+  {
+    m_overflow = false;
+    m_operations.clear();
+    m_values.clear();
+    return snapshot();
+  }
+
+  delta result;
+  std::swap(result.m_operations, m_operations);
+  std::swap(result.m_values,     m_values);
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CJournaledArray<TData>::delta
+CJournaledArray<TData>::snapshot() const
+{
+  delta result;
+  result.m_snapshot = true;
+  result.m_values   = m_items;
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CJournaledArray<TData>::apply_delta(
+    const delta & _delta
+  )
+{
+  const CArrayView<TData> values = _delta.values();
+
+  if (_delta.is_snapshot())
+  {
+    clear();
+    insertRun(0, values.size() ? &values[0] : nullptr, values.size());
+    return;
+  }
+
+  unsigned int valueIndex = 0;
+  for (const operation & op : _delta.operations())
+  {
+    switch (op.m_kind)
+    {
+      case op_kind::append:
+        assert(op.m_position == m_items.size());
+        insertRun(m_items.size(), &values[valueIndex], op.m_count);
+        valueIndex += op.m_count;
+        break;
+
+      case op_kind::insert:
+        insertRun(op.m_position, &values[valueIndex], op.m_count);
+        valueIndex += op.m_count;
+        break;
+
+      case op_kind::erase:
+        erase(op.m_position, op.m_position + op.m_count);
+        break;
+
+      case op_kind::set:
+        setRun(op.m_position, &values[valueIndex], op.m_count);
+        valueIndex += op.m_count;
+        break;
+    }
+  }
+
+  assert(valueIndex == values.size());
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+unsigned int
+CJournaledArray<TData>::journal_size() const
+{
+  return m_operations.size() + m_values.size();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CJournaledArray<TData>::const_iterator
+CJournaledArray<TData>::begin() const
+{
+  return m_items.begin();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CJournaledArray<TData>::const_iterator
+CJournaledArray<TData>::cbegin() const
+{
+  return m_items.cbegin();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CJournaledArray<TData>::const_iterator
+CJournaledArray<TData>::end() const
+{
+  return m_items.end();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CJournaledArray<TData>::const_iterator
+CJournaledArray<TData>::cend() const
+{
+  return m_items.cend();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CJournaledArray<TData>::insertRun(
+    unsigned int  _index,
+    const TData * _pValues,
+    unsigned int  _count
+  )
+{
+  assert(_index <= m_items.size());
+
+  if (_index == m_items.size())
+  {
+    for (unsigned int index = 0; index < _count; ++index)
+    {
+      push_back(_pValues[index]);
+    }
+    return;
+  }
+
+  // Вставка подряд за один проход
+  CArray<unsigned int> positions;
+  positions.reserve(_count);
+  for (unsigned int index = 0; index < _count; ++index)
+  {
+    recordInsert(_index + index, _pValues[index]);
+    positions.push_back(_index);
+  }
+
+  m_items.insert_many(positions, CArrayView<TData>(_pValues, _count));
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CJournaledArray<TData>::setRun(
+    unsigned int  _index,
+    const TData * _pValues,
+    unsigned int  _count
+  )
+{
+  for (unsigned int index = 0; index < _count; ++index)
+  {
+    set(_index + index, _pValues[index]);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CJournaledArray<TData>::recordInsert(
+    unsigned int  _index,
+    const TData & _value
+  )
+{
+  if (m_overflow)
+  {
+    return;
+  }
+
+  operation * pLast = lastOperation();
+  if (pLast && (pLast->m_kind == op_kind::append || pLast->m_kind == op_kind::insert)
+      && pLast->m_position <= _index && _index <= pLast->m_position + pLast->m_count)
+  {
+    // Вставка внутрь или сразу за последней вставкой расширяет ее;
+    // значения последней операции - в конце m_values
+    const unsigned int valueIndex = m_values.size() - pLast->m_count + (_index - pLast->m_position);
+    ++pLast->m_count;
+
+    if (valueIndex == m_values.size())
+    {
+      m_values.push_back(_value);
+    }
+    else
+    {
+      m_values.insert(valueIndex, _value);
+    }
+  }
+  else
+  {
+    const op_kind kind = _index == m_items.size() ? op_kind::append : op_kind::insert;
+    m_operations.push_back(operation{kind, _index, 1});
+    m_values.push_back(_value);
+  }
+
+  checkOverflow();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CJournaledArray<TData>::recordErase(
+    unsigned int _indexFrom,
+    unsigned int _indexTo
+  )
+{
+  if (m_overflow)
+  {
+    return;
+  }
+
+  const unsigned int count = _indexTo - _indexFrom;
+
+  operation * pLast = lastOperation();
+  if (pLast && (pLast->m_kind == op_kind::append || pLast->m_kind == op_kind::insert)
+      && pLast->m_position <= _indexFrom && _indexTo <= pLast->m_position + pLast->m_count)
+  {
+    // Удаление только что вставленных элементов сокращает вставку
+    const unsigned int valueFrom = m_values.size() - pLast->m_count + (_indexFrom - pLast->m_position);
+    m_values.erase(m_values.begin() + valueFrom, m_values.begin() + valueFrom + count);
+
+    pLast->m_count -= count;
+    if (pLast->m_count == 0)
+    {
+      m_operations.erase(m_operations.size() - 1);
+    }
+    return;
+  }
+
+  if (pLast && pLast->m_kind == op_kind::erase
+      && (pLast->m_position == _indexFrom || pLast->m_position == _indexTo))
+  {
+    // Удаление, смежное с последним удалением, расширяет его
+    pLast->m_position  = _indexFrom;
+    pLast->m_count    += count;
+    return;
+  }
+
+  m_operations.push_back(operation{op_kind::erase, _indexFrom, count});
+  checkOverflow();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CJournaledArray<TData>::recordSet(
+    unsigned int  _index,
+    const TData & _value
+  )
+{
+  if (m_overflow)
+  {
+    return;
+  }
+
+  operation * pLast = lastOperation();
+  if (pLast && pLast->m_kind != op_kind::erase
+      && pLast->m_position <= _index && _index < pLast->m_position + pLast->m_count)
+  {
+    // Элемент уже записан последней операцией: меняется ее значение
+    m_values[m_values.size() - pLast->m_count + (_index - pLast->m_position)] = _value;
+    return;
+  }
+
+  if (pLast && pLast->m_kind == op_kind::set && _index == pLast->m_position + pLast->m_count)
+  {
+    ++pLast->m_count;
+  }
+  else
+  {
+    m_operations.push_back(operation{op_kind::set, _index, 1});
+  }
+  m_values.push_back(_value);
+
+  checkOverflow();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CJournaledArray<TData>::operation *
+CJournaledArray<TData>::lastOperation()
+{
+  return m_operations.empty() ? nullptr : &m_operations[m_operations.size() - 1];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CJournaledArray<TData>::checkOverflow()
+{
+  if (journal_size() > m_maxJournal)
+  {
+    m_overflow = true;
+    m_operations.clear();
+    m_values.clear();
+  }
+}
@@ -0,0 +1,613 @@
+#pragma once
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <cassert>
+#include <cstring>
+#include <cstdint>
+#include <iterator>
+
+#include "CArray.h"
+#include "CArrayBits.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// class CLazyEraseArray - массив с отложенным удалением элементов.
+//
+// erase() не сдвигает хвост, а помечает элемент в битовой карте удаленных.
+// Итерация пропускает удаленные элементы пословно по битовой карте.
+// Для доступа по индексу поддерживается дерево Фенвика с количеством
+// удаленных элементов по словам карты: поиск физической позиции и
+// пометка удаления выполняются за O(log n).
+// Уплотнение выполняется за один линейный проход явно (compact()) или
+// автоматически, когда доля удаленных элементов превышает порог.
+template <typename TData, typename TAllocator = std::allocator<TData>>
+class CLazyEraseArray
+{
+public: // Interface
+
+  template <typename ContainerType, typename DataType>
+  class iterator_base;
+
+  using iterator       = iterator_base<CLazyEraseArray, TData>;
+  using const_iterator = iterator_base<const CLazyEraseArray, const TData>;
+
+  // Конструктор по умолчанию
+  CLazyEraseArray();
+
+  // Добавить элемент в конец массива
+  void push_back(
+      const TData & _value
+    );
+
+  // Сконструировать элемент в конце массива
+  template <class... Args>
+  void emplace_back(
+      Args&&... args
+    );
+
+  // Вставить элемент в массив по заданному индексу.
+  // Перед вставкой удаленные элементы уплотняются.
+  void insert(
+      unsigned int  _index,
+      const TData & _value
+    );
+
+  // Пометить элемент массива по заданному индексу как удаленный
+  void erase(
+      unsigned int _index
+    );
+
+  // Очистить массив
+  void clear();
+
+  // Уплотнить массив: физически удалить помеченные элементы
+  void compact();
+
+  // Задать долю удаленных элементов, при превышении которой массив
+  // уплотняется автоматически (1.0 - только явный вызов compact())
+  void setCompactionThreshold(
+      double _deadFraction
+    );
+
+  // Получить количество живых элементов
+  unsigned int size() const;
+
+  // Определить что массив пустой
+  bool empty() const;
+
+  // Получить количество помеченных, но еще не удаленных элементов
+  unsigned int erasedCount() const;
+
+  // Получить элемент массива по заданному индексу
+  TData & operator[](
+      unsigned int _index
+    );
+
+  // Получить элемент массива по заданному индексу
+  const TData & operator[](
+      unsigned int _index
+    ) const;
+
+  iterator        begin();
+  const_iterator  begin()   const;
+  const_iterator  cbegin()  const;
+
+  iterator        end();
+  const_iterator  end()     const;
+  const_iterator  cend()    const;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Итератор по живым элементам
+  template <typename ContainerType, typename DataType>
+  class iterator_base
+  {
+    friend CLazyEraseArray;
+
+  public:
+
+    // iterator traits
+    using difference_type   = int;
+    using value_type        = typename std::remove_const<DataType>::type;
+    using pointer           = DataType *;
+    using reference         = DataType &;
+    using iterator_category = std::forward_iterator_tag;
+
+    iterator_base & operator++();
+    iterator_base   operator++(int);
+
+    bool operator==(
+        const iterator_base & _it
+      ) const;
+
+    bool operator!=(
+        const iterator_base & _it
+      ) const;
+
+    DataType & operator*() const;
+    DataType * operator->() const;
+
+  protected:
+
+    explicit iterator_base(
+        ContainerType * _arrayContainer,
+        unsigned int    _physicalIndex
+      );
+
+    ContainerType * m_arrayContainer = nullptr;
+    unsigned int    m_physicalIndex  = 0;
+  };
+
+protected:  // Методы
+
+  static constexpr unsigned int WordBits = 64;
+
+  // Определить, есть ли помеченные элементы
+  bool hasErased() const;
+
+  // Получить физическую позицию элемента по индексу среди живых
+  unsigned int physicalIndex(
+      unsigned int _index
+    ) const;
+
+  // Получить первую живую позицию, начиная с заданной
+  unsigned int nextAlive(
+      unsigned int _physicalIndex
+    ) const;
+
+  // Добавить слово карты для новой физической позиции
+  void growErasedMap();
+
+  // Учесть удаление в дереве Фенвика
+  void addErasedToTree(
+      unsigned int _wordIndex
+    );
+
+protected: // Attributes
+
+  CArray<TData, TAllocator> m_items;             //< Все элементы, включая удаленные
+  CArray<uint64_t>          m_erasedBits;        //< Битовая карта удаленных элементов
+  CArray<unsigned int>      m_erasedTree;        //< Дерево Фенвика по словам карты (с 1)
+  unsigned int              m_erasedCount = 0;
+  double                    m_compactionThreshold = 0.5;
+};
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CLazyEraseArray<TData, TAllocator>::CLazyEraseArray()
+{
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CLazyEraseArray<TData, TAllocator>::push_back(
+    const TData & _value
+  )
+{
+  m_items.push_back(_value);
+  growErasedMap();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+template <class ...Args>
+void
+CLazyEraseArray<TData, TAllocator>::emplace_back(
+    Args && ...args
+  )
+{
+  m_items.emplace_back(std::forward<Args>(args)...);
+  growErasedMap();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CLazyEraseArray<TData, TAllocator>::insert(
+    unsigned int  _index,
+    const TData & _value
+  )
+{
+  compact();
+
+  m_items.insert(_index, _value);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CLazyEraseArray<TData, TAllocator>::erase(
+    unsigned int _index
+  )
+{
+  assert(_index < size());
+
+  if (!hasErased())
+  {
+    // Первое удаление - заводим битовую карту и дерево
+    const unsigned int wordCount = (m_items.size() + WordBits - 1) / WordBits;
+    for (unsigned int wordIndex = 0; wordIndex < wordCount; ++wordIndex)
+    {
+      m_erasedBits.push_back(0);
+      m_erasedTree.push_back(0);
+    }
+  }
+
+  const unsigned int position  = physicalIndex(_index);
+  const unsigned int wordIndex = position / WordBits;
+
+  m_erasedBits[wordIndex] |= uint64_t(1) << (position % WordBits);
+  addErasedToTree(wordIndex);
+  ++m_erasedCount;
+
+  if (m_erasedCount > m_compactionThreshold * m_items.size())
+  {
+    compact();
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CLazyEraseArray<TData, TAllocator>::clear()
+{
+  m_items.clear();
+  m_erasedBits.clear();
+  m_erasedTree.clear();
+  m_erasedCount = 0;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CLazyEraseArray<TData, TAllocator>::compact()
+{
+  if (!hasErased())
+  {
+    return;
+  }
+
+  const unsigned int count = m_items.size();
+  TData * items = &m_items[0];
+
+  unsigned int toIdx = 0;
+  for (unsigned int wordIndex = 0, wordFrom = 0; wordFrom < count; ++wordIndex, wordFrom += WordBits)
+  {
+    const unsigned int wordCount = std::min(WordBits, count - wordFrom);
+    uint64_t aliveBits = ~m_erasedBits[wordIndex] & lowBitsMask(wordCount);
+
+    if (toIdx == wordFrom && aliveBits == lowBitsMask(wordCount))
+    {
+      // До этого слова удалений не было - элементы остаются на месте
+      toIdx += wordCount;
+      continue;
+    }
+
+    while (aliveBits)
+    {
+      // Переносим непрерывную серию живых элементов
+      const unsigned int runFrom = lowestBitIndex(aliveBits);
+      const uint64_t     rest    = ~(aliveBits >> runFrom);
+      const unsigned int runLen  = rest ? lowestBitIndex(rest) : WordBits - runFrom;
+
+      TData * src = items + wordFrom + runFrom;
+      if (src == items + toIdx)
+      {
+        // Серия уже на своем месте
+      }
+      else if constexpr (std::is_trivially_copyable<TData>::value)
+      {
+        memmove(items + toIdx, src, runLen * sizeof(TData));
+      }
+      else
+      {
+        std::move(src, src + runLen, items + toIdx);
+      }
+
+      toIdx     += runLen;
+      aliveBits &= ~(lowBitsMask(runLen) << runFrom);
+    }
+  }
+
+  m_items.erase(m_items.begin() + toIdx, m_items.end());
+
+  m_erasedBits.clear();
+  m_erasedTree.clear();
+  m_erasedCount = 0;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CLazyEraseArray<TData, TAllocator>::setCompactionThreshold(
+    double _deadFraction
+  )
+{
+  m_compactionThreshold = _deadFraction;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+unsigned int
+CLazyEraseArray<TData, TAllocator>::size() const
+{
+  return m_items.size() - m_erasedCount;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+bool
+CLazyEraseArray<TData, TAllocator>::empty() const
+{
+  return size() == 0;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+unsigned int
+CLazyEraseArray<TData, TAllocator>::erasedCount() const
+{
+  return m_erasedCount;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+TData &
+CLazyEraseArray<TData, TAllocator>::operator[](
+    unsigned int _index
+  )
+{
+  return m_items[physicalIndex(_index)];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+const TData &
+CLazyEraseArray<TData, TAllocator>::operator[](
+    unsigned int _index
+  ) const
+{
+  return m_items[physicalIndex(_index)];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CLazyEraseArray<TData, TAllocator>::iterator
+CLazyEraseArray<TData, TAllocator>::begin()
+{
+  return iterator(this, nextAlive(0));
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CLazyEraseArray<TData, TAllocator>::const_iterator
+CLazyEraseArray<TData, TAllocator>::begin() const
+{
+  return cbegin();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CLazyEraseArray<TData, TAllocator>::const_iterator
+CLazyEraseArray<TData, TAllocator>::cbegin() const
+{
+  return const_iterator(this, nextAlive(0));
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CLazyEraseArray<TData, TAllocator>::iterator
+CLazyEraseArray<TData, TAllocator>::end()
+{
+  return iterator(this, m_items.size());
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CLazyEraseArray<TData, TAllocator>::const_iterator
+CLazyEraseArray<TData, TAllocator>::end() const
+{
+  return cend();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CLazyEraseArray<TData, TAllocator>::const_iterator
+CLazyEraseArray<TData, TAllocator>::cend() const
+{
+  return const_iterator(this, m_items.size());
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+bool
+CLazyEraseArray<TData, TAllocator>::hasErased() const
+{
+  return m_erasedCount != 0;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+unsigned int
+CLazyEraseArray<TData, TAllocator>::physicalIndex(
+    unsigned int _index
+  ) const
+{
+  if (!hasErased())
+  {
+    return _index;
+  }
+
+  // Спуск по дереву Фенвика: ищем слово, в котором находится
+  // _index-й живой элемент
+  const unsigned int wordCount = m_erasedTree.size();
+
+  unsigned int step = 1;
+  while (step * 2 <= wordCount)
+  {
+    step *= 2;
+  }
+
+  unsigned int wordIndex = 0;
+  unsigned int rest      = _index;
+  for ( ; step; step /= 2)
+  {
+    const unsigned int next = wordIndex + step;
+    if (next <= wordCount)
+    {
+      const unsigned int alive = step * WordBits - m_erasedTree[next - 1];
+      if (alive <= rest)
+      {
+        wordIndex = next;
+        rest     -= alive;
+      }
+    }
+  }
+
+  return wordIndex * WordBits + selectBit(~m_erasedBits[wordIndex], rest);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+unsigned int
+CLazyEraseArray<TData, TAllocator>::nextAlive(
+    unsigned int _physicalIndex
+  ) const
+{
+  const unsigned int count = m_items.size();
+  if (!hasErased() || _physicalIndex >= count)
+  {
+    return std::min(_physicalIndex, count);
+  }
+
+  unsigned int wordIndex = _physicalIndex / WordBits;
+  uint64_t aliveBits = ~m_erasedBits[wordIndex] & ~lowBitsMask(_physicalIndex % WordBits);
+
+  while (aliveBits == 0)
+  {
+    if (++wordIndex == m_erasedBits.size())
+    {
+      return count;
+    }
+
+    aliveBits = ~m_erasedBits[wordIndex];
+  }
+
+  return std::min(wordIndex * WordBits + lowestBitIndex(aliveBits), count);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CLazyEraseArray<TData, TAllocator>::growErasedMap()
+{
+  if (!hasErased() || m_items.size() <= m_erasedBits.size() * WordBits)
+  {
+    return;
+  }
+
+  // Новый узел дерева Фенвика хранит сумму по своему диапазону слов,
+  // новое слово пустое - складываем только вложенные узлы
+  const unsigned int node  = m_erasedTree.size() + 1;
+  const unsigned int lower = node - (node & (0u - node));
+
+  unsigned int sum = 0;
+  for (unsigned int child = node - 1; child > lower; child -= child & (0u - child))
+  {
+    sum += m_erasedTree[child - 1];
+  }
+
+  m_erasedBits.push_back(0);
+  m_erasedTree.push_back(sum);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CLazyEraseArray<TData, TAllocator>::addErasedToTree(
+    unsigned int _wordIndex
+  )
+{
+  const unsigned int wordCount = m_erasedTree.size();
+  for (unsigned int node = _wordIndex + 1; node <= wordCount; node += node & (0u - node))
+  {
+    ++m_erasedTree[node - 1];
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+template <typename ContainerType, typename DataType>
+CLazyEraseArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::iterator_base(
+    ContainerType * _arrayContainer,
+    unsigned int    _physicalIndex
+  )
+  : m_arrayContainer(_arrayContainer),
+    m_physicalIndex (_physicalIndex)
+{
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+template <typename ContainerType, typename DataType>
+typename CLazyEraseArray<TData, TAllocator>::template iterator_base<ContainerType, DataType> &
+CLazyEraseArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator++()
+{
+  m_physicalIndex = m_arrayContainer->nextAlive(m_physicalIndex + 1);
+
+  return *this;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+template <typename ContainerType, typename DataType>
+typename CLazyEraseArray<TData, TAllocator>::template iterator_base<ContainerType, DataType>
+CLazyEraseArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator++(
+    int
+  )
+{
+  iterator_base<ContainerType, DataType> tmp(*this);
+  operator++();
+  return tmp;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+template <typename ContainerType, typename DataType>
+bool
+CLazyEraseArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator==(
+    const iterator_base & _it
+  ) const
+{
+  return m_arrayContainer == _it.m_arrayContainer && m_physicalIndex == _it.m_physicalIndex;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+template <typename ContainerType, typename DataType>
+bool
+CLazyEraseArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator!=(
+    const iterator_base & _it
+  ) const
+{
+  return !operator==(_it);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+template <typename ContainerType, typename DataType>
+DataType &
+CLazyEraseArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator*() const
+{
+  return m_arrayContainer->m_items[m_physicalIndex];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+template <typename ContainerType, typename DataType>
+DataType *
+CLazyEraseArray<TData, TAllocator>::iterator_base<ContainerType, DataType>::operator->() const
+{
+  return &m_arrayContainer->m_items[m_physicalIndex];
+}
@@ -0,0 +1,1115 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#if defined(__has_include)
+#  if __has_include(<version>)
+#    include <version>
+#  endif
+#endif
+
+#ifdef __cpp_lib_ranges
+#  include <ranges>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Ленивые представления над массивами с доступом по индексу (CArray,
+// std::vector и т.п.):
+//
+//   auto total = lazyView(array).filter(isValid)
+//                               .transform(toPrice)
+//                               .reduce(0.0, std::plus<>());
+//
+// Цепочка не создает промежуточных массивов: терминальные операции (to,
+// reduce, for_each, count) выполняют один цикл, в который встраиваются все
+// этапы. Представления хранят указатель на исходный массив и не должны его
+// пережить. Представления имеют begin()/end() и обходятся циклом for по
+// диапазону. std::ranges::view они являются только при сборке со
+// стандартом C++20 (<ranges>): тогда CLazyViewTag - это
+// std::ranges::view_base и представления совместимы со стандартными
+// адаптерами. При C++17 CLazyViewTag - пустая структура.
+//
+// Представления делятся на два вида:
+//   - с произвольным доступом (randomAccess): size() и at(i) за O(1);
+//   - последовательные (после filter): обход курсором.
+// zip и chunk требуют произвольного доступа.
+
+template <typename TView> class CLazyView;
+template <typename TArray> class CLazySource;
+template <typename TBase, typename TPred> class CLazyFilter;
+template <typename TBase, typename TFunc> class CLazyTransform;
+template <typename TFirst, typename TSecond> class CLazyZip;
+template <typename TBase> class CLazyEnumerate;
+template <typename TBase> class CLazyChunk;
+template <typename TBase> class CLazySubrange;
+template <typename TBase> class CLazyStride;
+template <typename TBase> class CLazyTake;
+template <typename TBase> class CLazyDrop;
+
+// Условие наличия size() и at() у этапа, сохраняющего вид базового
+// представления
+template <typename TBase>
+using CLazyIfRandomAccess = std::enable_if_t<TBase::randomAccess, int>;
+
+// Базовый класс представлений: с <ranges> отмечает их как std::ranges::view
+#ifdef __cpp_lib_ranges
+using CLazyViewTag = std::ranges::view_base;
+#else
+struct CLazyViewTag
+{
+};
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// class CLazyFunc - хранение функции этапа с поддержкой присваивания
+// (лямбды с захватом не присваиваются, а представления должны)
+template <typename TFunc>
+class CLazyFunc
+{
+public:
+
+  CLazyFunc() = default;
+
+  explicit CLazyFunc(
+      TFunc _func
+    )
+    : m_func(std::move(_func))
+  {
+  }
+
+  CLazyFunc(const CLazyFunc &) = default;
+  CLazyFunc(CLazyFunc &&) = default;
+
+  CLazyFunc & operator=(
+      const CLazyFunc & _other
+    )
+  {
+    if (this != &_other)
+    {
+      assign(_other.m_func);
+    }
+    return *this;
+  }
+
+  CLazyFunc & operator=(
+      CLazyFunc && _other
+    )
+  {
+    if (this != &_other)
+    {
+      assign(std::move(_other.m_func));
+    }
+    return *this;
+  }
+
+  template <typename... TArgs>
+  decltype(auto) operator()(
+      TArgs &&... _args
+    ) const
+  {
+    return (*m_func)(std::forward<TArgs>(_args)...);
+  }
+
+private:
+
+  template <typename TOptional>
+  void assign(
+      TOptional && _func
+    )
+  {
+    m_func.reset();
+    if (_func)
+    {
+      m_func.emplace(*std::forward<TOptional>(_func));
+    }
+  }
+
+  std::optional<TFunc> m_func;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct CLazyCursor - единый обход представлений обоих видов:
+// для представлений с произвольным доступом курсор - индекс
+template <typename TView, bool randomAccess = TView::randomAccess>
+struct CLazyCursor
+{
+  using type = unsigned int;
+
+  static type begin(const TView &)                       { return 0; }
+  static bool done(const TView & _view, type _cursor)     { return _cursor >= _view.size(); }
+  static void next(const TView &, type & _cursor)         { ++_cursor; }
+
+  static decltype(auto) read(const TView & _view, type _cursor)
+  {
+    return _view.at(_cursor);
+  }
+};
+
+//----------------------------------------------------------------------------//
+template <typename TView>
+struct CLazyCursor<TView, false>
+{
+  using type = typename TView::cursor_type;
+
+  static type begin(const TView & _view)                     { return _view.cursorBegin(); }
+  static bool done(const TView & _view, const type & _cursor) { return _view.cursorDone(_cursor); }
+  static void next(const TView & _view, type & _cursor)       { _view.cursorNext(_cursor); }
+
+  static decltype(auto) read(const TView & _view, const type & _cursor)
+  {
+    return _view.cursorRead(_cursor);
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CLazyIndexIterator - итератор представления с произвольным доступом
+template <typename TView>
+class CLazyIndexIterator
+{
+public:
+
+  using difference_type   = std::ptrdiff_t;
+  using reference         = typename TView::reference;
+  using value_type        = typename TView::value_type;
+  using pointer           = void;
+  using iterator_category = std::conditional_t<std::is_reference<reference>::value,
+                                               std::random_access_iterator_tag,
+                                               std::input_iterator_tag>;
+#ifdef __cpp_lib_ranges
+  using iterator_concept  = std::random_access_iterator_tag;
+#endif
+
+  CLazyIndexIterator() = default;
+
+  CLazyIndexIterator(
+      const TView * _view,
+      unsigned int  _index
+    )
+    : m_view (_view),
+      m_index(_index)
+  {
+  }
+
+  reference operator*() const                          { return m_view->at(m_index); }
+  reference operator[](difference_type _offset) const  { return m_view->at(static_cast<unsigned int>(m_index + _offset)); }
+
+  CLazyIndexIterator & operator++()    { ++m_index; return *this; }
+  CLazyIndexIterator & operator--()    { --m_index; return *this; }
+  CLazyIndexIterator   operator++(int) { CLazyIndexIterator tmp(*this); ++m_index; return tmp; }
+  CLazyIndexIterator   operator--(int) { CLazyIndexIterator tmp(*this); --m_index; return tmp; }
+
+  CLazyIndexIterator & operator+=(difference_type _offset) { m_index = static_cast<unsigned int>(m_index + _offset); return *this; }
+  CLazyIndexIterator & operator-=(difference_type _offset) { m_index = static_cast<unsigned int>(m_index - _offset); return *this; }
+
+  CLazyIndexIterator operator+(difference_type _offset) const { CLazyIndexIterator tmp(*this); return tmp += _offset; }
+  CLazyIndexIterator operator-(difference_type _offset) const { CLazyIndexIterator tmp(*this); return tmp -= _offset; }
+
+  friend CLazyIndexIterator operator+(difference_type _offset, const CLazyIndexIterator & _it) { return _it + _offset; }
+
+  difference_type operator-(const CLazyIndexIterator & _it) const
+  {
+    return static_cast<difference_type>(m_index) - static_cast<difference_type>(_it.m_index);
+  }
+
+  bool operator==(const CLazyIndexIterator & _it) const { return m_index == _it.m_index; }
+  bool operator!=(const CLazyIndexIterator & _it) const { return m_index != _it.m_index; }
+  bool operator< (const CLazyIndexIterator & _it) const { return m_index <  _it.m_index; }
+  bool operator> (const CLazyIndexIterator & _it) const { return m_index >  _it.m_index; }
+  bool operator<=(const CLazyIndexIterator & _it) const { return m_index <= _it.m_index; }
+  bool operator>=(const CLazyIndexIterator & _it) const { return m_index >= _it.m_index; }
+
+private:
+
+  const TView * m_view  = nullptr;
+  unsigned int  m_index = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CLazySeqIterator - итератор последовательного представления
+template <typename TView>
+class CLazySeqIterator
+{
+  using TCursor = CLazyCursor<TView>;
+
+public:
+
+  using difference_type   = std::ptrdiff_t;
+  using reference         = typename TView::reference;
+  using value_type        = typename TView::value_type;
+  using pointer           = void;
+  using iterator_category = std::conditional_t<std::is_reference<reference>::value,
+                                               std::forward_iterator_tag,
+                                               std::input_iterator_tag>;
+#ifdef __cpp_lib_ranges
+  using iterator_concept  = std::forward_iterator_tag;
+#endif
+
+  CLazySeqIterator() = default;
+
+  // Итератор на начало представления
+  explicit CLazySeqIterator(
+      const TView * _view
+    )
+    : m_view  (_view),
+      m_cursor(TCursor::begin(*_view)),
+      m_end   (false)
+  {
+  }
+
+  reference operator*() const { return TCursor::read(*m_view, m_cursor); }
+
+  CLazySeqIterator & operator++()    { TCursor::next(*m_view, m_cursor); return *this; }
+  CLazySeqIterator   operator++(int) { CLazySeqIterator tmp(*this); ++*this; return tmp; }
+
+  // Итератор конца (m_end) равен любому итератору, дошедшему до конца
+  bool operator==(
+      const CLazySeqIterator & _it
+    ) const
+  {
+    const bool atEnd      = isEnd();
+    const bool otherAtEnd = _it.isEnd();
+
+    return atEnd == otherAtEnd && (atEnd || m_cursor == _it.m_cursor);
+  }
+
+  bool operator!=(const CLazySeqIterator & _it) const { return !operator==(_it); }
+
+private:
+
+  bool isEnd() const
+  {
+    return m_end || TCursor::done(*m_view, m_cursor);
+  }
+
+  const TView *           m_view   = nullptr;
+  typename TCursor::type  m_cursor = {};
+  bool                    m_end    = true;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CLazyView - общая часть представлений: построение следующих этапов,
+// итераторы и терминальные операции
+template <typename TView>
+class CLazyView : public CLazyViewTag
+{
+public:
+
+  // Оставить элементы, удовлетворяющие условию
+  template <typename TPred>
+  CLazyFilter<TView, TPred> filter(
+      TPred _pred
+    ) const
+  {
+    return CLazyFilter<TView, TPred>(self(), std::move(_pred));
+  }
+
+  // Заменить элементы результатом функции
+  template <typename TFunc>
+  CLazyTransform<TView, TFunc> transform(
+      TFunc _func
+    ) const
+  {
+    return CLazyTransform<TView, TFunc>(self(), std::move(_func));
+  }
+
+  // Пары элементов этого и другого представления (или массива)
+  template <typename TOther>
+  auto zip(
+      const TOther & _other
+    ) const
+  {
+    if constexpr (std::is_base_of<CLazyViewTag, TOther>::value)
+    {
+      return CLazyZip<TView, TOther>(self(), _other);
+    }
+    else
+    {
+      return CLazyZip<TView, CLazySource<const TOther>>(self(), CLazySource<const TOther>(_other));
+    }
+  }
+
+  // Пары (индекс, элемент)
+  CLazyEnumerate<TView> enumerate() const
+  {
+    return CLazyEnumerate<TView>(self());
+  }
+
+  // Части по _size элементов (последняя может быть короче)
+  CLazyChunk<TView> chunk(
+      unsigned int _size
+    ) const
+  {
+    return CLazyChunk<TView>(self(), _size);
+  }
+
+  // Каждый _step-й элемент, начиная с первого
+  CLazyStride<TView> stride(
+      unsigned int _step
+    ) const
+  {
+    return CLazyStride<TView>(self(), _step);
+  }
+
+  // Первые _count элементов
+  CLazyTake<TView> take(
+      unsigned int _count
+    ) const
+  {
+    return CLazyTake<TView>(self(), _count);
+  }
+
+  // Все элементы, кроме первых _count
+  CLazyDrop<TView> drop(
+      unsigned int _count
+    ) const
+  {
+    return CLazyDrop<TView>(self(), _count);
+  }
+
+  // Собрать элементы в массив. Для представлений с произвольным доступом
+  // память выделяется один раз.
+  template <typename TArray>
+  TArray to() const
+  {
+    TArray result;
+    if constexpr (TView::randomAccess)
+    {
+      result.reserve(self().size());
+    }
+
+    self().forEach([&result](auto && _value)
+                   {
+                     result.push_back(std::forward<decltype(_value)>(_value));
+                     return true;
+                   });
+    return result;
+  }
+
+  // Свертка элементов: _init = _op(_init, элемент)
+  template <typename T, typename TOp>
+  T reduce(
+      T   _init,
+      TOp _op
+    ) const
+  {
+    self().forEach([&_init, &_op](auto && _value)
+                   {
+                     _init = _op(std::move(_init), std::forward<decltype(_value)>(_value));
+                     return true;
+                   });
+    return _init;
+  }
+
+  // Вызвать функцию для каждого элемента
+  template <typename TFunc>
+  void for_each(
+      TFunc _func
+    ) const
+  {
+    self().forEach([&_func](auto && _value)
+                   {
+                     _func(std::forward<decltype(_value)>(_value));
+                     return true;
+                   });
+  }
+
+  // Количество элементов
+  unsigned int count() const
+  {
+    if constexpr (TView::randomAccess)
+    {
+      return self().size();
+    }
+    else
+    {
+      unsigned int result = 0;
+      self().forEach([&result](auto &&) { ++result; return true; });
+      return result;
+    }
+  }
+
+  auto begin() const
+  {
+    if constexpr (TView::randomAccess)
+    {
+      return CLazyIndexIterator<TView>(&self(), 0);
+    }
+    else
+    {
+      return CLazySeqIterator<TView>(&self());
+    }
+  }
+
+  auto end() const
+  {
+    if constexpr (TView::randomAccess)
+    {
+      return CLazyIndexIterator<TView>(&self(), self().size());
+    }
+    else
+    {
+      return CLazySeqIterator<TView>();
+    }
+  }
+
+protected:
+
+  const TView & self() const
+  {
+    return static_cast<const TView &>(*this);
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CLazySource - начало цепочки, элементы массива без копирования
+template <typename TArray>
+class CLazySource : public CLazyView<CLazySource<TArray>>
+{
+public:
+
+  static constexpr bool randomAccess = true;
+
+  using reference  = decltype(std::declval<TArray &>()[0u]);
+  using value_type = std::remove_cv_t<std::remove_reference_t<reference>>;
+
+  CLazySource() = default;
+
+  explicit CLazySource(
+      TArray & _array
+    )
+    : m_array(&_array)
+  {
+  }
+
+  unsigned int size() const                   { return static_cast<unsigned int>(m_array->size()); }
+  reference    at(unsigned int _index) const  { return (*m_array)[_index]; }
+
+  template <typename TSink>
+  bool forEach(
+      TSink && _sink
+    ) const
+  {
+    const unsigned int count = size();
+    for (unsigned int index = 0; index < count; ++index)
+    {
+      if (!_sink((*m_array)[index]))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+
+  TArray * m_array = nullptr;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CLazyFilter - элементы, удовлетворяющие условию
+template <typename TBase, typename TPred>
+class CLazyFilter : public CLazyView<CLazyFilter<TBase, TPred>>
+{
+  using TBaseCursor = CLazyCursor<TBase>;
+
+public:
+
+  static constexpr bool randomAccess = false;
+
+  using reference   = typename TBase::reference;
+  using value_type  = typename TBase::value_type;
+  using cursor_type = typename TBaseCursor::type;
+
+  CLazyFilter() = default;
+
+  CLazyFilter(
+      const TBase & _base,
+      TPred         _pred
+    )
+    : m_base(_base),
+      m_pred(std::move(_pred))
+  {
+  }
+
+  template <typename TSink>
+  bool forEach(
+      TSink && _sink
+    ) const
+  {
+    return m_base.forEach([this, &_sink](auto && _value)
+                          {
+                            return !m_pred(_value) || _sink(std::forward<decltype(_value)>(_value));
+                          });
+  }
+
+  cursor_type cursorBegin() const
+  {
+    cursor_type cursor = TBaseCursor::begin(m_base);
+    skip(cursor);
+    return cursor;
+  }
+
+  bool      cursorDone(const cursor_type & _cursor) const { return TBaseCursor::done(m_base, _cursor); }
+  reference cursorRead(const cursor_type & _cursor) const { return TBaseCursor::read(m_base, _cursor); }
+
+  void cursorNext(
+      cursor_type & _cursor
+    ) const
+  {
+    TBaseCursor::next(m_base, _cursor);
+    skip(_cursor);
+  }
+
+private:
+
+  // Пропустить элементы, не удовлетворяющие условию
+  void skip(
+      cursor_type & _cursor
+    ) const
+  {
+    while (!TBaseCursor::done(m_base, _cursor) && !m_pred(TBaseCursor::read(m_base, _cursor)))
+    {
+      TBaseCursor::next(m_base, _cursor);
+    }
+  }
+
+  TBase            m_base;
+  CLazyFunc<TPred> m_pred;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CLazyTransform - результат функции для каждого элемента
+template <typename TBase, typename TFunc>
+class CLazyTransform : public CLazyView<CLazyTransform<TBase, TFunc>>
+{
+  using TBaseCursor = CLazyCursor<TBase>;
+
+public:
+
+  static constexpr bool randomAccess = TBase::randomAccess;
+
+  using reference   = decltype(std::declval<const TFunc &>()(std::declval<typename TBase::reference>()));
+  using value_type  = std::remove_cv_t<std::remove_reference_t<reference>>;
+  using cursor_type = typename TBaseCursor::type;
+
+  CLazyTransform() = default;
+
+  CLazyTransform(
+      const TBase & _base,
+      TFunc         _func
+    )
+    : m_base(_base),
+      m_func(std::move(_func))
+  {
+  }
+
+  template <typename TB = TBase, CLazyIfRandomAccess<TB> = 0>
+  unsigned int size() const                  { return m_base.size(); }
+
+  template <typename TB = TBase, CLazyIfRandomAccess<TB> = 0>
+  reference    at(unsigned int _index) const { return m_func(m_base.at(_index)); }
+
+  template <typename TSink>
+  bool forEach(
+      TSink && _sink
+    ) const
+  {
+    return m_base.forEach([this, &_sink](auto && _value)
+                          {
+                            return _sink(m_func(std::forward<decltype(_value)>(_value)));
+                          });
+  }
+
+  cursor_type cursorBegin() const                                 { return TBaseCursor::begin(m_base); }
+  bool        cursorDone(const cursor_type & _cursor) const       { return TBaseCursor::done(m_base, _cursor); }
+  void        cursorNext(cursor_type & _cursor) const             { TBaseCursor::next(m_base, _cursor); }
+  reference   cursorRead(const cursor_type & _cursor) const       { return m_func(TBaseCursor::read(m_base, _cursor)); }
+
+private:
+
+  TBase            m_base;
+  CLazyFunc<TFunc> m_func;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CLazyZip - пары элементов двух представлений, длина по меньшему
+template <typename TFirst, typename TSecond>
+class CLazyZip : public CLazyView<CLazyZip<TFirst, TSecond>>
+{
+  static_assert(TFirst::randomAccess && TSecond::randomAccess, "zip requires random access views");
+
+public:
+
+  static constexpr bool randomAccess = true;
+
+  using reference  = std::pair<typename TFirst::reference, typename TSecond::reference>;
+  using value_type = std::pair<typename TFirst::value_type, typename TSecond::value_type>;
+
+  CLazyZip() = default;
+
+  CLazyZip(
+      const TFirst &  _first,
+      const TSecond & _second
+    )
+    : m_first (_first),
+      m_second(_second)
+  {
+  }
+
+  unsigned int size() const
+  {
+    return m_first.size() < m_second.size() ? m_first.size() : m_second.size();
+  }
+
+  reference at(
+      unsigned int _index
+    ) const
+  {
+    return reference(m_first.at(_index), m_second.at(_index));
+  }
+
+  template <typename TSink>
+  bool forEach(
+      TSink && _sink
+    ) const
+  {
+    const unsigned int count = size();
+    for (unsigned int index = 0; index < count; ++index)
+    {
+      if (!_sink(at(index)))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+
+  TFirst  m_first;
+  TSecond m_second;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CLazyEnumerate - пары (индекс, элемент)
+template <typename TBase>
+class CLazyEnumerate : public CLazyView<CLazyEnumerate<TBase>>
+{
+  using TBaseCursor = CLazyCursor<TBase>;
+
+public:
+
+  static constexpr bool randomAccess = TBase::randomAccess;
+
+  using reference   = std::pair<unsigned int, typename TBase::reference>;
+  using value_type  = std::pair<unsigned int, typename TBase::value_type>;
+  using cursor_type = std::pair<typename TBaseCursor::type, unsigned int>;
+
+  CLazyEnumerate() = default;
+
+  explicit CLazyEnumerate(
+      const TBase & _base
+    )
+    : m_base(_base)
+  {
+  }
+
+  template <typename TB = TBase, CLazyIfRandomAccess<TB> = 0>
+  unsigned int size() const                  { return m_base.size(); }
+
+  template <typename TB = TBase, CLazyIfRandomAccess<TB> = 0>
+  reference    at(unsigned int _index) const { return reference(_index, m_base.at(_index)); }
+
+  template <typename TSink>
+  bool forEach(
+      TSink && _sink
+    ) const
+  {
+    unsigned int index = 0;
+    return m_base.forEach([&index, &_sink](auto && _value)
+                          {
+                            return _sink(reference(index++, std::forward<decltype(_value)>(_value)));
+                          });
+  }
+
+  cursor_type cursorBegin() const                           { return cursor_type(TBaseCursor::begin(m_base), 0); }
+  bool        cursorDone(const cursor_type & _cursor) const { return TBaseCursor::done(m_base, _cursor.first); }
+  void        cursorNext(cursor_type & _cursor) const       { TBaseCursor::next(m_base, _cursor.first); ++_cursor.second; }
+
+  reference cursorRead(
+      const cursor_type & _cursor
+    ) const
+  {
+    return reference(_cursor.second, TBaseCursor::read(m_base, _cursor.first));
+  }
+
+private:
+
+  TBase m_base;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CLazySubrange - часть представления с произвольным доступом
+// (элемент chunk). Хранит копию представления, из которого получена,
+// поэтому остается действительной после разрушения chunk.
+template <typename TBase>
+class CLazySubrange : public CLazyView<CLazySubrange<TBase>>
+{
+public:
+
+  static constexpr bool randomAccess = true;
+
+  using reference  = typename TBase::reference;
+  using value_type = typename TBase::value_type;
+
+  CLazySubrange() = default;
+
+  CLazySubrange(
+      const TBase & _base,
+      unsigned int  _indexFrom,
+      unsigned int  _indexTo
+    )
+    : m_base     (_base),
+      m_indexFrom(_indexFrom),
+      m_indexTo  (_indexTo)
+  {
+  }
+
+  unsigned int size() const                  { return m_indexTo - m_indexFrom; }
+  reference    at(unsigned int _index) const { return m_base.at(m_indexFrom + _index); }
+
+  template <typename TSink>
+  bool forEach(
+      TSink && _sink
+    ) const
+  {
+    for (unsigned int index = m_indexFrom; index < m_indexTo; ++index)
+    {
+      if (!_sink(m_base.at(index)))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+
+  TBase        m_base;
+  unsigned int m_indexFrom = 0;
+  unsigned int m_indexTo   = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CLazyChunk - части представления по заданному количеству элементов
+template <typename TBase>
+class CLazyChunk : public CLazyView<CLazyChunk<TBase>>
+{
+  static_assert(TBase::randomAccess, "chunk requires a random access view");
+
+public:
+
+  static constexpr bool randomAccess = true;
+
+  using reference  = CLazySubrange<TBase>;
+  using value_type = CLazySubrange<TBase>;
+
+  CLazyChunk() = default;
+
+  CLazyChunk(
+      const TBase & _base,
+      unsigned int  _size
+    )
+    : m_base(_base),
+      m_size(_size ? _size : 1)
+  {
+  }
+
+  unsigned int size() const
+  {
+    return (m_base.size() + m_size - 1) / m_size;
+  }
+
+  reference at(
+      unsigned int _index
+    ) const
+  {
+    const unsigned int indexFrom = _index * m_size;
+    const unsigned int indexTo   = m_base.size() - indexFrom < m_size ? m_base.size() : indexFrom + m_size;
+
+    return reference(m_base, indexFrom, indexTo);
+  }
+
+  template <typename TSink>
+  bool forEach(
+      TSink && _sink
+    ) const
+  {
+    const unsigned int count = size();
+    for (unsigned int index = 0; index < count; ++index)
+    {
+      if (!_sink(at(index)))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+
+  TBase        m_base;
+  unsigned int m_size = 1;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CLazyStride - каждый n-й элемент
+template <typename TBase>
+class CLazyStride : public CLazyView<CLazyStride<TBase>>
+{
+  using TBaseCursor = CLazyCursor<TBase>;
+
+public:
+
+  static constexpr bool randomAccess = TBase::randomAccess;
+
+  using reference   = typename TBase::reference;
+  using value_type  = typename TBase::value_type;
+  using cursor_type = typename TBaseCursor::type;
+
+  CLazyStride() = default;
+
+  CLazyStride(
+      const TBase & _base,
+      unsigned int  _step
+    )
+    : m_base(_base),
+      m_step(_step ? _step : 1)
+  {
+  }
+
+  template <typename TB = TBase, CLazyIfRandomAccess<TB> = 0>
+  unsigned int size() const                  { return (m_base.size() + m_step - 1) / m_step; }
+
+  template <typename TB = TBase, CLazyIfRandomAccess<TB> = 0>
+  reference    at(unsigned int _index) const { return m_base.at(_index * m_step); }
+
+  template <typename TSink>
+  bool forEach(
+      TSink && _sink
+    ) const
+  {
+    if constexpr (TBase::randomAccess)
+    {
+      const unsigned int count = m_base.size();
+      for (unsigned int index = 0; index < count; index += m_step)
+      {
+        if (!_sink(m_base.at(index)))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+    else
+    {
+      unsigned int skipped = 0;
+      return m_base.forEach([this, &skipped, &_sink](auto && _value)
+                            {
+                              if (skipped)
+                              {
+                                skipped = skipped + 1 == m_step ? 0 : skipped + 1;
+                                return true;
+                              }
+
+                              skipped = m_step == 1 ? 0 : 1;
+                              return _sink(std::forward<decltype(_value)>(_value));
+                            });
+    }
+  }
+
+  cursor_type cursorBegin() const                           { return TBaseCursor::begin(m_base); }
+  bool        cursorDone(const cursor_type & _cursor) const { return TBaseCursor::done(m_base, _cursor); }
+  reference   cursorRead(const cursor_type & _cursor) const { return TBaseCursor::read(m_base, _cursor); }
+
+  void cursorNext(
+      cursor_type & _cursor
+    ) const
+  {
+    for (unsigned int step = 0; step < m_step && !TBaseCursor::done(m_base, _cursor); ++step)
+    {
+      TBaseCursor::next(m_base, _cursor);
+    }
+  }
+
+private:
+
+  TBase        m_base;
+  unsigned int m_step = 1;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CLazyTake - первые n элементов
+template <typename TBase>
+class CLazyTake : public CLazyView<CLazyTake<TBase>>
+{
+  using TBaseCursor = CLazyCursor<TBase>;
+
+public:
+
+  static constexpr bool randomAccess = TBase::randomAccess;
+
+  using reference   = typename TBase::reference;
+  using value_type  = typename TBase::value_type;
+  using cursor_type = std::pair<typename TBaseCursor::type, unsigned int>;
+
+  CLazyTake() = default;
+
+  CLazyTake(
+      const TBase & _base,
+      unsigned int  _count
+    )
+    : m_base (_base),
+      m_count(_count)
+  {
+  }
+
+  template <typename TB = TBase, CLazyIfRandomAccess<TB> = 0>
+  unsigned int size() const                  { return m_base.size() < m_count ? m_base.size() : m_count; }
+
+  template <typename TB = TBase, CLazyIfRandomAccess<TB> = 0>
+  reference    at(unsigned int _index) const { return m_base.at(_index); }
+
+  template <typename TSink>
+  bool forEach(
+      TSink && _sink
+    ) const
+  {
+    if (m_count == 0)
+    {
+      return true;
+    }
+
+    // Остановка по достижении количества - не прерывание обхода вызывающим
+    unsigned int left    = m_count;
+    bool         stopped = false;
+    m_base.forEach([&left, &stopped, &_sink](auto && _value)
+                   {
+                     if (!_sink(std::forward<decltype(_value)>(_value)))
+                     {
+                       stopped = true;
+                       return false;
+                     }
+                     return --left != 0;
+                   });
+    return !stopped;
+  }
+
+  cursor_type cursorBegin() const                           { return cursor_type(TBaseCursor::begin(m_base), 0); }
+  bool        cursorDone(const cursor_type & _cursor) const { return _cursor.second >= m_count || TBaseCursor::done(m_base, _cursor.first); }
+  void        cursorNext(cursor_type & _cursor) const       { TBaseCursor::next(m_base, _cursor.first); ++_cursor.second; }
+  reference   cursorRead(const cursor_type & _cursor) const { return TBaseCursor::read(m_base, _cursor.first); }
+
+private:
+
+  TBase        m_base;
+  unsigned int m_count = 0;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class CLazyDrop - все элементы, кроме первых n
+template <typename TBase>
+class CLazyDrop : public CLazyView<CLazyDrop<TBase>>
+{
+  using TBaseCursor = CLazyCursor<TBase>;
+
+public:
+
+  static constexpr bool randomAccess = TBase::randomAccess;
+
+  using reference   = typename TBase::reference;
+  using value_type  = typename TBase::value_type;
+  using cursor_type = typename TBaseCursor::type;
+
+  CLazyDrop() = default;
+
+  CLazyDrop(
+      const TBase & _base,
+      unsigned int  _count
+    )
+    : m_base (_base),
+      m_count(_count)
+  {
+  }
+
+  template <typename TB = TBase, CLazyIfRandomAccess<TB> = 0>
+  unsigned int size() const                  { return m_base.size() > m_count ? m_base.size() - m_count : 0; }
+
+  template <typename TB = TBase, CLazyIfRandomAccess<TB> = 0>
+  reference    at(unsigned int _index) const { return m_base.at(m_count + _index); }
+
+  template <typename TSink>
+  bool forEach(
+      TSink && _sink
+    ) const
+  {
+    if constexpr (TBase::randomAccess)
+    {
+      const unsigned int count = m_base.size();
+      for (unsigned int index = m_count; index < count; ++index)
+      {
+        if (!_sink(m_base.at(index)))
+        {
+          return false;
+        }
+      }
+      return true;
+    }
+    else
+    {
+      unsigned int skipped = 0;
+      return m_base.forEach([this, &skipped, &_sink](auto && _value)
+                            {
+                              if (skipped < m_count)
+                              {
+                                ++skipped;
+                                return true;
+                              }
+                              return _sink(std::forward<decltype(_value)>(_value));
+                            });
+    }
+  }
+
+  cursor_type cursorBegin() const
+  {
+    cursor_type cursor = TBaseCursor::begin(m_base);
+    for (unsigned int index = 0; index < m_count && !TBaseCursor::done(m_base, cursor); ++index)
+    {
+      TBaseCursor::next(m_base, cursor);
+    }
+    return cursor;
+  }
+
+  bool      cursorDone(const cursor_type & _cursor) const { return TBaseCursor::done(m_base, _cursor); }
+  void      cursorNext(cursor_type & _cursor) const       { TBaseCursor::next(m_base, _cursor); }
+  reference cursorRead(const cursor_type & _cursor) const { return TBaseCursor::read(m_base, _cursor); }
+
+private:
+
+  TBase        m_base;
+  unsigned int m_count = 0;
+};
+
+//----------------------------------------------------------------------------//
+// Начать цепочку представлений над массивом
+template <typename TArray>
+CLazySource<TArray> lazyView(
+    TArray & _array
+  )
+{
+  return CLazySource<TArray>(_array);
+}
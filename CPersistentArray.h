@@ -0,0 +1,1396 @@
+#pragma once
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <cassert>
+#include <atomic>
+#include <iterator>
+
+#include "CArray.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// class CPersistentArray - неизменяемый массив со структурным разделением
+// данных между версиями.
+//
+// Элементы хранятся в префиксном дереве с ветвлением 32 и буфером хвоста
+// (как PersistentVector в Clojure). Операции изменения возвращают новую
+// версию, которая разделяет с исходной все неизмененные узлы, поэтому
+// стоимость версии - O(log32 n) памяти вместо O(n).
+// Узлы имеют атомарный счетчик ссылок: узел, которым владеет единственная
+// версия, изменяется на месте (этим пользуется режим Transient).
+template <typename TData, typename TAllocator = std::allocator<TData>>
+class CPersistentArray
+{
+private:  // Типы
+
+  static constexpr unsigned int BranchBits  = 5;
+  static constexpr unsigned int BranchCount = 1u << BranchBits;
+  static constexpr unsigned int BranchMask  = BranchCount - 1;
+
+  struct Node
+  {
+    std::atomic<unsigned int> m_refCount { 1 };
+  };
+
+  struct InnerNode : Node
+  {
+    Node * m_children[BranchCount] = {};
+  };
+
+  struct LeafNode : Node
+  {
+    unsigned int m_count = 0;
+    typename std::aligned_storage<sizeof(TData), alignof(TData)>::type m_items[BranchCount];
+
+    TData * items();
+    const TData * items() const;
+  };
+
+  using TInnerAllocator = typename std::allocator_traits<TAllocator>::template rebind_alloc<InnerNode>;
+  using TLeafAllocator  = typename std::allocator_traits<TAllocator>::template rebind_alloc<LeafNode>;
+
+  // Состояние версии. Хранилище содержит элементы [m_offset, m_count),
+  // элементы до m_offset отброшены операцией drop().
+  struct State
+  {
+    InnerNode *  m_root   = nullptr;
+    LeafNode *   m_tail   = nullptr;
+    unsigned int m_count  = 0;
+    unsigned int m_offset = 0;
+    unsigned int m_shift  = BranchBits;
+
+    State() = default;
+
+    // Стать совладельцем узлов другого состояния
+    State(
+        const State & _other
+      );
+
+    State(
+        State && _other
+      );
+
+    ~State();
+
+    State & operator=(const State &) = delete;
+
+    void swap(
+        State & _other
+      );
+
+    void clear();
+
+    unsigned int size() const;
+
+    // Индекс в хранилище первого элемента хвоста
+    unsigned int tailOffset() const;
+
+    // Получить лист, содержащий элемент хранилища
+    const LeafNode * leafFor(
+        unsigned int _storageIndex
+      ) const;
+
+    const TData & at(
+        unsigned int _index
+      ) const;
+
+    void pushBack(
+        const TData & _value
+      );
+
+    void set(
+        unsigned int  _index,
+        const TData & _value
+      );
+
+    void popBack();
+
+    void take(
+        unsigned int _count
+      );
+
+    void drop(
+        unsigned int _count
+      );
+
+  private:
+
+    void pushTail(
+        InnerNode *& _node,
+        unsigned int _level,
+        LeafNode *   _leaf
+      );
+
+    void assocTree(
+        Node *&       _node,
+        unsigned int  _level,
+        unsigned int  _storageIndex,
+        const TData & _value
+      );
+
+    void popTail(
+        InnerNode *& _node,
+        unsigned int _level
+      );
+
+    // Снять лишние уровни дерева сверху
+    void collapseRoot();
+  };
+
+public: // Interface
+
+  class Transient;
+  class const_iterator;
+
+  // Конструктор по умолчанию
+  CPersistentArray();
+
+  // Копирующий конструктор (O(1), узлы разделяются)
+  CPersistentArray(
+      const CPersistentArray & _array
+    );
+
+  // Перемещающий конструктор
+  CPersistentArray(
+      CPersistentArray && _array
+    );
+
+  // Деструктор
+  ~CPersistentArray();
+
+  // Копирующее присваивание
+  CPersistentArray & operator=(
+      const CPersistentArray & _array
+    );
+
+  // Перемещающее присваивание
+  CPersistentArray & operator=(
+      CPersistentArray && _array
+    );
+
+  // Построить из обычного массива
+  template <typename TArrayAllocator, typename TArrayPolicy>
+  static CPersistentArray fromCArray(
+      const CArray<TData, TArrayAllocator, TArrayPolicy> & _array
+    );
+
+  // Скопировать элементы в обычный массив
+  template <typename TArray = CArray<TData>>
+  TArray toCArray() const;
+
+  // Получить версию с элементом, добавленным в конец
+  CPersistentArray push_back(
+      const TData & _value
+    ) const;
+
+  // Получить версию с замененным элементом
+  CPersistentArray set(
+      unsigned int  _index,
+      const TData & _value
+    ) const;
+
+  // Получить версию без последнего элемента
+  CPersistentArray pop_back() const;
+
+  // Получить версию из первых _count элементов
+  CPersistentArray take(
+      unsigned int _count
+    ) const;
+
+  // Получить версию без первых _count элементов.
+  // Пока версия жива, память отброшенного префикса в дереве не освобождается.
+  CPersistentArray drop(
+      unsigned int _count
+    ) const;
+
+  // Получить изменяемую копию для пакетного построения
+  Transient transient() const;
+
+  // Получить размер массива
+  unsigned int size() const;
+
+  // Определить что массив пустой
+  bool empty() const;
+
+  // Получить элемент массива по заданному индексу
+  const TData & operator[](
+      unsigned int _index
+    ) const;
+
+  const_iterator begin() const;
+  const_iterator end()   const;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // class Transient - изменяемая версия массива для пакетного построения.
+  // Узлы, созданные транзиентом, изменяются на месте; узлы, разделяемые с
+  // другими версиями, копируются при первом изменении.
+  class Transient
+  {
+    friend CPersistentArray;
+
+  public:
+
+    Transient();
+
+    Transient(
+        Transient && _other
+      );
+
+    ~Transient();
+
+    Transient & operator=(
+        Transient && _other
+      );
+
+    Transient(const Transient &) = delete;
+    Transient & operator=(const Transient &) = delete;
+
+    // Добавить элемент в конец
+    void push_back(
+        const TData & _value
+      );
+
+    // Заменить элемент по заданному индексу
+    void set(
+        unsigned int  _index,
+        const TData & _value
+      );
+
+    // Удалить последний элемент
+    void pop_back();
+
+    // Получить размер массива
+    unsigned int size() const;
+
+    // Получить элемент массива по заданному индексу
+    const TData & operator[](
+        unsigned int _index
+      ) const;
+
+    // Завершить построение. Транзиент становится пустым.
+    CPersistentArray persistent();
+
+  private:
+
+    State m_state;
+  };
+
+  /////////////////////////////////////////////////////////////////////////////
+  // class const_iterator - итератор, кэширующий текущий лист дерева
+  class const_iterator
+  {
+    friend CPersistentArray;
+
+  public:
+
+    // iterator traits
+    using difference_type   = int;
+    using value_type        = TData;
+    using pointer           = const TData *;
+    using reference         = const TData &;
+    using iterator_category = std::forward_iterator_tag;
+
+    const_iterator & operator++();
+    const_iterator   operator++(int);
+
+    bool operator==(
+        const const_iterator & _it
+      ) const;
+
+    bool operator!=(
+        const const_iterator & _it
+      ) const;
+
+    const TData & operator*() const;
+    const TData * operator->() const;
+
+  private:
+
+    const_iterator(
+        const State * _state,
+        unsigned int  _index
+      );
+
+    // Найти лист, содержащий текущий элемент
+    void seekLeaf();
+
+    const State * m_state     = nullptr;
+    unsigned int  m_index     = 0;    //< Индекс в хранилище (с учетом смещения)
+    unsigned int  m_leafBase  = 0;    //< Индекс первого элемента текущего листа
+    unsigned int  m_leafCount = 0;    //< Количество элементов текущего листа
+    const TData * m_leafItems = nullptr;
+  };
+
+private:  // Методы работы с узлами
+
+  static LeafNode * newLeaf();
+  static InnerNode * newInner();
+
+  // Создать цепочку внутренних узлов до листа
+  static Node * newPath(
+      unsigned int _level,
+      Node *       _node
+    );
+
+  static void addRef(
+      Node * _node
+    );
+
+  // Отпустить узел, уровень _level определяет тип узла (0 - лист)
+  static void release(
+      Node *       _node,
+      unsigned int _level
+    );
+
+  // Скопировать первые _count элементов листа
+  static LeafNode * cloneLeaf(
+      const LeafNode * _leaf,
+      unsigned int     _count
+    );
+
+  static InnerNode * cloneInner(
+      const InnerNode * _node
+    );
+
+  // Обеспечить единоличное владение узлом перед изменением
+  static void makeUnique(
+      LeafNode *& _leaf
+    );
+
+  static void makeUnique(
+      InnerNode *& _node,
+      unsigned int _level
+    );
+
+  // Построить копию поддерева, содержащую первые _limit элементов
+  static InnerNode * trimTree(
+      const InnerNode * _node,
+      unsigned int      _level,
+      unsigned int      _limit
+    );
+
+private:  // Attributes
+
+  State m_state;
+};
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>::CPersistentArray()
+{
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>::CPersistentArray(
+    const CPersistentArray & _array
+  )
+  : m_state(_array.m_state)
+{
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>::CPersistentArray(
+    CPersistentArray && _array
+  )
+  : m_state(std::move(_array.m_state))
+{
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>::~CPersistentArray()
+{
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>&
+CPersistentArray<TData, TAllocator>::operator=(
+    const CPersistentArray & _array
+  )
+{
+  if (this != &_array)
+  {
+    State tmp(_array.m_state);
+    m_state.swap(tmp);
+  }
+
+  return *this;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>&
+CPersistentArray<TData, TAllocator>::operator=(
+    CPersistentArray && _array
+  )
+{
+  if (this != &_array)
+  {
+    State tmp(std::move(_array.m_state));
+    m_state.swap(tmp);
+  }
+
+  return *this;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+template <typename TArrayAllocator, typename TArrayPolicy>
+CPersistentArray<TData, TAllocator>
+CPersistentArray<TData, TAllocator>::fromCArray(
+    const CArray<TData, TArrayAllocator, TArrayPolicy> & _array
+  )
+{
+  Transient builder;
+  for (unsigned int index = 0, count = _array.size(); index < count; ++index)
+  {
+    builder.push_back(_array[index]);
+  }
+
+  return builder.persistent();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+template <typename TArray>
+TArray
+CPersistentArray<TData, TAllocator>::toCArray() const
+{
+  TArray result;
+  for (const auto & item : *this)
+  {
+    result.push_back(item);
+  }
+
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>
+CPersistentArray<TData, TAllocator>::push_back(
+    const TData & _value
+  ) const
+{
+  CPersistentArray result(*this);
+  result.m_state.pushBack(_value);
+
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>
+CPersistentArray<TData, TAllocator>::set(
+    unsigned int  _index,
+    const TData & _value
+  ) const
+{
+  CPersistentArray result(*this);
+  result.m_state.set(_index, _value);
+
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>
+CPersistentArray<TData, TAllocator>::pop_back() const
+{
+  CPersistentArray result(*this);
+  result.m_state.popBack();
+
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>
+CPersistentArray<TData, TAllocator>::take(
+    unsigned int _count
+  ) const
+{
+  CPersistentArray result(*this);
+  result.m_state.take(_count);
+
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>
+CPersistentArray<TData, TAllocator>::drop(
+    unsigned int _count
+  ) const
+{
+  CPersistentArray result(*this);
+  result.m_state.drop(_count);
+
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CPersistentArray<TData, TAllocator>::Transient
+CPersistentArray<TData, TAllocator>::transient() const
+{
+  Transient result;
+
+  State tmp(m_state);
+  result.m_state.swap(tmp);
+
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+unsigned int
+CPersistentArray<TData, TAllocator>::size() const
+{
+  return m_state.size();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+bool
+CPersistentArray<TData, TAllocator>::empty() const
+{
+  return m_state.size() == 0;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+const TData &
+CPersistentArray<TData, TAllocator>::operator[](
+    unsigned int _index
+  ) const
+{
+  return m_state.at(_index);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CPersistentArray<TData, TAllocator>::const_iterator
+CPersistentArray<TData, TAllocator>::begin() const
+{
+  return const_iterator(&m_state, m_state.m_offset);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CPersistentArray<TData, TAllocator>::const_iterator
+CPersistentArray<TData, TAllocator>::end() const
+{
+  return const_iterator(&m_state, m_state.m_count);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>::Transient::Transient()
+{
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>::Transient::Transient(
+    Transient && _other
+  )
+  : m_state(std::move(_other.m_state))
+{
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>::Transient::~Transient()
+{
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CPersistentArray<TData, TAllocator>::Transient &
+CPersistentArray<TData, TAllocator>::Transient::operator=(
+    Transient && _other
+  )
+{
+  if (this != &_other)
+  {
+    State tmp(std::move(_other.m_state));
+    m_state.swap(tmp);
+  }
+
+  return *this;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::Transient::push_back(
+    const TData & _value
+  )
+{
+  m_state.pushBack(_value);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::Transient::set(
+    unsigned int  _index,
+    const TData & _value
+  )
+{
+  m_state.set(_index, _value);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::Transient::pop_back()
+{
+  m_state.popBack();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+unsigned int
+CPersistentArray<TData, TAllocator>::Transient::size() const
+{
+  return m_state.size();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+const TData &
+CPersistentArray<TData, TAllocator>::Transient::operator[](
+    unsigned int _index
+  ) const
+{
+  return m_state.at(_index);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>
+CPersistentArray<TData, TAllocator>::Transient::persistent()
+{
+  CPersistentArray result;
+  result.m_state.swap(m_state);
+
+  return result;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>::const_iterator::const_iterator(
+    const State * _state,
+    unsigned int  _index
+  )
+  : m_state(_state),
+    m_index(_index)
+{
+  seekLeaf();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::const_iterator::seekLeaf()
+{
+  if (m_index < m_state->m_count)
+  {
+    const LeafNode * leaf = m_state->leafFor(m_index);
+
+    m_leafBase  = m_index & ~BranchMask;
+    m_leafCount = leaf->m_count;
+    m_leafItems = leaf->items();
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CPersistentArray<TData, TAllocator>::const_iterator &
+CPersistentArray<TData, TAllocator>::const_iterator::operator++()
+{
+  ++m_index;
+  if (m_index - m_leafBase >= m_leafCount)
+  {
+    seekLeaf();
+  }
+
+  return *this;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CPersistentArray<TData, TAllocator>::const_iterator
+CPersistentArray<TData, TAllocator>::const_iterator::operator++(
+    int
+  )
+{
+  const_iterator tmp(*this);
+  operator++();
+  return tmp;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+bool
+CPersistentArray<TData, TAllocator>::const_iterator::operator==(
+    const const_iterator & _it
+  ) const
+{
+  return m_state == _it.m_state && m_index == _it.m_index;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+bool
+CPersistentArray<TData, TAllocator>::const_iterator::operator!=(
+    const const_iterator & _it
+  ) const
+{
+  return !operator==(_it);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+const TData &
+CPersistentArray<TData, TAllocator>::const_iterator::operator*() const
+{
+  return m_leafItems[m_index - m_leafBase];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+const TData *
+CPersistentArray<TData, TAllocator>::const_iterator::operator->() const
+{
+  return m_leafItems + (m_index - m_leafBase);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+TData *
+CPersistentArray<TData, TAllocator>::LeafNode::items()
+{
+  return reinterpret_cast<TData *>(m_items);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+const TData *
+CPersistentArray<TData, TAllocator>::LeafNode::items() const
+{
+  return reinterpret_cast<const TData *>(m_items);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>::State::State(
+    const State & _other
+  )
+  : m_root  (_other.m_root),
+    m_tail  (_other.m_tail),
+    m_count (_other.m_count),
+    m_offset(_other.m_offset),
+    m_shift (_other.m_shift)
+{
+  addRef(m_root);
+  addRef(m_tail);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>::State::State(
+    State && _other
+  )
+{
+  swap(_other);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CPersistentArray<TData, TAllocator>::State::~State()
+{
+  clear();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::State::swap(
+    State & _other
+  )
+{
+  std::swap(m_root,   _other.m_root);
+  std::swap(m_tail,   _other.m_tail);
+  std::swap(m_count,  _other.m_count);
+  std::swap(m_offset, _other.m_offset);
+  std::swap(m_shift,  _other.m_shift);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::State::clear()
+{
+  release(m_root, m_shift);
+  release(m_tail, 0);
+
+  m_root   = nullptr;
+  m_tail   = nullptr;
+  m_count  = 0;
+  m_offset = 0;
+  m_shift  = BranchBits;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+unsigned int
+CPersistentArray<TData, TAllocator>::State::size() const
+{
+  return m_count - m_offset;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+unsigned int
+CPersistentArray<TData, TAllocator>::State::tailOffset() const
+{
+  return m_count < BranchCount ? 0 : ((m_count - 1) >> BranchBits) << BranchBits;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+const typename CPersistentArray<TData, TAllocator>::LeafNode *
+CPersistentArray<TData, TAllocator>::State::leafFor(
+    unsigned int _storageIndex
+  ) const
+{
+  assert(_storageIndex < m_count);
+
+  if (_storageIndex >= tailOffset())
+  {
+    return m_tail;
+  }
+
+  const Node * node = m_root;
+  for (unsigned int level = m_shift; level > 0; level -= BranchBits)
+  {
+    node = static_cast<const InnerNode *>(node)->m_children[(_storageIndex >> level) & BranchMask];
+  }
+
+  return static_cast<const LeafNode *>(node);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+const TData &
+CPersistentArray<TData, TAllocator>::State::at(
+    unsigned int _index
+  ) const
+{
+  assert(_index < size());
+
+  const unsigned int storageIndex = _index + m_offset;
+
+  return leafFor(storageIndex)->items()[storageIndex & BranchMask];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::State::pushBack(
+    const TData & _value
+  )
+{
+  if (m_tail == nullptr)
+  {
+    m_tail = newLeaf();
+  }
+  else if (m_count - tailOffset() == BranchCount)
+  {
+    // Хвост заполнен - переносим его в дерево
+    LeafNode * fullTail = m_tail;
+    m_tail = newLeaf();
+
+    if (m_root == nullptr)
+    {
+      m_root = newInner();
+    }
+
+    if ((m_count >> BranchBits) > (1u << m_shift))
+    {
+      // Дерево заполнено - добавляем уровень
+      InnerNode * newRoot = newInner();
+      newRoot->m_children[0] = m_root;
+      newRoot->m_children[1] = newPath(m_shift, fullTail);
+
+      m_root   = newRoot;
+      m_shift += BranchBits;
+    }
+    else
+    {
+      pushTail(m_root, m_shift, fullTail);
+    }
+  }
+  else
+  {
+    makeUnique(m_tail);
+  }
+
+  new (m_tail->items() + m_tail->m_count) TData(_value);
+  ++m_tail->m_count;
+  ++m_count;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::State::pushTail(
+    InnerNode *& _node,
+    unsigned int _level,
+    LeafNode *   _leaf
+  )
+{
+  makeUnique(_node, _level);
+
+  const unsigned int subIndex = ((m_count - 1) >> _level) & BranchMask;
+  Node *& child = _node->m_children[subIndex];
+
+  if (_level == BranchBits)
+  {
+    assert(child == nullptr);
+    child = _leaf;
+  }
+  else if (child)
+  {
+    InnerNode * inner = static_cast<InnerNode *>(child);
+    pushTail(inner, _level - BranchBits, _leaf);
+    child = inner;
+  }
+  else
+  {
+    child = newPath(_level - BranchBits, _leaf);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::State::set(
+    unsigned int  _index,
+    const TData & _value
+  )
+{
+  assert(_index < size());
+
+  const unsigned int storageIndex = _index + m_offset;
+  if (storageIndex >= tailOffset())
+  {
+    makeUnique(m_tail);
+    m_tail->items()[storageIndex & BranchMask] = _value;
+  }
+  else
+  {
+    Node * root = m_root;
+    assocTree(root, m_shift, storageIndex, _value);
+    m_root = static_cast<InnerNode *>(root);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::State::assocTree(
+    Node *&       _node,
+    unsigned int  _level,
+    unsigned int  _storageIndex,
+    const TData & _value
+  )
+{
+  if (_level == 0)
+  {
+    LeafNode * leaf = static_cast<LeafNode *>(_node);
+    makeUnique(leaf);
+    leaf->items()[_storageIndex & BranchMask] = _value;
+    _node = leaf;
+  }
+  else
+  {
+    InnerNode * inner = static_cast<InnerNode *>(_node);
+    makeUnique(inner, _level);
+    assocTree(inner->m_children[(_storageIndex >> _level) & BranchMask], _level - BranchBits, _storageIndex, _value);
+    _node = inner;
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::State::popBack()
+{
+  assert(size() > 0);
+
+  if (size() == 1)
+  {
+    clear();
+  }
+  else if (m_count - tailOffset() > 1)
+  {
+    makeUnique(m_tail);
+    --m_tail->m_count;
+    m_tail->items()[m_tail->m_count].~TData();
+    --m_count;
+  }
+  else
+  {
+    // В хвосте последний элемент - хвостом становится последний лист дерева
+    LeafNode * newTail = const_cast<LeafNode *>(leafFor(m_count - 2));
+    addRef(newTail);
+    release(m_tail, 0);
+    m_tail = newTail;
+
+    popTail(m_root, m_shift);
+    --m_count;
+
+    collapseRoot();
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::State::popTail(
+    InnerNode *& _node,
+    unsigned int _level
+  )
+{
+  makeUnique(_node, _level);
+
+  const unsigned int subIndex = ((m_count - 2) >> _level) & BranchMask;
+  Node *& child = _node->m_children[subIndex];
+
+  if (_level > BranchBits)
+  {
+    InnerNode * inner = static_cast<InnerNode *>(child);
+    popTail(inner, _level - BranchBits);
+    child = inner;
+  }
+  else
+  {
+    release(child, 0);
+    child = nullptr;
+  }
+
+  if (child == nullptr && subIndex == 0)
+  {
+    release(_node, _level);
+    _node = nullptr;
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::State::collapseRoot()
+{
+  while (m_root && m_shift > BranchBits && m_root->m_children[1] == nullptr)
+  {
+    InnerNode * child = static_cast<InnerNode *>(m_root->m_children[0]);
+    addRef(child);
+    release(m_root, m_shift);
+
+    m_root   = child;
+    m_shift -= BranchBits;
+  }
+
+  if (m_root == nullptr)
+  {
+    m_shift = BranchBits;
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::State::take(
+    unsigned int _count
+  )
+{
+  if (_count >= size())
+  {
+    return;
+  }
+
+  if (_count == 0)
+  {
+    clear();
+    return;
+  }
+
+  const unsigned int newCount      = m_offset + _count;
+  const unsigned int newTailOffset = newCount < BranchCount ? 0 : ((newCount - 1) >> BranchBits) << BranchBits;
+
+  if (newTailOffset == tailOffset())
+  {
+    makeUnique(m_tail);
+    while (m_tail->m_count > newCount - newTailOffset)
+    {
+      --m_tail->m_count;
+      m_tail->items()[m_tail->m_count].~TData();
+    }
+  }
+  else
+  {
+    const LeafNode * leaf = leafFor(newTailOffset);
+
+    LeafNode * newTail = nullptr;
+    if (newCount - newTailOffset == BranchCount)
+    {
+      newTail = const_cast<LeafNode *>(leaf);
+      addRef(newTail);
+    }
+    else
+    {
+      newTail = cloneLeaf(leaf, newCount - newTailOffset);
+    }
+
+    InnerNode * newRoot = newTailOffset ? trimTree(m_root, m_shift, newTailOffset) : nullptr;
+
+    release(m_tail, 0);
+    release(m_root, m_shift);
+
+    m_tail = newTail;
+    m_root = newRoot;
+  }
+
+  m_count = newCount;
+  collapseRoot();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::State::drop(
+    unsigned int _count
+  )
+{
+  if (_count >= size())
+  {
+    clear();
+    return;
+  }
+
+  m_offset += _count;
+
+  const unsigned int firstTailIndex = tailOffset();
+  if (m_root && m_offset >= firstTailIndex)
+  {
+    // Остались только элементы хвоста - дерево больше не нужно
+    State rest;
+    rest.m_tail = newLeaf();
+    for (unsigned int index = m_offset; index < m_count; ++index)
+    {
+      new (rest.m_tail->items() + rest.m_tail->m_count) TData(m_tail->items()[index - firstTailIndex]);
+      ++rest.m_tail->m_count;
+    }
+    rest.m_count = rest.m_tail->m_count;
+
+    swap(rest);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CPersistentArray<TData, TAllocator>::LeafNode *
+CPersistentArray<TData, TAllocator>::newLeaf()
+{
+  TLeafAllocator allocator;
+  return new (allocator.allocate(1)) LeafNode();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CPersistentArray<TData, TAllocator>::InnerNode *
+CPersistentArray<TData, TAllocator>::newInner()
+{
+  TInnerAllocator allocator;
+  return new (allocator.allocate(1)) InnerNode();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CPersistentArray<TData, TAllocator>::Node *
+CPersistentArray<TData, TAllocator>::newPath(
+    unsigned int _level,
+    Node *       _node
+  )
+{
+  if (_level == 0)
+  {
+    return _node;
+  }
+
+  InnerNode * inner = newInner();
+  inner->m_children[0] = newPath(_level - BranchBits, _node);
+
+  return inner;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::addRef(
+    Node * _node
+  )
+{
+  if (_node)
+  {
+    _node->m_refCount.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::release(
+    Node *       _node,
+    unsigned int _level
+  )
+{
+  if (_node == nullptr || _node->m_refCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+  {
+    return;
+  }
+
+  if (_level == 0)
+  {
+    LeafNode * leaf = static_cast<LeafNode *>(_node);
+    if constexpr (!std::is_trivially_destructible<TData>::value)
+    {
+      for (unsigned int index = 0; index < leaf->m_count; ++index)
+      {
+        leaf->items()[index].~TData();
+      }
+    }
+
+    leaf->~LeafNode();
+    TLeafAllocator allocator;
+    allocator.deallocate(leaf, 1);
+  }
+  else
+  {
+    InnerNode * inner = static_cast<InnerNode *>(_node);
+    for (Node * child : inner->m_children)
+    {
+      release(child, _level - BranchBits);
+    }
+
+    inner->~InnerNode();
+    TInnerAllocator allocator;
+    allocator.deallocate(inner, 1);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CPersistentArray<TData, TAllocator>::LeafNode *
+CPersistentArray<TData, TAllocator>::cloneLeaf(
+    const LeafNode * _leaf,
+    unsigned int     _count
+  )
+{
+  LeafNode * leaf = newLeaf();
+  for ( ; leaf->m_count < _count; ++leaf->m_count)
+  {
+    new (leaf->items() + leaf->m_count) TData(_leaf->items()[leaf->m_count]);
+  }
+
+  return leaf;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CPersistentArray<TData, TAllocator>::InnerNode *
+CPersistentArray<TData, TAllocator>::cloneInner(
+    const InnerNode * _node
+  )
+{
+  InnerNode * inner = newInner();
+  for (unsigned int index = 0; index < BranchCount; ++index)
+  {
+    inner->m_children[index] = _node->m_children[index];
+    addRef(inner->m_children[index]);
+  }
+
+  return inner;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::makeUnique(
+    LeafNode *& _leaf
+  )
+{
+  if (_leaf->m_refCount.load(std::memory_order_acquire) != 1)
+  {
+    LeafNode * copy = cloneLeaf(_leaf, _leaf->m_count);
+    release(_leaf, 0);
+    _leaf = copy;
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CPersistentArray<TData, TAllocator>::makeUnique(
+    InnerNode *& _node,
+    unsigned int _level
+  )
+{
+  if (_node->m_refCount.load(std::memory_order_acquire) != 1)
+  {
+    InnerNode * copy = cloneInner(_node);
+    release(_node, _level);
+    _node = copy;
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CPersistentArray<TData, TAllocator>::InnerNode *
+CPersistentArray<TData, TAllocator>::trimTree(
+    const InnerNode * _node,
+    unsigned int      _level,
+    unsigned int      _limit
+  )
+{
+  const unsigned int lastIndex = ((_limit - 1) >> _level) & BranchMask;
+
+  InnerNode * inner = newInner();
+  for (unsigned int index = 0; index < lastIndex; ++index)
+  {
+    inner->m_children[index] = _node->m_children[index];
+    addRef(inner->m_children[index]);
+  }
+
+  Node * lastChild = _node->m_children[lastIndex];
+  if (_level == BranchBits)
+  {
+    // Листья дерева всегда заполнены, т.к. _limit кратен размеру листа
+    addRef(lastChild);
+    inner->m_children[lastIndex] = lastChild;
+  }
+  else
+  {
+    inner->m_children[lastIndex] = trimTree(static_cast<const InnerNode *>(lastChild), _level - BranchBits, _limit);
+  }
+
+  return inner;
+}
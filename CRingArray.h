@@ -0,0 +1,781 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+#include <cassert>
+#include <cstring>
+
+#include "CArrayView.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// class CRingArray - массив в кольцевом буфере с добавлением и удалением
+// с обоих концов за O(1).
+//
+// Емкость буфера - степень двойки, элемент с индексом i находится
+// в ячейке (head + i) & (capacity - 1). При росте кольцо разворачивается
+// в новый буфер двумя переносами: от head до конца буфера и от начала
+// буфера до хвоста. as_spans() возвращает те же два непрерывных участка
+// для обработки без проверки переноса на каждом элементе.
+template <typename TData, typename TAllocator = std::allocator<TData>>
+class CRingArray
+{
+public: // Interface
+
+  template <typename TArray, typename TItem>
+  class iterator_base;
+
+  using iterator       = iterator_base<CRingArray, TData>;
+  using const_iterator = iterator_base<const CRingArray, const TData>;
+
+  // Конструктор по умолчанию
+  CRingArray() = default;
+
+  // Копирующий конструктор
+  CRingArray(
+      const CRingArray & _array
+    );
+
+  // Перемещающий конструктор
+  CRingArray(
+      CRingArray && _array
+    );
+
+  // Деструктор
+  ~CRingArray();
+
+  // Копирующее присваивание
+  CRingArray & operator=(
+      const CRingArray & _array
+    );
+
+  // Перемещающее присваивание
+  CRingArray & operator=(
+      CRingArray && _array
+    );
+
+  // Добавить элемент в конец массива
+  void push_back(
+      const TData & _value
+    );
+
+  void push_back(
+      TData && _value
+    );
+
+  // Добавить элемент в начало массива
+  void push_front(
+      const TData & _value
+    );
+
+  void push_front(
+      TData && _value
+    );
+
+  // Сконструировать элемент в конце массива
+  template <class... Args>
+  TData & emplace_back(
+      Args&&... args
+    );
+
+  // Сконструировать элемент в начале массива
+  template <class... Args>
+  TData & emplace_front(
+      Args&&... args
+    );
+
+  // Удалить первый элемент
+  void pop_front();
+
+  // Удалить последний элемент
+  void pop_back();
+
+  // Очистить массив (емкость сохраняется)
+  void clear();
+
+  // Зарезервировать память под заданное количество элементов
+  void reserve(
+      unsigned int _capacity
+    );
+
+  // Получить размер массива
+  unsigned int size() const;
+
+  // Получить количество элементов, под которые выделена память
+  unsigned int capacity() const;
+
+  // Определить что массив пустой
+  bool empty() const;
+
+  // Получить элемент массива по заданному индексу
+  TData & operator[](
+      unsigned int _index
+    );
+
+  const TData & operator[](
+      unsigned int _index
+    ) const;
+
+  TData &       front();
+  const TData & front() const;
+  TData &       back();
+  const TData & back() const;
+
+  // Получить два непрерывных участка, составляющих массив по порядку
+  // (второй пустой, если кольцо не перенесено через конец буфера).
+  // Участки действительны до следующего изменения размера массива.
+  std::pair<CArraySlice<TData>, CArraySlice<TData>> as_spans();
+
+  std::pair<CArrayView<TData>, CArrayView<TData>> as_spans() const;
+
+  iterator        begin();
+  const_iterator  begin()  const;
+  const_iterator  cbegin() const;
+  iterator        end();
+  const_iterator  end()    const;
+  const_iterator  cend()   const;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Итератор по элементам массива
+  template <typename TArray, typename TItem>
+  class iterator_base
+  {
+  public:
+
+    // iterator traits
+    using difference_type   = int;
+    using value_type        = std::remove_cv_t<TItem>;
+    using pointer           = TItem *;
+    using reference         = TItem &;
+    using iterator_category = std::random_access_iterator_tag;
+
+    iterator_base() = default;
+
+    iterator_base(
+        TArray *     _array,
+        unsigned int _index
+      )
+      : m_array(_array),
+        m_index(_index)
+    {
+    }
+
+    // Преобразование iterator в const_iterator
+    operator iterator_base<const CRingArray, const TData>() const
+    {
+      return iterator_base<const CRingArray, const TData>(m_array, m_index);
+    }
+
+    TItem & operator*() const              { return (*m_array)[m_index]; }
+    TItem * operator->() const             { return &(*m_array)[m_index]; }
+    TItem & operator[](int _offset) const  { return (*m_array)[m_index + _offset]; }
+
+    iterator_base & operator++()    { ++m_index; return *this; }
+    iterator_base & operator--()    { --m_index; return *this; }
+    iterator_base   operator++(int) { iterator_base tmp(*this); ++m_index; return tmp; }
+    iterator_base   operator--(int) { iterator_base tmp(*this); --m_index; return tmp; }
+
+    iterator_base & operator+=(int _offset)      { m_index += _offset; return *this; }
+    iterator_base & operator-=(int _offset)      { m_index -= _offset; return *this; }
+    iterator_base   operator+(int _offset) const { return iterator_base(m_array, m_index + _offset); }
+    iterator_base   operator-(int _offset) const { return iterator_base(m_array, m_index - _offset); }
+
+    friend iterator_base operator+(int _offset, const iterator_base & _it) { return _it + _offset; }
+
+    int operator-(const iterator_base & _it) const { return static_cast<int>(m_index - _it.m_index); }
+
+    bool operator==(const iterator_base & _it) const { return m_index == _it.m_index; }
+    bool operator!=(const iterator_base & _it) const { return m_index != _it.m_index; }
+    bool operator< (const iterator_base & _it) const { return m_index <  _it.m_index; }
+    bool operator> (const iterator_base & _it) const { return m_index >  _it.m_index; }
+    bool operator<=(const iterator_base & _it) const { return m_index <= _it.m_index; }
+    bool operator>=(const iterator_base & _it) const { return m_index >= _it.m_index; }
+
+  private:
+
+    TArray *     m_array = nullptr;
+    unsigned int m_index = 0;
+  };
+
+protected:  // Методы
+
+  using TTraits = std::allocator_traits<TAllocator>;
+
+  // Минимальная емкость буфера
+  static constexpr unsigned int MinCapacity = 8;
+
+  // Получить ячейку буфера элемента с индексом _index
+  unsigned int slotOf(
+      unsigned int _index
+    ) const;
+
+  // Перенести элементы в новый буфер емкостью _capacity, начиная с ячейки
+  // _firstSlot, и освободить старый буфер. При исключении массив
+  // не изменяется, новый буфер освобождает вызывающий.
+  void relocateTo(
+      TData *      _buf,
+      unsigned int _capacity,
+      unsigned int _firstSlot
+    );
+
+  // Создать в неинициализированной памяти _pTarget перемещенные (или
+  // скопированные, если перемещение может выбросить исключение) _count
+  // элементов _pSource. Исходные элементы не разрушаются; при исключении
+  // созданные элементы разрушаются.
+  void relocateRange(
+      TData *      _pTarget,
+      TData *      _pSource,
+      unsigned int _count
+    );
+
+  // Разрушить _count элементов, начиная с _pItems
+  void destroyRange(
+      TData *      _pItems,
+      unsigned int _count
+    );
+
+  // Удалить элементы и освободить буфер
+  void destroy();
+
+protected: // Attributes
+
+  TAllocator   m_allocator;
+  TData *      m_buf      = nullptr;
+  unsigned int m_capacity = 0;        //< Емкость буфера (степень двойки или 0)
+  unsigned int m_head     = 0;        //< Ячейка первого элемента
+  unsigned int m_size     = 0;
+};
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CRingArray<TData, TAllocator>::CRingArray(
+    const CRingArray & _array
+  )
+{
+  reserve(_array.m_size);
+  for (unsigned int index = 0; index < _array.m_size; ++index)
+  {
+    push_back(_array[index]);
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CRingArray<TData, TAllocator>::CRingArray(
+    CRingArray && _array
+  )
+  : m_allocator(std::move(_array.m_allocator)),
+    m_buf      (std::exchange(_array.m_buf, nullptr)),
+    m_capacity (std::exchange(_array.m_capacity, 0)),
+    m_head     (std::exchange(_array.m_head, 0)),
+    m_size     (std::exchange(_array.m_size, 0))
+{
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CRingArray<TData, TAllocator>::~CRingArray()
+{
+  destroy();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CRingArray<TData, TAllocator> &
+CRingArray<TData, TAllocator>::operator=(
+    const CRingArray & _array
+  )
+{
+  if (this != &_array)
+  {
+    CRingArray tmp(_array);
+    *this = std::move(tmp);
+  }
+
+  return *this;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+CRingArray<TData, TAllocator> &
+CRingArray<TData, TAllocator>::operator=(
+    CRingArray && _array
+  )
+{
+  if (this != &_array)
+  {
+    destroy();
+
+    m_allocator = std::move(_array.m_allocator);
+    m_buf       = std::exchange(_array.m_buf, nullptr);
+    m_capacity  = std::exchange(_array.m_capacity, 0);
+    m_head      = std::exchange(_array.m_head, 0);
+    m_size      = std::exchange(_array.m_size, 0);
+  }
+
+  return *this;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CRingArray<TData, TAllocator>::push_back(
+    const TData & _value
+  )
+{
+  emplace_back(_value);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CRingArray<TData, TAllocator>::push_back(
+    TData && _value
+  )
+{
+  emplace_back(std::move(_value));
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CRingArray<TData, TAllocator>::push_front(
+    const TData & _value
+  )
+{
+  emplace_front(_value);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CRingArray<TData, TAllocator>::push_front(
+    TData && _value
+  )
+{
+  emplace_front(std::move(_value));
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+template <class... Args>
+TData &
+CRingArray<TData, TAllocator>::emplace_back(
+    Args&&... args
+  )
+{
+  if (m_size < m_capacity)
+  {
+    TData * const pItem = m_buf + slotOf(m_size);
+    TTraits::construct(m_allocator, pItem, std::forward<Args>(args)...);
+    ++m_size;
+    return *pItem;
+  }
+
+  // Новый элемент создается в новом буфере до переноса старых: аргументы
+  // могут ссылаться на элементы массива
+  const unsigned int capacity = std::max(MinCapacity, m_capacity * 2);
+  TData * const      buf      = TTraits::allocate(m_allocator, capacity);
+  try
+  {
+    TTraits::construct(m_allocator, buf + m_size, std::forward<Args>(args)...);
+  }
+  catch (...)
+  {
+    TTraits::deallocate(m_allocator, buf, capacity);
+    throw;
+  }
+
+  try
+  {
+    relocateTo(buf, capacity, 0);
+  }
+  catch (...)
+  {
+    TTraits::destroy(m_allocator, buf + m_size);
+    TTraits::deallocate(m_allocator, buf, capacity);
+    throw;
+  }
+  ++m_size;
+  return m_buf[m_size - 1];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+template <class... Args>
+TData &
+CRingArray<TData, TAllocator>::emplace_front(
+    Args&&... args
+  )
+{
+  if (m_size < m_capacity)
+  {
+    const unsigned int head  = (m_head - 1) & (m_capacity - 1);
+    TData * const      pItem = m_buf + head;
+    TTraits::construct(m_allocator, pItem, std::forward<Args>(args)...);
+    m_head = head;
+    ++m_size;
+    return *pItem;
+  }
+
+  // Новый элемент занимает последнюю ячейку нового буфера, старые
+  // переносятся в его начало
+  const unsigned int capacity = std::max(MinCapacity, m_capacity * 2);
+  TData * const      buf      = TTraits::allocate(m_allocator, capacity);
+  try
+  {
+    TTraits::construct(m_allocator, buf + capacity - 1, std::forward<Args>(args)...);
+  }
+  catch (...)
+  {
+    TTraits::deallocate(m_allocator, buf, capacity);
+    throw;
+  }
+
+  try
+  {
+    relocateTo(buf, capacity, 0);
+  }
+  catch (...)
+  {
+    TTraits::destroy(m_allocator, buf + capacity - 1);
+    TTraits::deallocate(m_allocator, buf, capacity);
+    throw;
+  }
+  m_head = capacity - 1;
+  ++m_size;
+  return m_buf[m_head];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CRingArray<TData, TAllocator>::pop_front()
+{
+  assert(m_size > 0);
+
+  TTraits::destroy(m_allocator, m_buf + m_head);
+  m_head = (m_head + 1) & (m_capacity - 1);
+  --m_size;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CRingArray<TData, TAllocator>::pop_back()
+{
+  assert(m_size > 0);
+
+  TTraits::destroy(m_allocator, m_buf + slotOf(m_size - 1));
+  --m_size;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CRingArray<TData, TAllocator>::clear()
+{
+  while (m_size)
+  {
+    pop_back();
+  }
+  m_head = 0;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CRingArray<TData, TAllocator>::reserve(
+    unsigned int _capacity
+  )
+{
+  if (_capacity <= m_capacity)
+  {
+    return;
+  }
+
+  unsigned int capacity = MinCapacity;
+  while (capacity < _capacity)
+  {
+    capacity *= 2;
+  }
+
+  TData * const buf = TTraits::allocate(m_allocator, capacity);
+  try
+  {
+    relocateTo(buf, capacity, 0);
+  }
+  catch (...)
+  {
+    TTraits::deallocate(m_allocator, buf, capacity);
+    throw;
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+unsigned int
+CRingArray<TData, TAllocator>::size() const
+{
+  return m_size;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+unsigned int
+CRingArray<TData, TAllocator>::capacity() const
+{
+  return m_capacity;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+bool
+CRingArray<TData, TAllocator>::empty() const
+{
+  return m_size == 0;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+TData &
+CRingArray<TData, TAllocator>::operator[](
+    unsigned int _index
+  )
+{
+  assert(_index < m_size);
+
+  return m_buf[slotOf(_index)];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+const TData &
+CRingArray<TData, TAllocator>::operator[](
+    unsigned int _index
+  ) const
+{
+  assert(_index < m_size);
+
+  return m_buf[slotOf(_index)];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+TData &
+CRingArray<TData, TAllocator>::front()
+{
+  return (*this)[0];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+const TData &
+CRingArray<TData, TAllocator>::front() const
+{
+  return (*this)[0];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+TData &
+CRingArray<TData, TAllocator>::back()
+{
+  return (*this)[m_size - 1];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+const TData &
+CRingArray<TData, TAllocator>::back() const
+{
+  return (*this)[m_size - 1];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+std::pair<CArraySlice<TData>, CArraySlice<TData>>
+CRingArray<TData, TAllocator>::as_spans()
+{
+  const unsigned int firstCount = std::min(m_size, m_capacity - m_head);
+
+  return std::make_pair(CArraySlice<TData>(m_buf + m_head, firstCount),
+                        CArraySlice<TData>(m_buf, m_size - firstCount));
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+std::pair<CArrayView<TData>, CArrayView<TData>>
+CRingArray<TData, TAllocator>::as_spans() const
+{
+  const unsigned int firstCount = std::min(m_size, m_capacity - m_head);
+
+  return std::make_pair(CArrayView<TData>(m_buf + m_head, firstCount),
+                        CArrayView<TData>(m_buf, m_size - firstCount));
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CRingArray<TData, TAllocator>::iterator
+CRingArray<TData, TAllocator>::begin()
+{
+  return iterator(this, 0);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CRingArray<TData, TAllocator>::const_iterator
+CRingArray<TData, TAllocator>::begin() const
+{
+  return cbegin();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CRingArray<TData, TAllocator>::const_iterator
+CRingArray<TData, TAllocator>::cbegin() const
+{
+  return const_iterator(this, 0);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CRingArray<TData, TAllocator>::iterator
+CRingArray<TData, TAllocator>::end()
+{
+  return iterator(this, m_size);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CRingArray<TData, TAllocator>::const_iterator
+CRingArray<TData, TAllocator>::end() const
+{
+  return cend();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+typename CRingArray<TData, TAllocator>::const_iterator
+CRingArray<TData, TAllocator>::cend() const
+{
+  return const_iterator(this, m_size);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+unsigned int
+CRingArray<TData, TAllocator>::slotOf(
+    unsigned int _index
+  ) const
+{
+  return (m_head + _index) & (m_capacity - 1);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CRingArray<TData, TAllocator>::relocateTo(
+    TData *      _buf,
+    unsigned int _capacity,
+    unsigned int _firstSlot
+  )
+{
+  assert(_firstSlot + m_size <= _capacity);
+
+  // Два участка кольца: [head, конец буфера) и [0, хвост)
+  const unsigned int firstCount = std::min(m_size, m_capacity - m_head);
+  if (firstCount)
+  {
+    relocateRange(_buf + _firstSlot, m_buf + m_head, firstCount);
+  }
+  if (m_size > firstCount)
+  {
+    try
+    {
+      relocateRange(_buf + _firstSlot + firstCount, m_buf, m_size - firstCount);
+    }
+    catch (...)
+    {
+      destroyRange(_buf + _firstSlot, firstCount);
+      throw;
+    }
+  }
+
+  // Старый буфер освобождается только после успешного переноса
+  if (m_buf)
+  {
+    destroyRange(m_buf + m_head, firstCount);
+    destroyRange(m_buf, m_size - firstCount);
+    TTraits::deallocate(m_allocator, m_buf, m_capacity);
+  }
+
+  m_buf      = _buf;
+  m_capacity = _capacity;
+  m_head     = _firstSlot;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CRingArray<TData, TAllocator>::relocateRange(
+    TData *      _pTarget,
+    TData *      _pSource,
+    unsigned int _count
+  )
+{
+  if constexpr (std::is_trivially_copyable<TData>::value)
+  {
+    std::memcpy(static_cast<void *>(_pTarget), _pSource, size_t(_count) * sizeof(TData));
+  }
+  else
+  {
+    unsigned int index = 0;
+    try
+    {
+      for ( ; index < _count; ++index)
+      {
+        TTraits::construct(m_allocator, _pTarget + index, std::move_if_noexcept(_pSource[index]));
+      }
+    }
+    catch (...)
+    {
+      destroyRange(_pTarget, index);
+      throw;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CRingArray<TData, TAllocator>::destroyRange(
+    TData *      _pItems,
+    unsigned int _count
+  )
+{
+  if constexpr (!std::is_trivially_destructible<TData>::value)
+  {
+    for (unsigned int index = 0; index < _count; ++index)
+    {
+      TTraits::destroy(m_allocator, _pItems + index);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData, typename TAllocator>
+void
+CRingArray<TData, TAllocator>::destroy()
+{
+  clear();
+
+  if (m_buf)
+  {
+    TTraits::deallocate(m_allocator, m_buf, m_capacity);
+    m_buf      = nullptr;
+    m_capacity = 0;
+  }
+}
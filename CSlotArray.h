@@ -0,0 +1,475 @@
+#pragma once
+
+#include <algorithm>
+#include <utility>
+#include <cassert>
+
+#include "CArray.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// class CSlotArray - массив со стабильными дескрипторами элементов и
+// удалением за O(1).
+//
+// Элементы хранятся плотно в CArray, без пропусков, и обходятся подряд.
+// Дескриптор элемента - номер ячейки таблицы косвенности и поколение
+// ячейки; ячейка хранит текущую позицию элемента в плотном массиве.
+// Удаление переносит последний элемент на место удаленного и исправляет
+// одну ячейку, поколение удаленной ячейки увеличивается, так что старые
+// дескрипторы становятся недействительными. Освобожденные ячейки
+// используются повторно. Поиск по дескриптору - два обращения: к ячейке
+// и к элементу.
+template <typename TData>
+class CSlotArray
+{
+public: // Interface
+
+  using iterator       = typename CArray<TData>::iterator;
+  using const_iterator = typename CArray<TData>::const_iterator;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Дескриптор элемента (по умолчанию - недействительный)
+  class handle
+  {
+    friend CSlotArray;
+
+  public:
+
+    handle() = default;
+
+    bool operator==(const handle & _handle) const { return m_slot == _handle.m_slot && m_generation == _handle.m_generation; }
+    bool operator!=(const handle & _handle) const { return !(*this == _handle); }
+
+  private:
+
+    handle(
+        unsigned int _slot,
+        unsigned int _generation
+      )
+      : m_slot(_slot),
+        m_generation(_generation)
+    {
+    }
+
+    unsigned int m_slot       = ~0u;
+    unsigned int m_generation = 0;
+  };
+
+  // Конструктор по умолчанию
+  CSlotArray() = default;
+
+  // Добавить элемент, получив его дескриптор
+  handle insert(
+      const TData & _value
+    );
+
+  handle insert(
+      TData && _value
+    );
+
+  // Сконструировать элемент, получив его дескриптор
+  template <class... Args>
+  handle emplace(
+      Args&&... args
+    );
+
+  // Удалить элемент по дескриптору. Порядок остальных элементов в плотном
+  // массиве меняется: на место удаленного переносится последний.
+  // Возвращает false для недействительного дескриптора.
+  bool erase(
+      handle _handle
+    );
+
+  // Определить что дескриптор указывает на существующий элемент
+  bool contains(
+      handle _handle
+    ) const;
+
+  // Получить элемент по дескриптору (nullptr для недействительного)
+  TData * get(
+      handle _handle
+    );
+
+  const TData * get(
+      handle _handle
+    ) const;
+
+  // Получить элемент по действительному дескриптору
+  TData & operator[](
+      handle _handle
+    );
+
+  const TData & operator[](
+      handle _handle
+    ) const;
+
+  // Получить дескриптор элемента по позиции в плотном массиве
+  handle handle_of(
+      unsigned int _index
+    ) const;
+
+  // Получить позицию элемента в плотном массиве по действительному
+  // дескриптору
+  unsigned int index_of(
+      handle _handle
+    ) const;
+
+  // Удалить все элементы (все дескрипторы становятся недействительными)
+  void clear();
+
+  // Зарезервировать память под заданное количество элементов
+  void reserve(
+      unsigned int _capacity
+    );
+
+  // Получить количество элементов
+  unsigned int size() const;
+
+  // Определить что массив пустой
+  bool empty() const;
+
+  // Обход элементов в плотном массиве
+  iterator        begin();
+  const_iterator  begin()  const;
+  const_iterator  cbegin() const;
+  iterator        end();
+  const_iterator  end()    const;
+  const_iterator  cend()   const;
+
+protected:  // Методы
+
+  // Признак конца списка свободных ячеек
+  static constexpr unsigned int NoSlot = ~0u;
+
+  // Ячейка таблицы косвенности
+  struct Slot
+  {
+    unsigned int m_index;      //< Позиция элемента или следующая свободная ячейка
+    unsigned int m_generation; //< Поколение ячейки
+  };
+
+  // Зарезервировать память служебных массивов под ячейку еще одного
+  // элемента. Вызывается до добавления элемента, чтобы allocateSlot()
+  // не выделял память и не мог оставить элемент без ячейки.
+  void reserveSlot();
+
+  // Занять ячейку для элемента, добавленного в конец плотного массива
+  handle allocateSlot();
+
+  // Получить ячейку действительного дескриптора (nullptr для
+  // недействительного)
+  const Slot * slotOf(
+      handle _handle
+    ) const;
+
+protected: // Attributes
+
+  CArray<TData>        m_items;               //< Элементы подряд
+  CArray<unsigned int> m_itemSlots;           //< Ячейка каждого элемента
+  CArray<Slot>         m_slots;               //< Таблица косвенности
+  unsigned int         m_freeSlot = NoSlot;   //< Первая свободная ячейка
+};
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CSlotArray<TData>::handle
+CSlotArray<TData>::insert(
+    const TData & _value
+  )
+{
+  reserveSlot();
+  m_items.push_back(_value);
+  return allocateSlot();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CSlotArray<TData>::handle
+CSlotArray<TData>::insert(
+    TData && _value
+  )
+{
+  reserveSlot();
+  m_items.emplace_back(std::move(_value));
+  return allocateSlot();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+template <class... Args>
+typename CSlotArray<TData>::handle
+CSlotArray<TData>::emplace(
+    Args&&... args
+  )
+{
+  reserveSlot();
+  m_items.emplace_back(std::forward<Args>(args)...);
+  return allocateSlot();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+bool
+CSlotArray<TData>::erase(
+    handle _handle
+  )
+{
+  if (!slotOf(_handle))
+  {
+    return false;
+  }
+
+  Slot &             slot  = m_slots[_handle.m_slot];
+  const unsigned int index = slot.m_index;
+  const unsigned int last  = m_items.size() - 1;
+
+  if (index != last)
+  {
+    m_items[index]     = std::move(m_items[last]);
+    m_itemSlots[index] = m_itemSlots[last];
+    m_slots[m_itemSlots[index]].m_index = index;
+  }
+
+  m_items.erase(last);
+  m_itemSlots.erase(last);
+
+  ++slot.m_generation;
+  slot.m_index = m_freeSlot;
+  m_freeSlot   = _handle.m_slot;
+
+  return true;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+bool
+CSlotArray<TData>::contains(
+    handle _handle
+  ) const
+{
+  return slotOf(_handle) != nullptr;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+TData *
+CSlotArray<TData>::get(
+    handle _handle
+  )
+{
+  const Slot * pSlot = slotOf(_handle);
+  return pSlot ? &m_items[pSlot->m_index] : nullptr;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+const TData *
+CSlotArray<TData>::get(
+    handle _handle
+  ) const
+{
+  const Slot * pSlot = slotOf(_handle);
+  return pSlot ? &m_items[pSlot->m_index] : nullptr;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+TData &
+CSlotArray<TData>::operator[](
+    handle _handle
+  )
+{
+  assert(contains(_handle));
+
+  return m_items[m_slots[_handle.m_slot].m_index];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+const TData &
+CSlotArray<TData>::operator[](
+    handle _handle
+  ) const
+{
+  assert(contains(_handle));
+
+  return m_items[m_slots[_handle.m_slot].m_index];
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CSlotArray<TData>::handle
+CSlotArray<TData>::handle_of(
+    unsigned int _index
+  ) const
+{
+  assert(_index < size());
+
+  const unsigned int slotIndex = m_itemSlots[_index];
+  return handle(slotIndex, m_slots[slotIndex].m_generation);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+unsigned int
+CSlotArray<TData>::index_of(
+    handle _handle
+  ) const
+{
+  assert(contains(_handle));
+
+  return m_slots[_handle.m_slot].m_index;
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CSlotArray<TData>::clear()
+{
+  // Ячейки элементов освобождаются с новым поколением
+  const unsigned int count = m_items.size();
+  for (unsigned int index = 0; index < count; ++index)
+  {
+    const unsigned int slotIndex = m_itemSlots[index];
+    Slot &             slot      = m_slots[slotIndex];
+
+    ++slot.m_generation;
+    slot.m_index = m_freeSlot;
+    m_freeSlot   = slotIndex;
+  }
+
+  m_items.clear();
+  m_itemSlots.clear();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CSlotArray<TData>::reserve(
+    unsigned int _capacity
+  )
+{
+  m_items.reserve(_capacity);
+  m_itemSlots.reserve(_capacity);
+  m_slots.reserve(_capacity);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+unsigned int
+CSlotArray<TData>::size() const
+{
+  return m_items.size();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+bool
+CSlotArray<TData>::empty() const
+{
+  return m_items.empty();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CSlotArray<TData>::iterator
+CSlotArray<TData>::begin()
+{
+  return m_items.begin();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CSlotArray<TData>::const_iterator
+CSlotArray<TData>::begin() const
+{
+  return m_items.begin();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CSlotArray<TData>::const_iterator
+CSlotArray<TData>::cbegin() const
+{
+  return m_items.cbegin();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CSlotArray<TData>::iterator
+CSlotArray<TData>::end()
+{
+  return m_items.end();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CSlotArray<TData>::const_iterator
+CSlotArray<TData>::end() const
+{
+  return m_items.end();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CSlotArray<TData>::const_iterator
+CSlotArray<TData>::cend() const
+{
+  return m_items.cend();
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+void
+CSlotArray<TData>::reserveSlot()
+{
+  const unsigned int itemCount = m_items.size() + 1;
+  if (m_itemSlots.capacity() < itemCount)
+  {
+    m_itemSlots.reserve(std::max(m_itemSlots.capacity() * 2, itemCount));
+  }
+
+  const unsigned int slotCount = m_slots.size() + 1;
+  if (m_freeSlot == NoSlot && m_slots.capacity() < slotCount)
+  {
+    m_slots.reserve(std::max(m_slots.capacity() * 2, slotCount));
+  }
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+typename CSlotArray<TData>::handle
+CSlotArray<TData>::allocateSlot()
+{
+  const unsigned int index = m_items.size() - 1;
+
+  unsigned int slotIndex = m_freeSlot;
+  if (slotIndex != NoSlot)
+  {
+    m_freeSlot = m_slots[slotIndex].m_index;
+    m_slots[slotIndex].m_index = index;
+  }
+  else
+  {
+    slotIndex = m_slots.size();
+    m_slots.push_back(Slot{index, 0});
+  }
+
+  m_itemSlots.push_back(slotIndex);
+  return handle(slotIndex, m_slots[slotIndex].m_generation);
+}
+
+//----------------------------------------------------------------------------//
+template <typename TData>
+const typename CSlotArray<TData>::Slot *
+CSlotArray<TData>::slotOf(
+    handle _handle
+  ) const
+{
+  if (_handle.m_slot >= m_slots.size())
+  {
+    return nullptr;
+  }
+
+  const Slot & slot = m_slots[_handle.m_slot];
+  return slot.m_generation == _handle.m_generation ? &slot : nullptr;
+}
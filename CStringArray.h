@@ -0,0 +1,652 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <string>
+#include <string_view>
+#include <iterator>
+#include <vector>
+#include <cassert>
+#include <cstring>
+#include <cstddef>
+
+#include "CArray.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// class CStringArray - массив строк с символами в общей области памяти.
+//
+// Символы всех строк хранятся подряд, в порядке элементов, в одном
+// растущем буфере (арене), а массив хранит для каждой строки только
+// смещение ее конца: 8 байтов вместо 32 байтов std::string и отдельного
+// выделения для длинных строк. Смещения 64-битные, чтобы арена не была
+// ограничена 4 ГБ. Обход идет по памяти последовательно.
+// Элементы возвращаются как std::string_view и действительны до
+// следующего изменения массива.
+//
+// Вставка и удаление в середине сдвигают хвост арены и смещений
+// (как и у CArray - за линейное время), erase_if уплотняет арену за один
+// проход, сортировка упорядочивает индекс и переписывает арену в новом
+// порядке.
+class CStringArray
+{
+public: // Interface
+
+  class const_iterator;
+  using iterator = const_iterator;
+
+  // Конструктор по умолчанию
+  CStringArray() = default;
+
+  // Копирующий конструктор
+  CStringArray(
+      const CStringArray & _array
+    );
+
+  // Перемещающий конструктор
+  CStringArray(
+      CStringArray && _array
+    );
+
+  // Копирующее присваивание
+  CStringArray & operator=(
+      const CStringArray & _array
+    );
+
+  // Перемещающее присваивание
+  CStringArray & operator=(
+      CStringArray && _array
+    );
+
+  // Добавить строку в конец массива
+  void push_back(
+      std::string_view _value
+    );
+
+  // Добавить строку в массив по заданному индексу
+  void insert(
+      unsigned int     _index,
+      std::string_view _value
+    );
+
+  // Добавить все строки буфера, разделенные символом _delimiter.
+  // Пустая строка после последнего разделителя не добавляется.
+  void append(
+      std::string_view _buffer,
+      char             _delimiter = '\n'
+    );
+
+  // Удалить строку массива по заданному индексу
+  void erase(
+      unsigned int _index
+    );
+
+  // Удалить строки, удовлетворяющие условию _pred(std::string_view),
+  // за один проход. Возвращает количество удаленных.
+  template <typename TPredicate>
+  unsigned int erase_if(
+      TPredicate _pred
+    );
+
+  // Упорядочить строки по возрастанию
+  void sort();
+
+  // Освободить неиспользуемую память арены и смещений
+  void shrink_to_fit();
+
+  // Очистить массив
+  void clear();
+
+  // Зарезервировать память под _count строк и _chars символов
+  void reserve(
+      unsigned int _count,
+      size_t       _chars
+    );
+
+  // Получить размер массива
+  unsigned int size() const;
+
+  // Определить что массив пустой
+  bool empty() const;
+
+  // Получить суммарную длину строк
+  size_t charsSize() const;
+
+  // Получить объем памяти, занятой массивом, в байтах
+  size_t memoryUsage() const;
+
+  // Получить строку по заданному индексу
+  std::string_view operator[](
+      unsigned int _index
+    ) const;
+
+  const_iterator begin()  const;
+  const_iterator cbegin() const;
+  const_iterator end()    const;
+  const_iterator cend()   const;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Итератор по строкам массива
+  class const_iterator
+  {
+  public:
+
+    // iterator traits
+    using difference_type   = int;
+    using value_type        = std::string_view;
+    using pointer           = void;
+    using reference         = std::string_view;
+    using iterator_category = std::random_access_iterator_tag;
+
+    const_iterator() = default;
+
+    const_iterator(
+        const CStringArray * _array,
+        unsigned int         _index
+      )
+      : m_array(_array),
+        m_index(_index)
+    {
+    }
+
+    std::string_view operator*() const                 { return (*m_array)[m_index]; }
+    std::string_view operator[](int _offset) const     { return (*m_array)[m_index + _offset]; }
+
+    const_iterator & operator++()    { ++m_index; return *this; }
+    const_iterator & operator--()    { --m_index; return *this; }
+    const_iterator   operator++(int) { const_iterator tmp(*this); ++m_index; return tmp; }
+    const_iterator   operator--(int) { const_iterator tmp(*this); --m_index; return tmp; }
+
+    const_iterator & operator+=(int _offset)      { m_index += _offset; return *this; }
+    const_iterator & operator-=(int _offset)      { m_index -= _offset; return *this; }
+    const_iterator   operator+(int _offset) const { return const_iterator(m_array, m_index + _offset); }
+    const_iterator   operator-(int _offset) const { return const_iterator(m_array, m_index - _offset); }
+
+    friend const_iterator operator+(int _offset, const const_iterator & _it) { return _it + _offset; }
+
+    int operator-(const const_iterator & _it) const { return static_cast<int>(m_index - _it.m_index); }
+
+    bool operator==(const const_iterator & _it) const { return m_index == _it.m_index; }
+    bool operator!=(const const_iterator & _it) const { return m_index != _it.m_index; }
+    bool operator< (const const_iterator & _it) const { return m_index <  _it.m_index; }
+    bool operator> (const const_iterator & _it) const { return m_index >  _it.m_index; }
+    bool operator<=(const const_iterator & _it) const { return m_index <= _it.m_index; }
+    bool operator>=(const const_iterator & _it) const { return m_index >= _it.m_index; }
+
+  private:
+
+    const CStringArray * m_array = nullptr;
+    unsigned int         m_index = 0;
+  };
+
+protected:  // Методы
+
+  // Получить смещение начала строки
+  size_t startOf(
+      unsigned int _index
+    ) const;
+
+  // Определить что символы _value лежат в арене
+  bool containsChars(
+      std::string_view _value
+    ) const;
+
+  // Обеспечить место под _chars символов в конце арены
+  void reserveChars(
+      size_t _chars
+    );
+
+  // Заменить арену буфером на _capacity символов с текущим содержимым
+  void reallocateChars(
+      size_t _capacity
+    );
+
+  // Прибавить _delta к смещениям концов строк, начиная с _indexFrom
+  void shiftEnds(
+      unsigned int _indexFrom,
+      ptrdiff_t    _delta
+    );
+
+protected: // Attributes
+
+  CArray<size_t>          m_ends;                 //< Смещения концов строк в арене
+  std::unique_ptr<char[]> m_chars;                //< Арена символов
+  size_t                  m_charsSize     = 0;
+  size_t                  m_charsCapacity = 0;
+};
+
+//----------------------------------------------------------------------------//
+inline
+CStringArray::CStringArray(
+    const CStringArray & _array
+  )
+{
+  reserve(_array.size(), _array.m_charsSize);
+  for (std::string_view value : _array)
+  {
+    push_back(value);
+  }
+}
+
+//----------------------------------------------------------------------------//
+inline
+CStringArray::CStringArray(
+    CStringArray && _array
+  )
+  : m_ends         (std::move(_array.m_ends)),
+    m_chars        (std::move(_array.m_chars)),
+    m_charsSize    (std::exchange(_array.m_charsSize, 0)),
+    m_charsCapacity(std::exchange(_array.m_charsCapacity, 0))
+{
+}
+
+//----------------------------------------------------------------------------//
+inline CStringArray &
+CStringArray::operator=(
+    const CStringArray & _array
+  )
+{
+  if (this != &_array)
+  {
+    CStringArray tmp(_array);
+    *this = std::move(tmp);
+  }
+
+  return *this;
+}
+
+//----------------------------------------------------------------------------//
+inline CStringArray &
+CStringArray::operator=(
+    CStringArray && _array
+  )
+{
+  if (this != &_array)
+  {
+    m_ends          = std::move(_array.m_ends);
+    m_chars         = std::move(_array.m_chars);
+    m_charsSize     = std::exchange(_array.m_charsSize, 0);
+    m_charsCapacity = std::exchange(_array.m_charsCapacity, 0);
+  }
+
+  return *this;
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CStringArray::push_back(
+    std::string_view _value
+  )
+{
+  if (containsChars(_value))
+  {
+    // Строка - часть арены, которая может быть перевыделена
+    const std::string valueCopy(_value);
+    push_back(valueCopy);
+    return;
+  }
+
+  reserveChars(_value.size());
+
+  if (!_value.empty())
+  {
+    std::memcpy(m_chars.get() + m_charsSize, _value.data(), _value.size());
+  }
+  m_charsSize += _value.size();
+
+  m_ends.push_back(m_charsSize);
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CStringArray::insert(
+    unsigned int     _index,
+    std::string_view _value
+  )
+{
+  assert(_index <= size());
+
+  if (_index == size())
+  {
+    push_back(_value);
+    return;
+  }
+
+  if (containsChars(_value))
+  {
+    // Строка - часть арены, при сдвиге она переместится, поэтому
+    // вставляем копию
+    const std::string valueCopy(_value);
+    insert(_index, valueCopy);
+    return;
+  }
+
+  reserveChars(_value.size());
+
+  const size_t       start = startOf(_index);
+  char * const       chars = m_chars.get();
+
+  if (!_value.empty())
+  {
+    std::memmove(chars + start + _value.size(), chars + start, m_charsSize - start);
+    std::memcpy(chars + start, _value.data(), _value.size());
+  }
+  m_charsSize += _value.size();
+
+  m_ends.insert(_index, start + _value.size());
+  shiftEnds(_index + 1, static_cast<ptrdiff_t>(_value.size()));
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CStringArray::append(
+    std::string_view _buffer,
+    char             _delimiter
+  )
+{
+  if (containsChars(_buffer))
+  {
+    // Буфер - часть арены, которая может быть перевыделена
+    const std::string bufferCopy(_buffer);
+    append(bufferCopy, _delimiter);
+    return;
+  }
+
+  // Разделители в арену не копируются, так что места хватит заранее
+  reserveChars(_buffer.size());
+
+  size_t from = 0;
+  while (from < _buffer.size())
+  {
+    size_t to = _buffer.find(_delimiter, from);
+    if (to == std::string_view::npos)
+    {
+      to = _buffer.size();
+    }
+
+    push_back(_buffer.substr(from, to - from));
+    from = to + 1;
+  }
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CStringArray::erase(
+    unsigned int _index
+  )
+{
+  assert(_index < size());
+
+  const size_t       start = startOf(_index);
+  const size_t       end   = m_ends[_index];
+  char * const       chars = m_chars.get();
+
+  if (end > start)
+  {
+    std::memmove(chars + start, chars + end, m_charsSize - end);
+    m_charsSize -= end - start;
+  }
+
+  m_ends.erase(_index);
+  shiftEnds(_index, -static_cast<ptrdiff_t>(end - start));
+}
+
+//----------------------------------------------------------------------------//
+template <typename TPredicate>
+unsigned int
+CStringArray::erase_if(
+    TPredicate _pred
+  )
+{
+  const unsigned int count = size();
+  if (count == 0)
+  {
+    return 0;
+  }
+
+  // Сохраняемые строки сдвигаются к началу арены вместе с их смещениями
+  char * const         chars   = m_chars.get();
+  size_t * const       ends    = &m_ends[0];
+  size_t               charsTo = 0;
+  unsigned int         kept    = 0;
+  size_t               start   = 0;
+
+  for (unsigned int index = 0; index < count; ++index)
+  {
+    const size_t end = ends[index];
+    if (!_pred(std::string_view(chars + start, end - start)))
+    {
+      if (charsTo != start && end > start)
+      {
+        std::memmove(chars + charsTo, chars + start, end - start);
+      }
+      charsTo     += end - start;
+      ends[kept++] = charsTo;
+    }
+    start = end;
+  }
+
+  if (kept < count)
+  {
+    m_ends.erase(m_ends.begin() + kept, m_ends.end());
+  }
+  m_charsSize = charsTo;
+
+  return count - kept;
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CStringArray::sort()
+{
+  const unsigned int count = size();
+  if (count < 2)
+  {
+    return;
+  }
+
+  std::vector<std::string_view> values(begin(), end());
+  std::vector<unsigned int>     order(count);
+
+  if (count >= CArrayRadixMinCount)
+  {
+    CArrayStringSorter<std::string_view>::sortedOrder(values.data(), count, order.data());
+  }
+  else
+  {
+    for (unsigned int index = 0; index < count; ++index)
+    {
+      order[index] = index;
+    }
+    std::sort(order.begin(), order.end(),
+              [&values](unsigned int _left, unsigned int _right) { return values[_left] < values[_right]; });
+  }
+
+  // Арена переписывается в новом порядке за один проход
+  std::unique_ptr<char[]> chars(new char[m_charsCapacity]);
+  size_t * const          ends      = &m_ends[0];
+  size_t                  charsSize = 0;
+
+  for (unsigned int position = 0; position < count; ++position)
+  {
+    const std::string_view value = values[order[position]];
+    if (!value.empty())
+    {
+      std::memcpy(chars.get() + charsSize, value.data(), value.size());
+    }
+    charsSize      += value.size();
+    ends[position]  = charsSize;
+  }
+
+  m_chars = std::move(chars);
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CStringArray::shrink_to_fit()
+{
+  if (m_charsCapacity > m_charsSize)
+  {
+    reallocateChars(m_charsSize);
+  }
+
+  if (m_ends.capacity() > m_ends.size())
+  {
+    CArray<size_t> ends(m_ends);
+    m_ends = std::move(ends);
+  }
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CStringArray::clear()
+{
+  m_ends.clear();
+  m_charsSize = 0;
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CStringArray::reserve(
+    unsigned int _count,
+    size_t       _chars
+  )
+{
+  m_ends.reserve(_count);
+  if (_chars > m_charsCapacity)
+  {
+    reallocateChars(_chars);
+  }
+}
+
+//----------------------------------------------------------------------------//
+inline unsigned int
+CStringArray::size() const
+{
+  return m_ends.size();
+}
+
+//----------------------------------------------------------------------------//
+inline bool
+CStringArray::empty() const
+{
+  return m_ends.empty();
+}
+
+//----------------------------------------------------------------------------//
+inline size_t
+CStringArray::charsSize() const
+{
+  return m_charsSize;
+}
+
+//----------------------------------------------------------------------------//
+inline size_t
+CStringArray::memoryUsage() const
+{
+  return sizeof(CStringArray) + static_cast<size_t>(m_ends.capacity()) * sizeof(size_t) + m_charsCapacity;
+}
+
+//----------------------------------------------------------------------------//
+inline std::string_view
+CStringArray::operator[](
+    unsigned int _index
+  ) const
+{
+  const size_t       start = startOf(_index);
+  return std::string_view(m_chars.get() + start, m_ends[_index] - start);
+}
+
+//----------------------------------------------------------------------------//
+inline CStringArray::const_iterator
+CStringArray::begin() const
+{
+  return cbegin();
+}
+
+//----------------------------------------------------------------------------//
+inline CStringArray::const_iterator
+CStringArray::cbegin() const
+{
+  return const_iterator(this, 0);
+}
+
+//----------------------------------------------------------------------------//
+inline CStringArray::const_iterator
+CStringArray::end() const
+{
+  return cend();
+}
+
+//----------------------------------------------------------------------------//
+inline CStringArray::const_iterator
+CStringArray::cend() const
+{
+  return const_iterator(this, size());
+}
+
+//----------------------------------------------------------------------------//
+inline size_t
+CStringArray::startOf(
+    unsigned int _index
+  ) const
+{
+  return _index ? m_ends[_index - 1] : 0;
+}
+
+//----------------------------------------------------------------------------//
+inline bool
+CStringArray::containsChars(
+    std::string_view _value
+  ) const
+{
+  const char * const chars = m_chars.get();
+  return !_value.empty() && chars && chars <= _value.data() && _value.data() < chars + m_charsCapacity;
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CStringArray::reserveChars(
+    size_t _chars
+  )
+{
+  if (m_charsSize + _chars > m_charsCapacity)
+  {
+    reallocateChars(std::max(m_charsSize + _chars, m_charsCapacity * 2));
+  }
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CStringArray::reallocateChars(
+    size_t _capacity
+  )
+{
+  std::unique_ptr<char[]> chars(_capacity ? new char[_capacity] : nullptr);
+  if (m_charsSize)
+  {
+    std::memcpy(chars.get(), m_chars.get(), m_charsSize);
+  }
+
+  m_chars         = std::move(chars);
+  m_charsCapacity = _capacity;
+}
+
+//----------------------------------------------------------------------------//
+inline void
+CStringArray::shiftEnds(
+    unsigned int _indexFrom,
+    ptrdiff_t    _delta
+  )
+{
+  const unsigned int count = m_ends.size();
+  if (_indexFrom >= count || _delta == 0)
+  {
+    return;
+  }
+
+  size_t * const ends = &m_ends[0];
+  for (unsigned int index = _indexFrom; index < count; ++index)
+  {
+    ends[index] += _delta;
+  }
+}